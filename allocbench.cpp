@@ -0,0 +1,212 @@
+/**
+ * @file allocbench.cpp
+ * @brief Allocazioni di memoria per ordinamento, ricerca e salvataggio
+ *
+ * @details
+ * Conta le allocazioni dell'heap fatte da ogni operazione su una rubrica
+ * sintetica, confrontando dove serve il codice di prima con quello attuale:
+ * - ordinamento: il vecchio confronto con due toLower() per chiamata, il
+ *   confronto attuale di Contact (QString::compare senza distinzione di
+ *   maiuscole) e ContactStore::sort, che ordina gli indici delle righe
+ * - ricerca: la vecchia scansione con toUpper() dei tre campi di ogni
+ *   contatto e SearchIndex::find sulla query già analizzata
+ * - salvataggio: ContactList::saveStore
+ *
+ * Gli accessori che restituivano QString per valore non compaiono come "prima":
+ * la copia di una QString condivisa incrementa un contatore e non alloca.
+ *
+ * Su glibc il programma sostituisce malloc/free, così conta anche le QString
+ * (QArrayData usa malloc direttamente); altrove conta solo operator new.
+ *
+ * Esempio:
+ * @code
+ * RubricaAllocBench --contacts 100000
+ * @endcode
+ */
+
+#include "contactstore.hpp"
+#include "list.hpp"
+#include "searchindex.hpp"
+#include "searchquery.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_allocbench_namespace {
+
+std::atomic<quint64> allocations{0}; /**< Allocazioni dall'avvio del programma */
+
+/**
+ * @brief Rubrica sintetica, come quella di RubricaSearchBench
+ */
+QVector<Contact> makeBook(int count)
+{
+    static const QStringList kNames{"Mario", "Anna", "Luca", "Giulia", "Paolo", "Chiara", "Marco", "Sara", "Ugo", "Zeno"};
+    static const QStringList kSurnames{"Rossi", "Bianchi", "De Luca", "Verdi", "Ferrari", "Russo", "Esposito", "Romano"};
+    static const QStringList kDomains{"gmail.com", "libero.it", "outlook.com", "azienda.it"};
+
+    std::mt19937 random(1);
+    QVector<Contact> contacts;
+    contacts.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString name = QString("%1 %2 %3")
+                                 .arg(kNames[random() % kNames.size()], kSurnames[random() % kSurnames.size()])
+                                 .arg(random() % 1000);
+        const QString phone = QString("3%1").arg(random() % 1000000000u, 9, 10, QChar(u'0'));
+        const QString email = random() % 3 == 0
+                                  ? QString()
+                                  : QString("utente%1@%2").arg(i).arg(kDomains[random() % kDomains.size()]);
+        contacts.append(Contact(name, phone, email));
+    }
+    return contacts;
+}
+
+/**
+ * @brief Allocazioni fatte da work
+ */
+template<typename Work>
+quint64 count(Work work)
+{
+    const quint64 before = allocations.load(std::memory_order_relaxed);
+    work();
+    return allocations.load(std::memory_order_relaxed) - before;
+}
+
+} // namespace m_allocbench_namespace
+
+#if defined(__GLIBC__)
+// glibc permette di sostituire malloc nell'eseguibile: operator new e QArrayData passano tutti da qui
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size)
+{
+    m_allocbench_namespace::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    m_allocbench_namespace::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    m_allocbench_namespace::allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+}
+#else
+void *operator new(size_t size)
+{
+    m_allocbench_namespace::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    using namespace m_allocbench_namespace;
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RubricaAllocBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Conta le allocazioni di ordinamento, ricerca e salvataggio");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"contacts", "Contatti della rubrica.", "n", "100000"},
+        {"query", "Testo cercato.", "testo", "rossi"},
+    });
+    parser.process(app);
+    const int contactCount = std::max(1, parser.value("contacts").toInt());
+    const QString query = parser.value("query");
+
+    const QVector<Contact> contacts = makeBook(contactCount);
+    QTextStream out(stdout);
+    out << QString("%1 contatti\n\n").arg(contactCount);
+    const auto report = [&out, contactCount](const char *label, quint64 counted) {
+        out << QString("%1 %2 %3\n")
+                   .arg(label, -28)
+                   .arg(qint64(counted), 10)
+                   .arg(double(counted) / contactCount, 10, 'f', 2);
+    };
+    out << QString("%1 %2 %3\n").arg("operazione", -28).arg("allocazioni", 10).arg("per contatto", 10);
+
+    // ordinamento: la copia della rubrica è fuori dal conteggio
+    QVector<Contact> copy = contacts;
+    copy.detach();
+    report("ordinamento, prima", count([&copy]() {
+               std::stable_sort(copy.begin(), copy.end(), [](const Contact &a, const Contact &b) {
+                   return a.name().toLower() < b.name().toLower();
+               });
+           }));
+    copy = contacts;
+    copy.detach();
+    report("ordinamento, dopo", count([&copy]() { std::stable_sort(copy.begin(), copy.end()); }));
+
+    ContactStore store;
+    store.reserve(contactCount);
+    for (const Contact &contact : contacts)
+        store.append(contact);
+    report("ContactStore::sort", count([&store]() { store.sort(); }));
+
+    // ricerca
+    qsizetype scanned = 0;
+    report("ricerca, prima", count([&]() {
+               const QString searchStr = query.toUpper();
+               for (const Contact &contact : contacts) {
+                   if (contact.name().toUpper().contains(searchStr) || contact.email().toUpper().contains(searchStr)
+                       || contact.phone().toUpper().contains(searchStr))
+                       scanned++;
+               }
+           }));
+    SearchIndex index;
+    ContactList::indexStore(store, index);
+    const SearchQuery parsed = SearchQuery::parse(query);
+    qsizetype indexed = 0;
+    report("SearchIndex::find", count([&]() { indexed = index.find(parsed).size(); }));
+
+    // salvataggio
+    const QString path = QDir::temp().filePath("rubrica-allocbench.csv");
+    bool saved = false;
+    report("ContactList::saveStore", count([&]() { saved = ContactList::saveStore(store, path); }));
+    QFile::remove(path);
+
+    if (scanned != indexed || !saved) {
+        out << QString("\nrisultati diversi (%1 e %2) o salvataggio fallito\n").arg(scanned).arg(indexed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file autosaver.cpp
+ * @brief AutoSaver class implementation
+ */
+
+#include "autosaver.hpp"
+#include "profiler.hpp"
+#include <QElapsedTimer>
+#include <QFile>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_autosaver_namespace {
+
+/**
+ * @brief Scrive la rubrica, copiando prima il file esistente se richiesto
+ * @param[in] backupPath Copia da fare prima della scrittura, vuoto per nessuna
+ * @param[in,out] backupDone true se la copia è già stata fatta
+ * @retval false Copia o scrittura non riuscite (senza copia il file resta intatto)
+ * @details Le scritture non si sovrappongono mai: la copia si fa una volta sola.
+ */
+bool save(const ContactStore &store, const QString &filePath, const QString &backupPath,
+          std::atomic<bool> *backupDone, qint64 *bytes)
+{
+    if (!backupPath.isEmpty() && !*backupDone && QFile::exists(filePath)) {
+        QFile::remove(backupPath);
+        if (!QFile::copy(filePath, backupPath))
+            return false;
+    }
+    *backupDone = true;
+    return ContactList::saveStore(store, filePath, bytes);
+}
+
+} // namespace m_autosaver_namespace
+
+AutoSaver::AutoSaver(ContactList *list, const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_list(list)
+    , m_filePath(filePath)
+{
+    m_idleTimer.setSingleShot(true);
+    m_maxTimer.setSingleShot(true);
+    setDelays(kDefaultIdleDelay, kDefaultMaxDelay);
+    m_pool.setMaxThreadCount(1);
+
+    connect(&m_idleTimer, &QTimer::timeout, this, &AutoSaver::startSave);
+    connect(&m_maxTimer, &QTimer::timeout, this, &AutoSaver::startSave);
+    connect(m_list, &ContactList::dataChanged, this, &AutoSaver::onDataChanged);
+}
+
+AutoSaver::~AutoSaver()
+{
+    // il task usa this per notificare il risultato: deve finire prima
+    m_pool.waitForDone();
+}
+
+void AutoSaver::setDelays(int idleDelay, int maxDelay)
+{
+    m_idleTimer.setInterval(idleDelay);
+    m_maxTimer.setInterval(maxDelay);
+}
+
+void AutoSaver::saveNow()
+{
+    startSave();
+}
+
+void AutoSaver::setBackupPath(const QString &backupPath)
+{
+    m_pool.waitForDone(); // il percorso è letto dal task in corso
+    m_backupPath = backupPath;
+    m_backupDone = false;
+}
+
+bool AutoSaver::flush()
+{
+    m_idleTimer.stop();
+    m_maxTimer.stop();
+    m_pool.waitForDone();
+    // il risultato del task appena finito è ancora in coda: da qui in poi viene ignorato
+    m_saving = false;
+    m_pending = false;
+    if (!m_list->isModified())
+        return true;
+
+    const Profiler::Scope scope("AutoSaver::save");
+    const ContactList::Snapshot snapshot = m_list->snapshot();
+    const quint64 revision = m_list->revision();
+    QElapsedTimer timer;
+    timer.start();
+    qint64 bytes = 0;
+    const bool ok = m_autosaver_namespace::save(*snapshot, m_filePath, m_backupPath, &m_backupDone, &bytes);
+    recordSave(snapshot, revision, ok, bytes, timer.nsecsElapsed());
+    return ok;
+}
+
+void AutoSaver::onDataChanged()
+{
+    // ogni modifica sposta in avanti il salvataggio, ma non oltre maxDelay dalla prima
+    m_idleTimer.start();
+    if (!m_maxTimer.isActive())
+        m_maxTimer.start();
+}
+
+void AutoSaver::startSave()
+{
+    m_idleTimer.stop();
+    m_maxTimer.stop();
+
+    if (m_saving) {
+        m_pending = true;
+        return;
+    }
+    if (!m_list->isModified()) {
+        m_stats.skipped++;
+        return;
+    }
+
+    // snapshot e versione letti insieme nel thread della lista: sono coerenti
+    const ContactList::Snapshot snapshot = m_list->snapshot();
+    const quint64 revision = m_list->revision();
+    const QString filePath = m_filePath;
+    const QString backupPath = m_backupPath;
+    m_saving = true;
+
+    m_pool.start([this, snapshot, revision, filePath, backupPath]() {
+        const Profiler::Scope scope("AutoSaver::save");
+        QElapsedTimer timer;
+        timer.start();
+        qint64 bytes = 0;
+        const bool ok = m_autosaver_namespace::save(*snapshot, filePath, backupPath, &m_backupDone, &bytes);
+        const qint64 duration = timer.nsecsElapsed();
+        QMetaObject::invokeMethod(
+            this,
+            [this, snapshot, revision, ok, bytes, duration]() { finishSave(snapshot, revision, ok, bytes, duration); },
+            Qt::QueuedConnection);
+    });
+}
+
+void AutoSaver::finishSave(const ContactList::Snapshot &snapshot, quint64 revision, bool ok, qint64 bytes,
+                           qint64 duration)
+{
+    if (!m_saving)
+        return; // risultato superato da flush()
+
+    m_saving = false;
+    recordSave(snapshot, revision, ok, bytes, duration);
+
+    // modifiche arrivate durante la scrittura: un altro giro, senza aspettare di nuovo
+    if (m_pending) {
+        m_pending = false;
+        startSave();
+    }
+}
+
+void AutoSaver::recordSave(const ContactList::Snapshot &snapshot, quint64 revision, bool ok, qint64 bytes,
+                           qint64 duration)
+{
+    if (ok) {
+        m_list->markSaved(revision);
+        m_lastSaved = snapshot;
+        m_stats.saves++;
+        m_stats.bytesWritten += bytes;
+        m_stats.lastBytes = bytes;
+        m_stats.lastDuration = duration;
+    } else {
+        m_stats.failures++;
+    }
+    emit saved(ok);
+}
@@ -0,0 +1,165 @@
+/**
+ * @file autosaver.hpp
+ * @brief Salvataggio automatico della rubrica in background
+ *
+ * @details
+ * Invece di riscrivere il CSV a ogni modifica, le modifiche ravvicinate vengono
+ * raggruppate: si salva quando la rubrica resta ferma per idleDelay, oppure
+ * comunque dopo maxDelay se le modifiche non si fermano mai.
+ * La scrittura avviene su uno snapshot (vedi ContactList::snapshot) in un thread
+ * dedicato, quindi la GUI non aspetta mai il disco.
+ */
+
+#ifndef AUTOSAVER_HPP
+#define AUTOSAVER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <utility>
+#include "list.hpp"
+
+/**
+ * @class AutoSaver
+ * @brief Salvataggio automatico con raggruppamento delle modifiche
+ *
+ * @details
+ * - Una sola scrittura alla volta: se la rubrica cambia durante un salvataggio,
+ *   ne parte un altro appena finito
+ * - Se la versione su file è già quella attuale il salvataggio viene saltato
+ * - Con setBackupPath la prima scrittura è preceduta da una copia del file
+ *   esistente; se la copia non riesce il file non viene riscritto
+ * - La durata di ogni scrittura finisce nel Profiler ("AutoSaver::save"),
+ *   i byte scritti nelle statistiche di stats()
+ *
+ * Va creato, usato e distrutto nel thread della lista (la GUI).
+ */
+class AutoSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultIdleDelay = 2000; /**< Attesa predefinita dopo l'ultima modifica (ms) */
+    static constexpr int kDefaultMaxDelay = 30000; /**< Attesa massima predefinita dalla prima modifica (ms) */
+
+    /**
+     * @brief Statistiche dei salvataggi automatici
+     */
+    struct Stats
+    {
+        quint64 saves = 0;        /**< Salvataggi completati */
+        quint64 skipped = 0;      /**< Salvataggi saltati perché non c'era nulla da scrivere */
+        quint64 failures = 0;     /**< Salvataggi falliti */
+        qint64 bytesWritten = 0;  /**< Byte scritti in totale */
+        qint64 lastBytes = 0;     /**< Byte dell'ultimo salvataggio */
+        qint64 lastDuration = 0;  /**< Durata dell'ultimo salvataggio, in nanosecondi */
+    };
+
+    /**
+     * @brief Costruttore
+     * @param[in] list Lista da salvare (deve sopravvivere all'AutoSaver)
+     * @param[in] filePath File in cui salvare
+     * @param[in] parent Oggetto padre nella gerarchia Qt (opzionale)
+     */
+    AutoSaver(ContactList *list, const QString &filePath, QObject *parent = nullptr);
+
+    /**
+     * @brief Distruttore
+     * @details Aspetta la fine dell'eventuale salvataggio in corso, non ne avvia altri:
+     * per salvare le ultime modifiche chiamare flush().
+     */
+    ~AutoSaver();
+
+    /**
+     * @brief Imposta le attese prima del salvataggio
+     * @param[in] idleDelay Millisecondi senza modifiche dopo cui salvare
+     * @param[in] maxDelay Millisecondi massimi dalla prima modifica non salvata
+     */
+    void setDelays(int idleDelay, int maxDelay);
+
+    /**
+     * @brief Salva subito, in background, se ci sono modifiche
+     */
+    void saveNow();
+
+    /**
+     * @brief Chiede una copia del file prima della prossima scrittura
+     * @param[in] backupPath File in cui copiare il file attuale (sostituito se esiste)
+     * @details La copia si fa una sola volta, prima della prima scrittura
+     * (es. il file caricato conteneva righe non valide e l'utente deve poterle
+     * ritrovare com'erano). Se il file non esiste non c'è nulla da copiare.
+     */
+    void setBackupPath(const QString &backupPath);
+
+    /**
+     * @brief Salva in modo sincrono le modifiche rimaste (es. alla chiusura)
+     * @retval true File aggiornato o nessuna modifica da salvare
+     * @retval false Errore nel salvataggio
+     * @details Aspetta l'eventuale salvataggio in corso e, se la lista è ancora
+     * modificata, la scrive nel thread chiamante.
+     */
+    bool flush();
+
+    /**
+     * @brief Statistiche dei salvataggi
+     */
+    Stats stats() const { return m_stats; }
+
+    /**
+     * @brief Consegna il contenuto dell'ultimo salvataggio riuscito
+     * @return Snapshot scritto nel file, nullo se non ce n'è uno da consegnare
+     * @details Da chiamare quando arriva saved(true): è la versione che ora si trova su disco.
+     * L'AutoSaver non lo conserva: uno snapshot tenuto a lungo costringerebbe la prima
+     * modifica dopo ogni salvataggio a copiare le colonne che tocca.
+     */
+    ContactList::Snapshot takeLastSaved() { return std::exchange(m_lastSaved, nullptr); }
+
+signals:
+    /**
+     * @brief Emesso al termine di ogni salvataggio
+     * @param[in] ok true se il file è stato scritto
+     */
+    void saved(bool ok);
+
+private:
+    ContactList *m_list;      /**< Lista salvata */
+    QString m_filePath;       /**< File di destinazione */
+    QString m_backupPath;     /**< Copia del file da fare prima della prima scrittura (vuoto = nessuna) */
+    std::atomic<bool> m_backupDone{true}; /**< true se la copia è già stata fatta (scritto dal task) */
+    QTimer m_idleTimer;       /**< Riparte a ogni modifica */
+    QTimer m_maxTimer;        /**< Parte alla prima modifica non salvata, non riparte */
+    QThreadPool m_pool;       /**< Un solo thread: le scritture non si sovrappongono mai */
+    bool m_saving = false;    /**< true mentre un salvataggio è in corso */
+    bool m_pending = false;   /**< true se la lista è cambiata durante il salvataggio */
+    Stats m_stats;            /**< Statistiche dei salvataggi */
+    ContactList::Snapshot m_lastSaved; /**< Ultimo snapshot scritto nel file, finché non viene consegnato */
+
+    /**
+     * @brief Avvia o prolunga le attese dopo una modifica
+     */
+    void onDataChanged();
+
+    /**
+     * @brief Avvia la scrittura dello snapshot attuale nel thread del pool
+     */
+    void startSave();
+
+    /**
+     * @brief Registra il risultato di una scrittura (nel thread della lista)
+     * @param[in] snapshot Contenuto scritto
+     * @param[in] revision Versione scritta
+     * @param[in] ok true se il file è stato scritto
+     * @param[in] bytes Byte scritti
+     * @param[in] duration Durata della scrittura in nanosecondi
+     */
+    void finishSave(const ContactList::Snapshot &snapshot, quint64 revision, bool ok, qint64 bytes, qint64 duration);
+
+    /**
+     * @brief Aggiorna versione salvata e statistiche, poi emette saved()
+     */
+    void recordSave(const ContactList::Snapshot &snapshot, quint64 revision, bool ok, qint64 bytes, qint64 duration);
+};
+
+#endif // AUTOSAVER_HPP
@@ -0,0 +1,114 @@
+/**
+ * @file bookset.cpp
+ * @brief BookSet class implementation
+ */
+
+#include "bookset.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "searchindex.hpp"
+#include "searchquery.hpp"
+#include <QFileInfo>
+#include <algorithm>
+#include <vector>
+
+BookSet::BookSet(QObject *parent)
+    : QObject(parent)
+{}
+
+qsizetype BookSet::addBook(ContactList *list, const QString &name)
+{
+    m_books.append(Book{name, QString(), list});
+    return m_books.size() - 1;
+}
+
+qsizetype BookSet::openFiles(const QStringList &filePaths, QStringList *failed)
+{
+    const Profiler::Scope scope("BookSet::openFiles");
+    QStringList paths;
+    for (const QString &filePath : filePaths) {
+        const QString path = QFileInfo(filePath).absoluteFilePath();
+        const bool open = std::any_of(m_books.cbegin(), m_books.cend(),
+                                      [&path](const Book &book) { return book.filePath == path; });
+        if (!open && !paths.contains(path))
+            paths.append(path);
+    }
+
+    // un file per thread: lettura, validazione e ordinamento non toccano nessuna lista
+    std::vector<ContactStore> stores(size_t(paths.size()));
+    std::vector<char> loaded(size_t(paths.size()), 0);
+    parallelFor(paths.size(), 1, [&](qsizetype, qsizetype begin, qsizetype end) {
+        for (qsizetype i = begin; i < end; ++i) {
+            QVector<Contact> contacts;
+            if (!ContactList::readFile(paths[i], contacts))
+                continue;
+            stores[size_t(i)] = ContactList::makeStore(std::move(contacts));
+            loaded[size_t(i)] = 1;
+        }
+    });
+
+    // le liste nascono nel thread del BookSet: ricevono solo l'archivio già pronto (O(1))
+    qsizetype opened = 0;
+    for (qsizetype i = 0; i < paths.size(); ++i) {
+        if (!loaded[size_t(i)]) {
+            if (failed)
+                failed->append(paths[i]);
+            continue;
+        }
+        auto *list = new ContactList(this);
+        list->replaceStore(std::move(stores[size_t(i)]));
+        list->clearHistory();
+        list->markSaved(list->revision());
+        m_books.append(Book{QFileInfo(paths[i]).fileName(), paths[i], list});
+        opened++;
+    }
+    return opened;
+}
+
+QVector<BookSet::Result> BookSet::search(const QString &query, int limit) const
+{
+    const Profiler::Scope scope("BookSet::search");
+
+    // l'indice e la cache di una lista cambiano a ogni ricerca: nei thread si leggono
+    // solo snapshot (presi qui, O(1)), ognuno con un indice suo, come in LookupServer
+    std::vector<ContactList::Snapshot> snapshots;
+    snapshots.reserve(size_t(m_books.size()));
+    for (const Book &book : m_books)
+        snapshots.push_back(book.list->snapshot());
+    const SearchQuery parsed = SearchQuery::parse(query);
+
+    std::vector<QVector<Contact>> found(size_t(m_books.size()));
+    parallelFor(m_books.size(), 1, [&](qsizetype, qsizetype begin, qsizetype end) {
+        for (qsizetype b = begin; b < end; ++b) {
+            const ContactStore &store = *snapshots[size_t(b)];
+            SearchIndex index;
+            ContactList::indexStore(store, index);
+            SearchIndex::Cursor cursor = index.open(parsed);
+            const QVector<int> indices = index.fetch(cursor, limit);
+            QVector<Contact> &contacts = found[size_t(b)];
+            contacts.reserve(indices.size());
+            for (const int row : indices)
+                contacts.append(store.contact(row));
+        }
+    });
+
+    // unione dei risultati, già in ordine di nome in ogni rubrica
+    QVector<Result> results;
+    QVector<QString> keys;
+    for (qsizetype b = 0; b < m_books.size(); ++b) {
+        for (Contact &contact : found[size_t(b)]) {
+            keys.append(ContactStore::sortKey(contact.name()));
+            results.append(Result{b, std::move(contact)});
+        }
+    }
+    QVector<int> order(results.size());
+    for (qsizetype i = 0; i < order.size(); ++i)
+        order[i] = int(i);
+    std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+    QVector<Result> merged;
+    merged.reserve(std::min<qsizetype>(limit, order.size()));
+    for (qsizetype i = 0; i < order.size() && merged.size() < limit; ++i)
+        merged.append(std::move(results[order[i]]));
+    return merged;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file bookset.hpp
+ * @brief Più rubriche aperte insieme, con ricerca federata
+ *
+ * @details
+ * Oltre alla rubrica principale si possono aprire altre rubriche (es. una per
+ * reparto). Ogni file viene letto, validato e ordinato in un thread proprio;
+ * la ricerca viene eseguita su tutte le rubriche in parallelo e i risultati
+ * vengono uniti in ordine di nome, ognuno con la rubrica da cui proviene.
+ * Il tempo di una ricerca è quindi vicino a quello della rubrica più lenta,
+ * non alla somma.
+ */
+
+#ifndef BOOKSET_HPP
+#define BOOKSET_HPP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "contatto.hpp"
+#include "list.hpp"
+
+/**
+ * @class BookSet
+ * @brief Insieme di rubriche su cui cercare insieme
+ *
+ * @details
+ * - La rubrica principale viene registrata con addBook e resta di chi la possiede
+ * - Le rubriche aperte con openFiles appartengono al BookSet
+ * - Va usato nel thread delle rubriche (la GUI): durante una ricerca il thread
+ *   chiamante aspetta, quindi nessuna rubrica può cambiare mentre viene letta
+ */
+class BookSet : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Risultato di una ricerca federata
+     */
+    struct Result
+    {
+        qsizetype book = 0; /**< Indice della rubrica di provenienza (vedi name) */
+        Contact contact;    /**< Contatto trovato, con il suo id in quella rubrica */
+    };
+
+    /**
+     * @brief Costruttore
+     * @param[in] parent Oggetto padre nella gerarchia Qt (opzionale)
+     */
+    explicit BookSet(QObject *parent = nullptr);
+
+    /**
+     * @brief Registra una rubrica già aperta
+     * @param[in] list Rubrica (non passa al BookSet, deve sopravvivergli)
+     * @param[in] name Nome mostrato accanto ai risultati
+     * @return Indice della rubrica
+     */
+    qsizetype addBook(ContactList *list, const QString &name);
+
+    /**
+     * @brief Apre più file di rubrica in parallelo
+     * @param[in] filePaths File CSV da aprire (stesso formato di contacts.csv)
+     * @param[out] failed Se non nullo, riceve i file che non è stato possibile aprire
+     * @return Numero di rubriche aperte
+     * @details
+     * Ogni file viene letto, validato e ordinato in un thread proprio (parallelFor):
+     * il tempo totale è vicino a quello del file più grande. Le righe non valide
+     * vengono tenute come in ContactList::loadFromFile. Un file già aperto non
+     * viene aperto di nuovo.
+     */
+    qsizetype openFiles(const QStringList &filePaths, QStringList *failed = nullptr);
+
+    /**
+     * @brief Numero di rubriche
+     */
+    qsizetype count() const { return m_books.size(); }
+
+    /**
+     * @brief Nome di una rubrica
+     * @param[in] book Indice valido
+     */
+    QString name(qsizetype book) const { return m_books[book].name; }
+
+    /**
+     * @brief Rubrica per indice
+     * @param[in] book Indice valido
+     */
+    ContactList *book(qsizetype book) const { return m_books[book].list; }
+
+    /**
+     * @brief Cerca in tutte le rubriche
+     * @param[in] query Stringa di ricerca (stessa sintassi di ContactList::search)
+     * @param[in] limit Numero massimo di risultati in totale
+     * @return Risultati in ordine di nome, a parità di nome nell'ordine delle rubriche
+     * @details
+     * Ogni rubrica cerca i suoi primi limit risultati in un thread proprio, su uno
+     * snapshot e con un indice costruito per la ricerca: indice e cache della lista
+     * non vengono toccati fuori dal suo thread. I risultati, già ordinati per nome in
+     * ogni rubrica, vengono poi uniti e troncati a limit.
+     */
+    QVector<Result> search(const QString &query, int limit) const;
+
+private:
+    /**
+     * @brief Rubrica registrata
+     */
+    struct Book
+    {
+        QString name;     /**< Nome mostrato nei risultati */
+        QString filePath; /**< File da cui è stata aperta (vuoto per quella principale) */
+        ContactList *list = nullptr;
+    };
+
+    QVector<Book> m_books; /**< Rubriche, la principale per prima */
+};
+
+#endif // BOOKSET_HPP
@@ -0,0 +1,620 @@
+/**
+ * @file contactstore.cpp
+ * @brief ContactStore class implementation
+ */
+
+#include "contactstore.hpp"
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_store_namespace {
+/**
+ * @brief Riordina una colonna secondo la permutazione (order[i] = vecchio indice della riga i)
+ */
+template<typename T>
+void permute(QVector<T> &column, const std::vector<int> &order)
+{
+    QVector<T> sorted;
+    sorted.reserve(column.size());
+    for (const int index : order)
+        sorted.append(std::move(column[index]));
+    column = std::move(sorted);
+}
+
+/**
+ * @brief Compatta una colonna eliminando le righe segnate
+ */
+template<typename T>
+void compact(QVector<T> &column, const QVector<bool> &removed)
+{
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < column.size(); ++i) {
+        if (removed[i])
+            continue;
+        if (kept != i)
+            column[kept] = std::move(column[i]);
+        kept++;
+    }
+    column.resize(kept);
+}
+
+/**
+ * @brief Memoria del vettore di una colonna (senza i dati a cui puntano gli elementi)
+ */
+template<typename T>
+qsizetype columnBytes(const QVector<T> &column)
+{
+    return column.capacity() * qsizetype(sizeof(T));
+}
+
+/**
+ * @brief Memoria dei caratteri delle stringhe di una colonna
+ */
+qsizetype payloadBytes(const QVector<QString> &column)
+{
+    qsizetype bytes = 0;
+    for (const QString &text : column)
+        bytes += StringPool::stringBytes(text.size()) - qsizetype(sizeof(QString));
+    return bytes;
+}
+
+/**
+ * @brief Svuota una colonna liberandone anche la memoria
+ */
+template<typename T>
+void release(QVector<T> &column)
+{
+    QVector<T>().swap(column);
+}
+} // namespace m_store_namespace
+
+void ContactStore::reserve(qsizetype count)
+{
+    forEachColumn([count](auto &column) { column.reserve(count); });
+}
+
+void ContactStore::clear()
+{
+    forEachColumn([](auto &column) { column.clear(); });
+    m_namePool.clear();
+    m_domainPool.clear();
+    m_phonePool.clear();
+    m_slots.clear();
+    m_nextId = 1;
+    m_sorted = true;
+    m_letterCounts.fill(0);
+}
+
+void ContactStore::append(Contact contact)
+{
+    const qsizetype index = size();
+    insertRow(index, contact);
+
+    // resta ordinato se il nuovo nome non precede l'ultimo
+    if (m_sorted && index > 0 && rowLess(index, index - 1))
+        m_sorted = false;
+}
+
+qsizetype ContactStore::insertSorted(Contact contact)
+{
+    sort();
+
+    const qsizetype row = upperBound(contact.name());
+    insertRow(row, contact);
+    return row;
+}
+
+QVector<qsizetype> ContactStore::insertSortedRows(QVector<Contact> contacts)
+{
+    sort();
+
+    std::stable_sort(contacts.begin(), contacts.end(), [this](const Contact &a, const Contact &b) {
+        return nameLessThan(a.name(), b.name());
+    });
+
+    // i nuovi contatti sono in ordine: le posizioni trovate sull'archivio attuale
+    // sono non decrescenti, e j contatti prima di questo spostano la sua riga di j
+    QVector<qsizetype> rows;
+    rows.reserve(contacts.size());
+    for (qsizetype j = 0; j < contacts.size(); ++j)
+        rows.append(upperBound(contacts[j].name()) + j);
+
+    insertRows(rows, contacts);
+    return rows;
+}
+
+void ContactStore::insert(qsizetype index, Contact contact)
+{
+    insertRow(index, contact);
+    if (m_sorted && !inOrderAt(index))
+        m_sorted = false;
+}
+
+void ContactStore::insertRows(const QVector<qsizetype> &rows, const QVector<Contact> &contacts)
+{
+    const qsizetype existing = size();
+    for (const Contact &contact : contacts)
+        insertRow(size(), contact);
+
+    // order[i] = riga attuale che deve finire in posizione i
+    std::vector<int> order(static_cast<size_t>(size()));
+    qsizetype inserted = 0;
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < size(); ++i) {
+        if (inserted < rows.size() && rows[inserted] == i)
+            order[size_t(i)] = int(existing + inserted++);
+        else
+            order[size_t(i)] = int(kept++);
+    }
+    forEachColumn([&order](auto &column) { m_store_namespace::permute(column, order); });
+    updateSlots(rows.isEmpty() ? size() : rows.first());
+
+    for (const qsizetype row : rows) {
+        if (m_sorted && !inOrderAt(row))
+            m_sorted = false;
+    }
+}
+
+void ContactStore::set(qsizetype index, Contact contact)
+{
+    m_letterCounts[size_t(letterGroupAt(index))]--;
+    storeRow(index, contact);
+    m_letterCounts[size_t(letterGroupAt(index))]++;
+
+    // l'ordine si rompe solo se il nuovo nome non sta più tra i vicini
+    if (m_sorted && ((index > 0 && rowLess(index, index - 1))
+                     || (index + 1 < size() && rowLess(index + 1, index))))
+        m_sorted = false;
+}
+
+void ContactStore::setEmail(qsizetype index, QString email)
+{
+    storeEmail(index, email);
+}
+
+void ContactStore::setPhone(qsizetype index, const QString &phone)
+{
+    m_phoneKeys[index] = packPhone(phone);
+}
+
+void ContactStore::remove(qsizetype index)
+{
+    // togliere una riga non cambia l'ordine delle altre
+    m_slots[qsizetype(m_ids[index])] = -1;
+    m_letterCounts[size_t(letterGroupAt(index))]--;
+    forEachColumn([index](auto &column) { column.removeAt(index); });
+    updateSlots(index);
+}
+
+qsizetype ContactStore::removeIf(const QVector<bool> &removed)
+{
+    const qsizetype before = size();
+    qsizetype first = before;
+    for (qsizetype i = before - 1; i >= 0; --i) {
+        if (removed[i]) {
+            m_slots[qsizetype(m_ids[i])] = -1;
+            m_letterCounts[size_t(letterGroupAt(i))]--;
+            first = i;
+        }
+    }
+
+    forEachColumn([&removed](auto &column) { m_store_namespace::compact(column, removed); });
+    updateSlots(first);
+    return before - size();
+}
+
+void ContactStore::sort()
+{
+    if (m_sorted)
+        return;
+
+    // ordino gli indici guardando solo i nomi, poi sposto le righe una volta sola
+    std::vector<int> order(static_cast<size_t>(size()));
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return rowLess(a, b); });
+
+    forEachColumn([&order](auto &column) { m_store_namespace::permute(column, order); });
+    updateSlots(0);
+    m_sorted = true;
+}
+
+Contact ContactStore::contact(qsizetype index) const
+{
+    Contact contact(name(index), phone(index), email(index));
+    contact.setId(m_ids[index]);
+    return contact;
+}
+
+qsizetype ContactStore::indexOfId(quint64 id) const
+{
+    if (id == 0 || id >= quint64(m_slots.size()))
+        return -1;
+    return m_slots[qsizetype(id)];
+}
+
+qsizetype ContactStore::indexOf(const QString &value) const
+{
+    qsizetype found = -1;
+
+    if (m_interning) {
+        // confronto gli id: se una parte del nome non è nel pool nessun contatto ha quel nome
+        const NameParts parts = splitName(value);
+        quint32 first = 0;
+        quint32 rest = kNone;
+        if (m_namePool.find(parts.first, &first) && (!parts.hasRest || m_namePool.find(parts.rest, &rest))) {
+            for (qsizetype i = 0; i < size(); ++i) {
+                if (m_nameFirst[i] == first && m_nameRest[i] == rest) {
+                    found = i;
+                    break;
+                }
+            }
+        }
+    } else {
+        found = m_names.indexOf(value);
+    }
+
+    // il telefono si confronta come intero; un numero non conforme che non è nel pool non c'è
+    quint64 key = 0;
+    if (!PhoneNumber::pack(value, &key)) {
+        quint32 id = 0;
+        if (!m_phonePool.find(value, &id))
+            return found;
+        key = PhoneNumber::kOverflow | id;
+    }
+
+    // una scansione per colonna; sui telefoni basta arrivare al nome trovato
+    const qsizetype limit = found < 0 ? size() : found;
+    for (qsizetype i = 0; i < limit; ++i) {
+        if (m_phoneKeys[i] == key)
+            return i;
+    }
+    return found;
+}
+
+QString ContactStore::name(qsizetype index) const
+{
+    if (!m_interning)
+        return m_names[index];
+
+    const QString &first = m_namePool.string(m_nameFirst[index]);
+    if (m_nameRest[index] == kNone)
+        return first;
+
+    const QString &rest = m_namePool.string(m_nameRest[index]);
+    QString name;
+    name.reserve(first.size() + 1 + rest.size());
+    name.append(first).append(QLatin1Char(' ')).append(rest);
+    return name;
+}
+
+QString ContactStore::phone(qsizetype index) const
+{
+    const quint64 key = m_phoneKeys[index];
+    if (PhoneNumber::isOverflow(key))
+        return m_phonePool.string(quint32(key));
+    return PhoneNumber::unpack(key);
+}
+
+QString ContactStore::email(qsizetype index) const
+{
+    if (!m_interning)
+        return m_emails[index];
+
+    const QString &local = m_emailLocals[index];
+    if (m_emailDomains[index] == kNone)
+        return local;
+
+    const QString &domain = m_domainPool.string(m_emailDomains[index]);
+    QString email;
+    email.reserve(local.size() + 1 + domain.size());
+    email.append(local).append(QLatin1Char('@')).append(domain);
+    return email;
+}
+
+void ContactStore::setInterning(bool enabled)
+{
+    if (!enabled && !m_interning)
+        return;
+
+    const qsizetype count = size();
+
+    // dai pool alle colonne semplici (anche per ricostruire i pool da zero)
+    if (m_interning) {
+        QVector<QString> names;
+        QVector<QString> emails;
+        names.reserve(count);
+        emails.reserve(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            names.append(name(i));
+            emails.append(email(i));
+        }
+
+        m_store_namespace::release(m_nameFirst);
+        m_store_namespace::release(m_nameRest);
+        m_store_namespace::release(m_emailLocals);
+        m_store_namespace::release(m_emailDomains);
+        m_namePool.clear();
+        m_domainPool.clear();
+        m_names = std::move(names);
+        m_emails = std::move(emails);
+        m_interning = false;
+
+        if (!enabled) {
+            m_sortKeys.reserve(count);
+            for (const QString &name : std::as_const(m_names))
+                m_sortKeys.append(sortKey(name));
+            return;
+        }
+    }
+
+    // dalle colonne semplici ai pool, liberando le stringhe originali man mano
+    m_store_namespace::release(m_sortKeys);
+    m_interning = true;
+    m_nameFirst.resize(count);
+    m_nameRest.resize(count);
+    m_emailLocals.resize(count);
+    m_emailDomains.resize(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        storeName(i, std::exchange(m_names[i], QString()));
+        storeEmail(i, std::exchange(m_emails[i], QString()));
+    }
+    m_store_namespace::release(m_names);
+    m_store_namespace::release(m_emails);
+}
+
+ContactStore::MemoryReport ContactStore::memoryReport() const
+{
+    using m_store_namespace::columnBytes;
+    using m_store_namespace::payloadBytes;
+
+    const qsizetype count = size();
+    MemoryReport report;
+
+    if (m_interning) {
+        report.columnBytes = columnBytes(m_nameFirst) + columnBytes(m_nameRest)
+                             + columnBytes(m_emailLocals) + columnBytes(m_emailDomains);
+        report.stringBytes = payloadBytes(m_emailLocals);
+        report.poolBytes = m_namePool.memoryUsage() + m_domainPool.memoryUsage();
+    } else {
+        report.columnBytes = columnBytes(m_names) + columnBytes(m_emails) + columnBytes(m_sortKeys);
+        report.stringBytes = payloadBytes(m_names) + payloadBytes(m_emails) + payloadBytes(m_sortKeys);
+    }
+    report.columnBytes += columnBytes(m_phoneKeys) + columnBytes(m_ids) + columnBytes(m_slots);
+    report.poolBytes += m_phonePool.memoryUsage();
+    report.pooledStrings = m_namePool.size() + m_domainPool.size() + m_phonePool.size();
+    report.actualBytes = report.columnBytes + report.stringBytes + report.poolBytes;
+
+    // confronto: nome, chiave di ordinamento (stessa lunghezza), telefono ed email in QString
+    for (qsizetype i = 0; i < count; ++i) {
+        qsizetype nameLength = 0;
+        qsizetype emailLength = 0;
+        if (m_interning) {
+            nameLength = m_namePool.string(m_nameFirst[i]).size();
+            if (m_nameRest[i] != kNone)
+                nameLength += 1 + m_namePool.string(m_nameRest[i]).size();
+            emailLength = m_emailLocals[i].size();
+            if (m_emailDomains[i] != kNone)
+                emailLength += 1 + m_domainPool.string(m_emailDomains[i]).size();
+        } else {
+            nameLength = m_names[i].size();
+            emailLength = m_emails[i].size();
+        }
+
+        const quint64 key = m_phoneKeys[i];
+        const qsizetype phoneLength = PhoneNumber::isOverflow(key) ? m_phonePool.string(quint32(key)).size()
+                                                                   : PhoneNumber::kDigits;
+
+        report.plainBytes += 2 * StringPool::stringBytes(nameLength) + StringPool::stringBytes(emailLength)
+                             + StringPool::stringBytes(phoneLength);
+    }
+
+    return report;
+}
+
+qsizetype ContactStore::sortScratchBytes() const
+{
+    // permutazione e buffer di stable_sort, più la colonna più grande (QString o id a 64 bit)
+    const qsizetype row = std::max(qsizetype(sizeof(QString)), qsizetype(sizeof(quint64)));
+    return size() * (2 * qsizetype(sizeof(int)) + row);
+}
+
+QString ContactStore::sortKey(const QString &name)
+{
+    return name.toCaseFolded();
+}
+
+int ContactStore::letterGroup(QChar initial)
+{
+    const char16_t c = initial.toCaseFolded().unicode();
+    if (c < u'a')
+        return 0;
+    if (c <= u'z')
+        return 1 + int(c - u'a');
+    return kLetterGroups - 1;
+}
+
+QString ContactStore::letterLabel(int group)
+{
+    if (group <= 0)
+        return QStringLiteral("#");
+    if (group >= kLetterGroups - 1)
+        return QStringLiteral("…");
+    return QString(QChar(u'A' + group - 1));
+}
+
+qsizetype ContactStore::letterStart(int group) const
+{
+    qsizetype start = 0;
+    for (int i = 0; i < group; ++i)
+        start += m_letterCounts[size_t(i)];
+    return start;
+}
+
+void ContactStore::insertRow(qsizetype index, const Contact &contact)
+{
+    forEachColumn([index](auto &column) {
+        using Value = typename std::decay_t<decltype(column)>::value_type;
+        column.insert(index, Value());
+    });
+    storeRow(index, contact);
+    m_letterCounts[size_t(letterGroupAt(index))]++;
+
+    // id nuovo oppure quello già assegnato al contatto (es. annullando una rimozione)
+    quint64 id = contact.id();
+    if (id == 0)
+        id = m_nextId++;
+    else
+        m_nextId = std::max(m_nextId, id + 1);
+    m_ids[index] = id;
+
+    if (qsizetype(id) >= m_slots.size()) {
+        // crescita geometrica: gli id nuovi arrivano uno alla volta
+        if (qsizetype(id) >= m_slots.capacity())
+            m_slots.reserve(std::max(qsizetype(id) + 1, 2 * m_slots.capacity()));
+        m_slots.resize(qsizetype(id) + 1, -1);
+    }
+    updateSlots(index);
+}
+
+void ContactStore::updateSlots(qsizetype from)
+{
+    for (qsizetype i = from; i < size(); ++i)
+        m_slots[qsizetype(m_ids[i])] = int(i);
+}
+
+void ContactStore::storeRow(qsizetype index, const Contact &contact)
+{
+    storeName(index, contact.name());
+    m_phoneKeys[index] = packPhone(contact.phone());
+    storeEmail(index, contact.email());
+}
+
+void ContactStore::storeName(qsizetype index, const QString &name)
+{
+    if (!m_interning) {
+        m_names[index] = name;
+        m_sortKeys[index] = sortKey(name);
+        return;
+    }
+
+    const NameParts parts = splitName(name);
+    m_nameFirst[index] = m_namePool.intern(parts.first);
+    m_nameRest[index] = parts.hasRest ? m_namePool.intern(parts.rest) : kNone;
+}
+
+void ContactStore::storeEmail(qsizetype index, const QString &email)
+{
+    if (!m_interning) {
+        m_emails[index] = email;
+        return;
+    }
+
+    const qsizetype at = email.lastIndexOf(QLatin1Char('@'));
+    if (at < 0) {
+        m_emailLocals[index] = email;
+        m_emailDomains[index] = kNone;
+        return;
+    }
+    m_emailLocals[index] = email.left(at);
+    m_emailDomains[index] = m_domainPool.intern(QStringView(email).mid(at + 1));
+}
+
+quint64 ContactStore::packPhone(QStringView phone)
+{
+    quint64 key = 0;
+    if (PhoneNumber::pack(phone, &key))
+        return key;
+    return PhoneNumber::kOverflow | m_phonePool.intern(phone);
+}
+
+int ContactStore::letterGroupAt(qsizetype index) const
+{
+    // la chiave di ordinamento e la prima parte del nome iniziano con lo stesso carattere
+    const QString &name = m_interning ? m_namePool.string(m_nameFirst[index]) : m_sortKeys[index];
+    return name.isEmpty() ? 0 : letterGroup(name.front());
+}
+
+ContactStore::NameParts ContactStore::nameParts(qsizetype index) const
+{
+    const quint32 rest = m_nameRest[index];
+    return NameParts{m_namePool.string(m_nameFirst[index]),
+                     rest == kNone ? QStringView() : QStringView(m_namePool.string(rest)),
+                     rest != kNone};
+}
+
+ContactStore::NameParts ContactStore::splitName(QStringView name)
+{
+    const qsizetype space = name.indexOf(QLatin1Char(' '));
+    if (space < 0)
+        return NameParts{name, QStringView(), false};
+    return NameParts{name.left(space), name.mid(space + 1), true};
+}
+
+bool ContactStore::nameLess(const NameParts &a, const NameParts &b)
+{
+    // carattere i del nome ricomposto "first rest", in case folding
+    const auto folded = [](const NameParts &parts, qsizetype i) -> char16_t {
+        if (i < parts.first.size())
+            return parts.first[i].toCaseFolded().unicode();
+        if (i == parts.first.size())
+            return u' ';
+        return parts.rest[i - parts.first.size() - 1].toCaseFolded().unicode();
+    };
+
+    const qsizetype lengthA = a.first.size() + (a.hasRest ? 1 + a.rest.size() : 0);
+    const qsizetype lengthB = b.first.size() + (b.hasRest ? 1 + b.rest.size() : 0);
+    const qsizetype length = std::min(lengthA, lengthB);
+    for (qsizetype i = 0; i < length; ++i) {
+        const char16_t ca = folded(a, i);
+        const char16_t cb = folded(b, i);
+        if (ca != cb)
+            return ca < cb;
+    }
+    return lengthA < lengthB;
+}
+
+qsizetype ContactStore::upperBound(const QString &name) const
+{
+    // ricerca binaria della prima riga con il nome maggiore di name
+    if (!m_interning) {
+        const QString key = sortKey(name);
+        return std::upper_bound(m_sortKeys.cbegin(), m_sortKeys.cend(), key) - m_sortKeys.cbegin();
+    }
+
+    const NameParts parts = splitName(name);
+    qsizetype low = 0;
+    qsizetype high = size();
+    while (low < high) {
+        const qsizetype middle = low + (high - low) / 2;
+        if (nameLess(parts, nameParts(middle)))
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+bool ContactStore::nameLessThan(const QString &a, const QString &b) const
+{
+    if (m_interning)
+        return nameLess(splitName(a), splitName(b));
+    return sortKey(a) < sortKey(b);
+}
+
+bool ContactStore::rowLess(qsizetype a, qsizetype b) const
+{
+    if (m_interning)
+        return nameLess(nameParts(a), nameParts(b));
+    return m_sortKeys.at(a) < m_sortKeys.at(b);
+}
+
+bool ContactStore::inOrderAt(qsizetype index) const
+{
+    return !(index > 0 && rowLess(index, index - 1)) && !(index + 1 < size() && rowLess(index + 1, index));
+}
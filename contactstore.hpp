@@ -0,0 +1,454 @@
+/**
+ * @file contactstore.hpp
+ * @brief Archivio a colonne dei contatti della rubrica
+ *
+ * @details
+ * I contatti non sono memorizzati come oggetti Contact separati ma per campo:
+ * un vettore contiguo per i nomi, uno per i telefoni, uno per le email e uno per
+ * le chiavi di ordinamento. Il contatto i-esimo è la riga i di tutte le colonne.
+ *
+ * Le scansioni che leggono un solo campo (ricerca per nome o telefono, ordinamento,
+ * salvataggio) scorrono la memoria in modo lineare invece di saltare da un nodo
+ * all'altro della linked list.
+ *
+ * Con l'interning attivo (setInterning) nomi e domini email vengono memorizzati
+ * una sola volta in un StringPool e le colonne contengono solo gli id.
+ *
+ * I telefoni sono sempre compatti: un intero a 64 bit per contatto (vedi PhoneNumber).
+ *
+ * Ogni contatto ha un id stabile a 64 bit (vedi Contact::id), che non cambia con
+ * modifiche e ordinamenti: una tabella id → riga permette di trovarlo in O(1).
+ */
+
+#ifndef CONTACTSTORE_HPP
+#define CONTACTSTORE_HPP
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <array>
+#include "contatto.hpp"
+#include "phonenumber.hpp"
+#include "stringpool.hpp"
+
+/**
+ * @class ContactStore
+ * @brief Contatti memorizzati a colonne (struct of arrays)
+ *
+ * @details
+ * - Accesso per indice in O(1)
+ * - Inserimento ordinato con ricerca binaria sulle chiavi di ordinamento
+ * - Rimozione di più righe con una sola compattazione delle colonne
+ *
+ * La chiave di ordinamento è il nome in case folding, calcolata una sola volta
+ * all'inserimento: l'ordinamento confronta le chiavi senza creare stringhe temporanee.
+ *
+ * Il telefono conforme (10 cifre) è salvato come valore numerico, quelli non
+ * conformi in un pool a parte con il bit PhoneNumber::kOverflow: la ricerca
+ * per telefono confronta interi di 8 byte invece di stringhe.
+ *
+ * Rappresentazione con interning:
+ * - il nome è diviso al primo spazio in due parti ("Mario" e "Rossi"), ognuna
+ *   salvata come id nel pool dei nomi: nomi e cognomi ricorrenti occupano 4 byte
+ * - l'email è divisa all'ultima '@': la parte locale resta una QString,
+ *   il dominio è un id nel pool dei domini
+ * - la colonna delle chiavi non esiste: l'ordinamento confronta i nomi
+ *   carattere per carattere in case folding, direttamente dal pool
+ */
+class ContactStore
+{
+public:
+    /**
+     * @brief Campi di un contatto
+     */
+    enum Field { Name = 0, Phone = 1, Email = 2 };
+
+    /**
+     * @struct MemoryReport
+     * @brief Stima della memoria occupata dai contatti
+     */
+    struct MemoryReport
+    {
+        qsizetype columnBytes = 0;   /**< Vettori delle colonne (capacità allocata) */
+        qsizetype stringBytes = 0;   /**< Caratteri delle QString nelle colonne */
+        qsizetype poolBytes = 0;     /**< Pool di nomi, domini e telefoni non conformi */
+        qsizetype actualBytes = 0;   /**< Totale: colonne, stringhe e pool */
+        qsizetype plainBytes = 0;    /**< Memoria che servirebbe con tutti i campi in QString */
+        qsizetype pooledStrings = 0; /**< Stringhe distinte nei pool */
+
+        /**
+         * @brief Memoria risparmiata da interning e telefoni compatti
+         */
+        qsizetype savedBytes() const { return plainBytes - actualBytes; }
+    };
+
+    /**
+     * @brief Numero di contatti
+     */
+    qsizetype size() const { return m_phoneKeys.size(); }
+
+    /**
+     * @brief Verifica se l'archivio è vuoto
+     */
+    bool isEmpty() const { return m_phoneKeys.isEmpty(); }
+
+    /**
+     * @brief Riserva spazio in tutte le colonne
+     * @param[in] count Numero di contatti previsto
+     */
+    void reserve(qsizetype count);
+
+    /**
+     * @brief Rimuove tutti i contatti (la modalità di interning non cambia)
+     */
+    void clear();
+
+    /**
+     * @brief Aggiunge un contatto in fondo, senza ordinare
+     * @param[in] contact Contatto da aggiungere (i campi sono condivisi con le colonne, senza copiare i caratteri)
+     * @details Come per tutti gli inserimenti, se contact.id() è 0 viene assegnato un
+     * nuovo id, altrimenti il contatto mantiene il suo (che non deve essere già in rubrica).
+     */
+    void append(Contact contact);
+
+    /**
+     * @brief Inserisce un contatto nella posizione data dal nome
+     * @param[in] contact Contatto da inserire
+     * @return Indice in cui è stato inserito
+     * @details Se l'archivio non è ordinato viene prima ordinato con sort().
+     * A parità di nome il nuovo contatto va dopo quelli già presenti.
+     */
+    qsizetype insertSorted(Contact contact);
+
+    /**
+     * @brief Inserisce un contatto in una posizione precisa
+     * @param[in] index Posizione (0 <= index <= size())
+     * @param[in] contact Contatto da inserire
+     * @details Usato per annullare una rimozione: la riga torna dov'era, senza
+     * ricerca né ordinamento. Se il nome non rispetta l'ordine dei vicini
+     * l'archivio risulta non ordinato (vedi isSorted).
+     */
+    void insert(qsizetype index, Contact contact);
+
+    /**
+     * @brief Inserisce più contatti nelle posizioni indicate
+     * @param[in] rows Posizioni finali crescenti (riferite all'archivio dopo l'inserimento)
+     * @param[in] contacts Contatti da inserire, uno per posizione
+     * @details I contatti vengono accodati e poi spostati al loro posto con una
+     * sola permutazione di ogni colonna: O(n + k) invece di k inserimenti O(n).
+     */
+    void insertRows(const QVector<qsizetype> &rows, const QVector<Contact> &contacts);
+
+    /**
+     * @brief Inserisce più contatti nelle posizioni date dal nome
+     * @param[in] contacts Contatti da inserire, in qualsiasi ordine
+     * @return Posizioni finali crescenti dei contatti inseriti
+     * @details Ordina solo i nuovi contatti (k log k), trova la posizione di ognuno
+     * con una ricerca binaria e li inserisce con un solo insertRows: O(n + k log n).
+     * A parità di nome i nuovi contatti vanno dopo quelli già presenti.
+     * Se l'archivio non è ordinato viene prima ordinato con sort().
+     */
+    QVector<qsizetype> insertSortedRows(QVector<Contact> contacts);
+
+    /**
+     * @brief Sostituisce il contatto alla posizione indicata
+     * @param[in] index Indice valido (0 <= index < size())
+     * @param[in] contact Nuovi dati
+     * @note L'archivio non viene riordinato e la riga mantiene il suo id
+     */
+    void set(qsizetype index, Contact contact);
+
+    /**
+     * @brief Sostituisce solo l'email (l'ordine non cambia)
+     * @param[in] index Indice valido (0 <= index < size())
+     * @param[in] email Nuova email
+     */
+    void setEmail(qsizetype index, QString email);
+
+    /**
+     * @brief Sostituisce solo il telefono (l'ordine non cambia)
+     * @param[in] index Indice valido (0 <= index < size())
+     * @param[in] phone Nuovo numero di telefono
+     */
+    void setPhone(qsizetype index, const QString &phone);
+
+    /**
+     * @brief Rimuove il contatto alla posizione indicata
+     * @param[in] index Indice valido (0 <= index < size())
+     */
+    void remove(qsizetype index);
+
+    /**
+     * @brief Rimuove tutte le righe segnate, mantenendo l'ordine delle altre
+     * @param[in] removed Un flag per riga (stessa dimensione dell'archivio)
+     * @return Numero di righe rimosse
+     */
+    qsizetype removeIf(const QVector<bool> &removed);
+
+    /**
+     * @brief Ordina i contatti per nome (crescente, case-insensitive, stabile)
+     * @details
+     * Ordina una permutazione degli indici confrontando solo i nomi,
+     * poi applica la permutazione a ogni colonna. Se l'archivio è già ordinato non fa nulla.
+     */
+    void sort();
+
+    /**
+     * @brief Ricostruisce il contatto alla posizione indicata
+     * @param[in] index Indice valido (0 <= index < size())
+     * @return Copia del contatto, con il suo id
+     */
+    Contact contact(qsizetype index) const;
+
+    /**
+     * @brief Cerca il primo contatto con il nome o il telefono indicato
+     * @param[in] value Nome esatto (case-sensitive) oppure numero di telefono
+     * @return Indice del contatto, -1 se assente
+     */
+    qsizetype indexOf(const QString &value) const;
+
+    /**
+     * @brief Riga del contatto con l'id indicato
+     * @param[in] id Id del contatto
+     * @return Indice del contatto, -1 se l'id non è in rubrica
+     * @note Complessità O(1), nessuna scansione
+     */
+    qsizetype indexOfId(quint64 id) const;
+
+    /**
+     * @brief Id del contatto
+     * @param[in] index Indice valido (0 <= index < size())
+     */
+    quint64 id(qsizetype index) const { return m_ids[index]; }
+
+    /**
+     * @brief Nome del contatto
+     * @param[in] index Indice valido (0 <= index < size())
+     * @return Nome (senza interning è una copia condivisa, senza allocazioni)
+     */
+    QString name(qsizetype index) const;
+
+    /**
+     * @brief Telefono del contatto
+     * @param[in] index Indice valido (0 <= index < size())
+     * @return Telefono ricostruito dal valore numerico (o preso dal pool se non conforme)
+     */
+    QString phone(qsizetype index) const;
+
+    /**
+     * @brief Email del contatto
+     * @param[in] index Indice valido (0 <= index < size())
+     * @return Email (senza interning è una copia condivisa, senza allocazioni)
+     */
+    QString email(qsizetype index) const;
+
+    /**
+     * @brief Colonna dei telefoni compatti, per le scansioni sul solo telefono
+     * @details Per i numeri conformi il valore è PhoneNumber::pack (la chiave dei
+     * duplicati di ContactValidator), per gli altri ha il bit PhoneNumber::kOverflow.
+     */
+    const QVector<quint64> &phoneKeys() const { return m_phoneKeys; }
+
+    /**
+     * @brief Attiva o disattiva l'interning di nomi e domini email
+     * @param[in] enabled true per memorizzare nomi e domini nei pool
+     * @details Converte tutti i contatti presenti (O(n)); ordine e indici non cambiano.
+     * Riattivarlo ricostruisce i pool eliminando le stringhe non più usate.
+     */
+    void setInterning(bool enabled);
+
+    /**
+     * @brief Verifica se l'interning è attivo
+     */
+    bool isInterning() const { return m_interning; }
+
+    /**
+     * @brief Stima la memoria occupata, con e senza interning
+     * @return Report con la memoria attuale (per struttura) e quella risparmiata
+     * @note Complessità O(n): legge la lunghezza di ogni campo
+     */
+    MemoryReport memoryReport() const;
+
+    /**
+     * @brief Verifica se le righe sono in ordine di nome (sort() non farebbe nulla)
+     */
+    bool isSorted() const { return m_sorted; }
+
+    /**
+     * @brief Memoria temporanea usata da sort(), stimata in byte
+     * @details La permutazione degli indici, il buffer di std::stable_sort
+     * e la copia di una colonna alla volta.
+     */
+    qsizetype sortScratchBytes() const;
+
+    /**
+     * @brief Chiave di ordinamento di un nome
+     * @param[in] name Nome del contatto
+     * @return Nome in case folding (confrontabile con operator<)
+     */
+    static QString sortKey(const QString &name);
+
+    static constexpr int kLetterGroups = 28; /**< Gruppi di iniziali: "#", A–Z e le altre */
+
+    /**
+     * @brief Gruppo dell'iniziale di un nome
+     * @param[in] initial Primo carattere del nome
+     * @return 0 per cifre e simboli, 1–26 per A–Z, 27 per le altre iniziali
+     * @details I gruppi seguono il confronto delle righe (case folding, poi codice del
+     * carattere), quindi in un archivio ordinato ogni gruppo è un intervallo contiguo.
+     * Per lo stesso motivo "É" è nel gruppo finale e non con la "E".
+     */
+    static int letterGroup(QChar initial);
+
+    /**
+     * @brief Etichetta di un gruppo di iniziali ("#", "A"…"Z", "…")
+     */
+    static QString letterLabel(int group);
+
+    /**
+     * @brief Numero di contatti con l'iniziale nel gruppo
+     * @param[in] group Gruppo (0 <= group < kLetterGroups)
+     */
+    qsizetype letterCount(int group) const { return m_letterCounts[size_t(group)]; }
+
+    /**
+     * @brief Prima riga di un gruppo di iniziali
+     * @param[in] group Gruppo (0 <= group < kLetterGroups)
+     * @return Riga del primo contatto del gruppo (se il gruppo è vuoto, quella del successivo)
+     * @details Somma dei contatori dei gruppi precedenti: tempo costante, nessuna ricerca
+     * sui nomi. I contatori sono aggiornati da ogni inserimento e rimozione.
+     * @note Valida solo se l'archivio è ordinato (isSorted)
+     */
+    qsizetype letterStart(int group) const;
+
+private:
+    /**
+     * @brief Nome diviso al primo spazio
+     */
+    struct NameParts
+    {
+        QStringView first; /**< Parte prima dello spazio (o tutto il nome) */
+        QStringView rest;  /**< Parte dopo lo spazio */
+        bool hasRest;      /**< false se il nome non contiene spazi */
+    };
+
+    // Senza interning
+    QVector<QString> m_names;    /**< Colonna dei nomi */
+    QVector<QString> m_emails;   /**< Colonna delle email */
+    QVector<QString> m_sortKeys; /**< Colonna delle chiavi di ordinamento (sortKey del nome) */
+
+    // Con interning
+    QVector<quint32> m_nameFirst;    /**< Id della prima parte del nome nel pool dei nomi */
+    QVector<quint32> m_nameRest;     /**< Id della parte dopo lo spazio, kNone se assente */
+    QVector<QString> m_emailLocals;  /**< Parte locale dell'email (prima della '@') */
+    QVector<quint32> m_emailDomains; /**< Id del dominio nel pool dei domini, kNone senza '@' */
+    StringPool m_namePool;           /**< Parti di nome distinte */
+    StringPool m_domainPool;         /**< Domini email distinti */
+
+    QVector<quint64> m_phoneKeys; /**< Colonna dei telefoni compatti (sempre presente) */
+    StringPool m_phonePool;       /**< Telefoni non conformi */
+
+    QVector<quint64> m_ids; /**< Colonna degli id (sempre presente) */
+    QVector<int> m_slots;   /**< Riga di ogni id (indicizzato per id, -1 se assente) */
+    quint64 m_nextId = 1;   /**< Prossimo id da assegnare: gli id sono densi, da 1 */
+    bool m_sorted = true;         /**< true se le righe sono in ordine di nome */
+    std::array<qsizetype, kLetterGroups> m_letterCounts{}; /**< Contatti per gruppo di iniziali */
+    bool m_interning = false;     /**< true se nomi e domini sono nei pool */
+
+    static constexpr quint32 kNone = 0xFFFFFFFFu; /**< Id di una parte assente */
+
+    /**
+     * @brief Applica f alle colonne della rappresentazione attuale
+     */
+    template<typename F>
+    void forEachColumn(F f)
+    {
+        if (m_interning) {
+            f(m_nameFirst);
+            f(m_nameRest);
+            f(m_emailLocals);
+            f(m_emailDomains);
+        } else {
+            f(m_names);
+            f(m_emails);
+            f(m_sortKeys);
+        }
+        f(m_phoneKeys);
+        f(m_ids);
+    }
+
+    /**
+     * @brief Aggiorna la tabella id → riga per le righe da from in poi
+     * @details Dopo un inserimento o una rimozione cambiano solo le righe successive:
+     * una passata lineare su un vettore di interi, senza hash.
+     */
+    void updateSlots(qsizetype from);
+
+    /**
+     * @brief Inserisce i campi del contatto nella riga index (index == size() per accodare)
+     */
+    void insertRow(qsizetype index, const Contact &contact);
+
+    /**
+     * @brief Scrive i campi del contatto in una riga esistente
+     */
+    void storeRow(qsizetype index, const Contact &contact);
+
+    /**
+     * @brief Gruppo dell'iniziale del nome della riga index
+     */
+    int letterGroupAt(qsizetype index) const;
+
+    /**
+     * @brief Scrive il nome (e la sua chiave) in una riga esistente
+     */
+    void storeName(qsizetype index, const QString &name);
+
+    /**
+     * @brief Scrive l'email in una riga esistente
+     */
+    void storeEmail(qsizetype index, const QString &email);
+
+    /**
+     * @brief Valore compatto di un telefono, aggiungendolo al pool se non è conforme
+     */
+    quint64 packPhone(QStringView phone);
+
+    /**
+     * @brief Parti del nome della riga index (solo con interning)
+     */
+    NameParts nameParts(qsizetype index) const;
+
+    /**
+     * @brief Divide un nome al primo spazio
+     */
+    static NameParts splitName(QStringView name);
+
+    /**
+     * @brief Confronto case-insensitive di due nomi divisi in parti
+     * @return true se a precede b
+     */
+    static bool nameLess(const NameParts &a, const NameParts &b);
+
+    /**
+     * @brief Prima riga con il nome maggiore di name (archivio ordinato)
+     */
+    qsizetype upperBound(const QString &name) const;
+
+    /**
+     * @brief true se il nome a precede il nome b, con lo stesso confronto delle righe
+     */
+    bool nameLessThan(const QString &a, const QString &b) const;
+
+    /**
+     * @brief true se il nome della riga a precede quello della riga b
+     */
+    bool rowLess(qsizetype a, qsizetype b) const;
+
+    /**
+     * @brief Verifica che la riga sia in ordine rispetto alle righe vicine
+     */
+    bool inOrderAt(qsizetype index) const;
+};
+
+#endif // CONTACTSTORE_HPP
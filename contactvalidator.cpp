@@ -0,0 +1,171 @@
+/**
+ * @file contactvalidator.cpp
+ * @brief ContactValidator class implementation
+ */
+
+#include "contactvalidator.hpp"
+#include "parallel.hpp"
+#include "phonenumber.hpp"
+#include <QStringView>
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_validator_namespace {
+// Righe minime per thread: sotto questa soglia i thread costano più del lavoro
+constexpr qsizetype kRowsPerThread = 4096;
+
+/**
+ * @brief Esito dei controlli su una singola riga
+ */
+struct RowCheck
+{
+    quint64 phoneKey = 0; // valore numerico del telefono, valido solo se phone == Ok
+    ContactValidator::Reason name = ContactValidator::Ok;
+    ContactValidator::Reason phone = ContactValidator::Ok;
+    ContactValidator::Reason email = ContactValidator::Ok;
+};
+
+/**
+ * @brief Controlla il formato del telefono e lo converte in numero
+ *
+ * La conversione è quella di PhoneNumber::pack, la forma in cui ContactStore
+ * memorizza i telefoni: le chiavi dei duplicati coincidono per costruzione.
+ * Solo se il numero non è conforme si guarda perché (caso raro).
+ */
+ContactValidator::Reason checkPhone(QStringView phone, quint64 *key)
+{
+    if (phone.isEmpty())
+        return ContactValidator::Missing;
+
+    quint64 value = 0;
+    if (!PhoneNumber::pack(phone, &value)) {
+        const bool digits = std::all_of(phone.begin(), phone.end(),
+                                        [](QChar c) { return c >= u'0' && c <= u'9'; });
+        return digits ? ContactValidator::WrongLength : ContactValidator::NotDigits;
+    }
+    if (value == 0)
+        return ContactValidator::InvalidNumber;
+
+    *key = value;
+    return ContactValidator::Ok;
+}
+
+/**
+ * @brief Controlli indipendenti dalle altre righe
+ */
+RowCheck checkRow(const Contact &contact)
+{
+    RowCheck check;
+    if (contact.name().isEmpty())
+        check.name = ContactValidator::Missing;
+    check.phone = checkPhone(contact.phone(), &check.phoneKey);
+    if (!contact.isEmail())
+        check.email = ContactValidator::InvalidEmail;
+    return check;
+}
+
+/**
+ * @brief Esegue i controlli su tutte le righe, in parallelo se il lotto è grande
+ */
+std::vector<RowCheck> checkRows(const QVector<Contact> &batch)
+{
+    std::vector<RowCheck> checks(static_cast<size_t>(batch.size()));
+
+    // ogni thread scrive solo nel proprio intervallo di checks
+    parallelFor(batch.size(), kRowsPerThread, [&](qsizetype, qsizetype begin, qsizetype end) {
+        for (qsizetype row = begin; row < end; ++row)
+            checks[size_t(row)] = checkRow(batch[row]);
+    });
+    return checks;
+}
+} // namespace m_validator_namespace
+
+void ContactValidator::setExisting(const QVector<Contact> &contacts, qsizetype ignoredIndex)
+{
+    m_existingPhones.clear();
+    m_existingPhones.reserve(contacts.size());
+
+    for (qsizetype i = 0; i < contacts.size(); ++i) {
+        quint64 key = 0;
+        if (i != ignoredIndex && m_validator_namespace::checkPhone(contacts[i].phone(), &key) == Ok)
+            m_existingPhones.insert(key);
+    }
+}
+
+void ContactValidator::setExistingPhones(const QVector<quint64> &phoneKeys, qsizetype ignoredIndex)
+{
+    m_existingPhones.clear();
+    m_existingPhones.reserve(phoneKeys.size());
+
+    for (qsizetype i = 0; i < phoneKeys.size(); ++i) {
+        if (i != ignoredIndex && !PhoneNumber::isOverflow(phoneKeys[i]))
+            m_existingPhones.insert(phoneKeys[i]);
+    }
+}
+
+QVector<ContactValidator::Error> ContactValidator::validate(const Contact &contact) const
+{
+    return validate(QVector<Contact>{contact});
+}
+
+QVector<ContactValidator::Error> ContactValidator::validate(const QVector<Contact> &batch) const
+{
+    std::vector<m_validator_namespace::RowCheck> checks = m_validator_namespace::checkRows(batch);
+
+    // duplicati: dipendono dalle righe precedenti, quindi passaggio sequenziale
+    QSet<quint64> seen;
+    for (m_validator_namespace::RowCheck &check : checks) {
+        if (check.phone != Ok)
+            continue;
+        if (m_existingPhones.contains(check.phoneKey) || seen.contains(check.phoneKey))
+            check.phone = Duplicate;
+        else
+            seen.insert(check.phoneKey);
+    }
+
+    QVector<Error> errors;
+    for (qsizetype row = 0; row < qsizetype(checks.size()); ++row) {
+        const m_validator_namespace::RowCheck &check = checks[size_t(row)];
+        if (check.name != Ok)
+            errors.append(Error{int(row), Name, check.name});
+        if (check.phone != Ok)
+            errors.append(Error{int(row), Phone, check.phone});
+        if (check.email != Ok)
+            errors.append(Error{int(row), Email, check.email});
+    }
+
+    return errors;
+}
+
+QString ContactValidator::describe(const Error &error)
+{
+    switch (error.reason) {
+    case Missing:
+        return error.field == Name ? QString("Il nome è obbligatorio")
+                                   : QString("Il numero di telefono è obbligatorio");
+    case NotDigits:
+        return QString("Il numero di telefono deve contenere solo cifre");
+    case WrongLength:
+        return QString("Devi inserire un numero di telefono a 10 cifre");
+    case InvalidNumber:
+        return QString("Il numero di telefono non è valido");
+    case Duplicate:
+        return QString("Numero di telefono già esistente");
+    case InvalidEmail:
+        return QString("Inserisci un indirizzo email valido o lascia il campo vuoto");
+    case Ok:
+        break;
+    }
+    return QString();
+}
+
+QString ContactValidator::describe(const Error &error, const Contact &contact)
+{
+    if (error.reason == WrongLength)
+        return QString("Devi inserire un numero di telefono a 10 cifre, hai inserito %1 cifre")
+            .arg(contact.phone().size());
+    return describe(error);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file contactvalidator.hpp
+ * @brief Validazione dei contatti, singoli o a lotti
+ *
+ * @details
+ * Raccoglie in un solo punto le regole usate dall'inserimento, dalla modifica
+ * e dal caricamento da file:
+ * - nome obbligatorio
+ * - telefono obbligatorio, di sole cifre, lungo 10 cifre e non nullo
+ * - telefono non già presente in rubrica né ripetuto nel lotto
+ * - email vuota oppure con un dominio ammesso (vedi Contact::isEmail)
+ *
+ * Invece di mostrare finestre di errore il validatore produce un report compatto
+ * (riga, campo, motivo), che l'interfaccia traduce in messaggi con describe().
+ */
+
+#ifndef CONTACTVALIDATOR_HPP
+#define CONTACTVALIDATOR_HPP
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include "contatto.hpp"
+
+/**
+ * @class ContactValidator
+ * @brief Validatore dei contatti con report degli errori
+ *
+ * @details
+ * I controlli sulle singole righe sono indipendenti tra loro: sui lotti grandi
+ * vengono eseguiti in parallelo, dividendo le righe tra più thread.
+ * Solo il controllo dei duplicati, che dipende dall'ordine delle righe,
+ * avviene in un secondo passaggio sequenziale sui numeri già convertiti.
+ */
+class ContactValidator
+{
+public:
+    /**
+     * @brief Campo del contatto a cui si riferisce l'errore
+     */
+    enum Field : quint8 { Name, Phone, Email };
+
+    /**
+     * @brief Motivo dell'errore
+     */
+    enum Reason : quint8 {
+        Ok = 0,        /**< Nessun errore (uso interno) */
+        Missing,       /**< Campo obbligatorio vuoto */
+        NotDigits,     /**< Il telefono contiene caratteri diversi dalle cifre */
+        WrongLength,   /**< Il telefono non ha 10 cifre */
+        InvalidNumber, /**< Il telefono è composto solo da zeri */
+        Duplicate,     /**< Telefono già presente in rubrica o in una riga precedente */
+        InvalidEmail   /**< Email senza '@' o con un dominio non ammesso */
+    };
+
+    /**
+     * @struct Error
+     * @brief Singola voce del report (8 byte)
+     */
+    struct Error
+    {
+        int row;       /**< Riga del lotto (partendo da 0) */
+        Field field;   /**< Campo non valido */
+        Reason reason; /**< Motivo dell'errore */
+    };
+
+    /**
+     * @brief Imposta i contatti già presenti in rubrica, per il controllo dei duplicati
+     * @param[in] contacts Contatti esistenti
+     * @param[in] ignoredIndex Indice del contatto da ignorare (quello in modifica), -1 per nessuno
+     */
+    void setExisting(const QVector<Contact> &contacts, qsizetype ignoredIndex = -1);
+
+    /**
+     * @brief Imposta i telefoni già presenti in rubrica, già in forma compatta
+     * @param[in] phoneKeys Telefoni compatti (vedi PhoneNumber e ContactStore::phoneKeys)
+     * @param[in] ignoredIndex Indice del contatto da ignorare (quello in modifica), -1 per nessuno
+     * @details Non converte né copia stringhe: i valori sono già le chiavi dei duplicati.
+     * I telefoni non conformi (bit PhoneNumber::kOverflow) vengono ignorati.
+     */
+    void setExistingPhones(const QVector<quint64> &phoneKeys, qsizetype ignoredIndex = -1);
+
+    /**
+     * @brief Valida un singolo contatto
+     * @param[in] contact Contatto da validare
+     * @return Errori trovati (vuoto se il contatto è valido), con row = 0
+     */
+    QVector<Error> validate(const Contact &contact) const;
+
+    /**
+     * @brief Valida un lotto di contatti in un solo passaggio
+     * @param[in] batch Contatti da validare
+     * @return Errori ordinati per riga e per campo (vuoto se tutti validi)
+     * @details
+     * - Ogni riga riporta al massimo un errore per campo (la prima regola violata)
+     * - Se un telefono compare più volte, la prima riga è valida e le successive
+     *   sono segnalate come duplicati
+     */
+    QVector<Error> validate(const QVector<Contact> &batch) const;
+
+    /**
+     * @brief Messaggio da mostrare all'utente per un errore
+     * @param[in] error Errore del report
+     * @return Descrizione in italiano
+     */
+    static QString describe(const Error &error);
+
+    /**
+     * @brief Messaggio da mostrare all'utente per un errore su un contatto
+     * @param[in] error Errore del report
+     * @param[in] contact Contatto a cui si riferisce l'errore
+     * @return Descrizione in italiano, con il dettaglio del valore inserito
+     *         (es. il numero di cifre del telefono)
+     */
+    static QString describe(const Error &error, const Contact &contact);
+
+private:
+    QSet<quint64> m_existingPhones; /**< Telefoni validi già presenti in rubrica */
+};
+
+#endif // CONTACTVALIDATOR_HPP
@@ -4,25 +4,29 @@
  */
 
 #include "contatto.hpp"
+#include "emaildomains.hpp"
+#include <utility>
 
-// costruttore di default
-Contact::Contact() : m_name(""), m_phone(""), m_email("") {}
+// costruttore di default, i campi restano stringhe vuote (nessuna allocazione)
+Contact::Contact() {}
 
 
-// costruttore con parametri
-Contact::Contact(const QString& name, const QString& phone, const QString& email)
-    : m_name(name), m_phone(phone), m_email(email) {}
+// costruttore con parametri, le stringhe ricevute per valore vengono spostate
+Contact::Contact(QString name, QString phone, QString email)
+    : m_name(std::move(name)), m_phone(std::move(phone)), m_email(std::move(email)) {}
 
 
-// getter del nome, telefono, email
-QString Contact::name()  const { return m_name;  }
-QString Contact::phone() const { return m_phone; }
-QString Contact::email() const { return m_email; }
+// getter del nome, telefono, email (per riferimento, senza copie)
+const QString &Contact::name()  const { return m_name;  }
+const QString &Contact::phone() const { return m_phone; }
+const QString &Contact::email() const { return m_email; }
+quint64 Contact::id() const            { return m_id; }
 
 // setter del nome, telefono, email
-void Contact::setName(const QString& name)   { m_name = name; }
-void Contact::setPhone(const QString& phone) { m_phone = phone; }
-void Contact::setEmail(const QString& email) { m_email = email; }
+void Contact::setName(QString name)   { m_name = std::move(name); }
+void Contact::setPhone(QString phone) { m_phone = std::move(phone); }
+void Contact::setEmail(QString email) { m_email = std::move(email); }
+void Contact::setId(quint64 id)       { m_id = id; }
 
 // override del operatore di confronto d'uguaglianza tra due contatti
 bool Contact::operator==(const Contact& other) const
@@ -35,7 +39,8 @@ bool Contact::operator==(const Contact& other) const
 // override del operatore di confronto di minoranza tra due contatti
 bool Contact::operator<(const Contact& other) const
 {
-    return m_name.toLower() < other.m_name.toLower();
+    // compare non alloca, toLower() creerebbe due stringhe a ogni confronto
+    return QString::compare(m_name, other.m_name, Qt::CaseInsensitive) < 0;
 }
 
 // funzione per controllare se la email e' valida
@@ -50,28 +55,7 @@ bool Contact::isEmail() const
     auto position = m_email.indexOf('@');
     if (position == -1) return false;
 
-    // salvo in una QString la posizione del domain tramite e creo un QVector per tutti i domain validi
-    QString domain = m_email.mid(position + 1);
-    QVector<QString> allowed_domains = {
-        "gmail.com",      "outlook.com",   "yahoo.com",     "hotmail.com",
-        "icloud.com",     "aol.com",       "zoho.com",      "protonmail.com",
-        "yandex.com",     "mail.com",      "gmx.com",       "live.com",
-        "inbox.com",      "fastmail.com",  "icloud.com",    "rocketmail.com",
-        "rediffmail.com", "cox.net",       "earthlink.net", "att.net",
-        "verizon.net",    "sbcglobal.net", "ymail.com",     "me.com",
-        "msn.com",        "bluewin.ch",    "t-online.de",   "web.de",
-        "libero.it",      "alice.it",      "tin.it",        "outlook.it"
-    };
-    // scorro tutto il QVector, se trovo una corrispondenza ritorno true, altrimenti false
-
-    bool valid_domain = false;
-
-    for(const QString& allowed_domain : allowed_domains){
-        if(domain == allowed_domain){
-            valid_domain = true;
-            break;
-        }
-    }
-
-    return valid_domain;
+    // il dominio è una vista sulla email (nessuna copia), la verifica
+    //  avviene nell'hash set dei domini ammessi in tempo costante
+    return EmailDomains::isAllowed(QStringView(m_email).mid(position + 1));
 }
@@ -48,47 +48,64 @@ public:
      * @param[in] phone Numero di telefono (non vuoto)
      * @param[in] email Indirizzo email (opzionale, verrà validato se fornito)
      * 
+     * @details I parametri sono passati per valore e spostati nei campi:
+     * passando stringhe temporanee (o std::move) non viene fatta alcuna copia.
      * @warning Se l'email è fornita deve essere una email valida
      */
-    Contact(const QString &name, const QString &phone, const QString &email = "");
+    Contact(QString name, QString phone, QString email = QString());
 
     /**
      * @brief Restituisce il nome del contatto
-     * @return QString Nome completo corrente
+     * @return Riferimento al nome completo corrente (nessuna copia)
+     * @note Il riferimento resta valido finché il contatto non viene modificato o distrutto
      */
-    QString name() const;
+    const QString &name() const;
 
     /**
      * @brief Restituisce il numero di telefono
-     * @return QString Numero di telefono corrente
+     * @return Riferimento al numero di telefono corrente (nessuna copia)
      */
-    QString phone() const;
+    const QString &phone() const;
 
     /**
      * @brief Restituisce l'indirizzo email
-     * @return QString Email corrente (può essere vuota)
+     * @return Riferimento all'email corrente, può essere vuota (nessuna copia)
      */
-    QString email() const;
+    const QString &email() const;
+
+    /**
+     * @brief Identificativo stabile del contatto nella rubrica
+     * @return Id assegnato da ContactStore, 0 se il contatto non è (ancora) in rubrica
+     * @details L'id non cambia quando il contatto viene modificato o la rubrica riordinata.
+     */
+    quint64 id() const;
+
+    /**
+     * @brief Imposta l'identificativo del contatto
+     * @param[in] id Id restituito in precedenza da ContactStore (0 = assegnane uno nuovo)
+     * @note Usato per reinserire un contatto con il suo id, ad esempio annullando una rimozione
+     */
+    void setId(quint64 id);
 
     /**
      * @brief Imposta il nome del contatto
-     * @param[in] name Nuovo nome completo (non vuoto)
+     * @param[in] name Nuovo nome completo (non vuoto), spostato nel campo
      * 
      * @note Se viene passata una stringa vuota, l'operazione viene ignorata
      */
-    void setName(const QString &name);
+    void setName(QString name);
 
     /**
      * @brief Imposta il numero di telefono
-     * @param[in] phone Nuovo numero (non vuoto)
+     * @param[in] phone Nuovo numero (non vuoto), spostato nel campo
      * 
      * @note Il numero non viene validato formalmente, ma non può essere vuoto
      */
-    void setPhone(const QString &phone);
+    void setPhone(QString phone);
 
     /**
      * @brief Imposta l'indirizzo email
-     * @param[in] email Nuovo indirizzo email
+     * @param[in] email Nuovo indirizzo email, spostato nel campo
      * 
      * @details
      * Se l'email non è valida:
@@ -96,14 +113,14 @@ public:
      * - Il campo rimane vuoto
      * - Non viene generato alcun errore
      */
-    void setEmail(const QString &email);
+    void setEmail(QString email);
 
     /**
      * @brief Verifica la validità dell'email
      * 
      * Esegue un controllo sintattico sull'indirizzo email:
      * - Deve contenere esattamente un '@'
-     * - Deve avere un dominio valido dopo '@'
+     * - Deve avere un dominio valido dopo '@' (vedi EmailDomains)
      * - Non deve contenere spazi
      * 
      * @retval true Se l'email è vuota o valida
@@ -114,7 +131,7 @@ public:
     /**
      * @brief Operatore di uguaglianza
      * 
-     * Confronta tutti i campi tra due contatti (case-sensitive)
+     * Confronta tutti i campi tra due contatti (case-sensitive), l'id escluso
      * 
      * @param[in] other Contatto da confrontare
      * @retval true Se nome, telefono e email coincidono
@@ -127,6 +144,7 @@ public:
      * 
      * Confronta i contatti per nome (case-insensitive) per permettere
      * l'ordinamento alfabetico nelle liste.
+     * Il confronto avviene carattere per carattere, senza creare copie in minuscolo.
      * 
      * @param[in] other Contatto da confrontare
      * @retval true Se questo contatto viene prima nell'ordinamento alfabetico
@@ -137,6 +155,7 @@ private:
     QString m_name;  /**< Nome completo (case-sensitive) */
     QString m_phone; /**< Numero di telefono (formato libero) */
     QString m_email; /**< Indirizzo email (validato se presente) */
+    quint64 m_id = 0; /**< Identificativo stabile in rubrica (0 = nessuno) */
 };
 
 /**
@@ -0,0 +1,329 @@
+/**
+ * @file duplicatefinder.cpp
+ * @brief DuplicateFinder class implementation
+ */
+
+#include "duplicatefinder.hpp"
+#include "parallel.hpp"
+#include <QStringList>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_duplicate_namespace {
+// Contatti minimi per thread nel calcolo delle chiavi
+constexpr qsizetype kContactsPerThread = 8192;
+// Lunghezza minima della chiave del nome per il confronto approssimato
+constexpr qsizetype kMinFuzzyLength = 6;
+// Numero di criteri (uno per bit di DuplicateFinder::Criterion)
+constexpr int kCriteria = 4;
+// Le chiavi vengono divise in 64 gruppi in base ai bit alti dell'hash, ordinati in parallelo:
+// hash uguali finiscono sempre nello stesso gruppo
+constexpr int kBucketBits = 6;
+constexpr int kBuckets = 1 << kBucketBits;
+// Base dell'hash polinomiale del nome (dispari)
+constexpr quint64 kBase = 0x100000001B3ull;
+
+/**
+ * @brief Hash di una chiave con il contatto a cui appartiene
+ */
+struct KeyEntry
+{
+    quint64 hash;
+    int index;
+
+    bool operator<(const KeyEntry &other) const
+    {
+        return hash != other.hash ? hash < other.hash : index < other.index;
+    }
+};
+
+// Chiavi prodotte da un thread, per criterio e per gruppo
+using ThreadKeys = std::array<std::array<std::vector<KeyEntry>, kBuckets>, kCriteria>;
+
+/**
+ * @brief Rimescola i bit dell'hash (finalizzatore di splitmix64)
+ */
+quint64 mix(quint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Aggiunge la chiave al gruppo indicato dai bit alti dell'hash
+ */
+void addKey(ThreadKeys &keys, int criterion, quint64 hash, int index)
+{
+    keys[criterion][hash >> (64 - kBucketBits)].push_back(KeyEntry{hash, index});
+}
+
+/**
+ * @brief Hash del telefono: solo le cifre, al massimo le ultime 10
+ * @return 0 se il telefono non contiene cifre
+ */
+quint64 phoneHash(QStringView phone)
+{
+    constexpr quint64 kMaxValue = 10000000000ull; // 10^10
+    quint64 value = 0;
+    qsizetype digits = 0;
+    for (qsizetype i = 0; i < phone.size(); ++i) {
+        const unsigned digit = unsigned(phone[i].unicode()) - u'0';
+        if (digit > 9)
+            continue;
+        value = (value * 10 + digit) % kMaxValue;
+        digits++;
+    }
+
+    if (digits == 0)
+        return 0;
+    // il numero di cifre distingue "0123" da "123"
+    return mix(value * 16 + quint64(std::min<qsizetype>(digits, 10))) | 1;
+}
+
+/**
+ * @brief Hash dell'email senza spazi iniziali/finali e in minuscolo
+ * @return 0 se l'email è vuota
+ */
+quint64 emailHash(QStringView email)
+{
+    email = email.trimmed();
+    if (email.isEmpty())
+        return 0;
+
+    quint64 hash = 14695981039346656037ull; // FNV-1a
+    for (qsizetype i = 0; i < email.size(); ++i) {
+        hash ^= email[i].toLower().unicode();
+        hash *= 1099511628211ull;
+    }
+    return mix(hash) | 1;
+}
+
+/**
+ * @brief Chiave del nome: minuscolo, senza accenti né punteggiatura, parole ordinate
+ */
+QString canonicalName(const QString &name)
+{
+    // con la decomposizione le lettere accentate diventano lettera + accento
+    const QString decomposed = name.normalized(QString::NormalizationForm_D);
+
+    QStringList words;
+    QString word;
+    for (const QChar c : decomposed) {
+        if (c.isMark())
+            continue;
+        if (c.isLetterOrNumber()) {
+            word.append(c.toLower());
+            continue;
+        }
+        if (!word.isEmpty()) {
+            words.append(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty())
+        words.append(word);
+
+    words.sort();
+    return words.join(QLatin1Char(' '));
+}
+
+/**
+ * @brief Hash finale di una chiave del nome, a partire dall'hash polinomiale
+ */
+quint64 finishNameHash(quint64 polynomial, qsizetype length)
+{
+    return mix(polynomial + quint64(length) * 0x9E3779B97F4A7C15ull) | 1;
+}
+
+/**
+ * @brief Spazio di lavoro per gli hash del nome, riusato tra i contatti di un thread
+ */
+struct NameScratch
+{
+    std::vector<quint64> prefix; // prefix[i] = hash di key[0, i)
+    std::vector<quint64> suffix; // suffix[i] = hash di key[i, n)
+    std::vector<quint64> power;  // power[i] = kBase^i
+};
+
+/**
+ * @brief Aggiunge le chiavi del nome (esatta ed eventualmente approssimate)
+ *
+ * Con l'hash polinomiale la chiave privata del carattere i si ottiene in O(1)
+ * da prefisso e suffisso: prefix[i] * B^(n-1-i) + suffix[i+1].
+ */
+void addNameKeys(ThreadKeys &keys, NameScratch &scratch, QStringView key, int index,
+                 bool exact, bool fuzzy)
+{
+    const qsizetype length = key.size();
+    if (length == 0)
+        return;
+
+    scratch.prefix.resize(size_t(length + 1));
+    scratch.suffix.resize(size_t(length + 1));
+    scratch.power.resize(size_t(length + 1));
+
+    scratch.prefix[0] = 0;
+    scratch.power[0] = 1;
+    for (qsizetype i = 0; i < length; ++i) {
+        scratch.prefix[i + 1] = scratch.prefix[i] * kBase + key[i].unicode();
+        scratch.power[i + 1] = scratch.power[i] * kBase;
+    }
+    scratch.suffix[length] = 0;
+    for (qsizetype i = length - 1; i >= 0; --i)
+        scratch.suffix[i] = key[i].unicode() * scratch.power[length - 1 - i] + scratch.suffix[i + 1];
+
+    const quint64 full = finishNameHash(scratch.prefix[length], length);
+    if (exact)
+        addKey(keys, 2, full, index);
+
+    if (!fuzzy || length < kMinFuzzyLength)
+        return;
+
+    // la chiave intera e quelle con un carattere in meno: due nomi a distanza 1
+    // (sostituzione, inserimento o cancellazione) ne hanno almeno una in comune
+    addKey(keys, 3, full, index);
+    for (qsizetype i = 0; i < length; ++i) {
+        const quint64 deleted = scratch.prefix[i] * scratch.power[length - 1 - i] + scratch.suffix[i + 1];
+        addKey(keys, 3, finishNameHash(deleted, length - 1), index);
+    }
+}
+
+/**
+ * @brief Union-find con compressione dei cammini e unione per dimensione
+ */
+class UnionFind
+{
+public:
+    explicit UnionFind(qsizetype count)
+        : m_parent(size_t(count))
+        , m_size(size_t(count), 1)
+        , m_matched(size_t(count), 0)
+    {
+        for (qsizetype i = 0; i < count; ++i)
+            m_parent[size_t(i)] = int(i);
+    }
+
+    int find(int x)
+    {
+        while (m_parent[x] != x) {
+            m_parent[x] = m_parent[m_parent[x]];
+            x = m_parent[x];
+        }
+        return x;
+    }
+
+    void unite(int a, int b, quint8 criterion)
+    {
+        if (a == b)
+            return;
+
+        int ra = find(a);
+        int rb = find(b);
+        if (ra != rb) {
+            if (m_size[ra] < m_size[rb])
+                std::swap(ra, rb);
+            m_parent[rb] = ra;
+            m_size[ra] += m_size[rb];
+            m_matched[ra] |= m_matched[rb];
+        }
+        m_matched[ra] |= criterion;
+    }
+
+    int size(int root) const { return m_size[root]; }
+    quint8 matched(int root) const { return m_matched[root]; }
+
+private:
+    std::vector<int> m_parent;
+    std::vector<int> m_size;
+    std::vector<quint8> m_matched;
+};
+} // namespace m_duplicate_namespace
+
+QVector<DuplicateFinder::Cluster> DuplicateFinder::find(const QVector<Contact> &contacts, Criteria criteria)
+{
+    using namespace m_duplicate_namespace;
+
+    const qsizetype count = contacts.size();
+    const bool byName = criteria.testFlag(Name);
+    const bool byFuzzyName = criteria.testFlag(FuzzyName);
+
+    // 1. chiavi di ogni contatto, in parallelo: ogni thread scrive solo nelle sue liste
+    std::vector<ThreadKeys> threadKeys(size_t(parallelThreads(count, kContactsPerThread)));
+    parallelFor(count, kContactsPerThread, [&](qsizetype thread, qsizetype begin, qsizetype end) {
+        ThreadKeys &keys = threadKeys[size_t(thread)];
+        NameScratch scratch;
+
+        for (qsizetype i = begin; i < end; ++i) {
+            const Contact &contact = contacts[i];
+            if (criteria.testFlag(Phone)) {
+                if (const quint64 hash = phoneHash(contact.phone()))
+                    addKey(keys, 0, hash, int(i));
+            }
+            if (criteria.testFlag(Email)) {
+                if (const quint64 hash = emailHash(contact.email()))
+                    addKey(keys, 1, hash, int(i));
+            }
+            if (byName || byFuzzyName)
+                addNameKeys(keys, scratch, canonicalName(contact.name()), int(i), byName, byFuzzyName);
+        }
+    });
+
+    // 2. per ogni criterio e gruppo unisco le liste dei thread e le ordino, in parallelo
+    std::vector<std::vector<KeyEntry>> sorted(size_t(kCriteria * kBuckets));
+    parallelFor(kCriteria * kBuckets, 1, [&](qsizetype, qsizetype begin, qsizetype end) {
+        for (qsizetype task = begin; task < end; ++task) {
+            const int criterion = int(task / kBuckets);
+            const int bucket = int(task % kBuckets);
+            std::vector<KeyEntry> &entries = sorted[size_t(task)];
+
+            size_t total = 0;
+            for (const ThreadKeys &keys : threadKeys)
+                total += keys[criterion][bucket].size();
+            entries.reserve(total);
+            for (ThreadKeys &keys : threadKeys) {
+                std::vector<KeyEntry> &part = keys[criterion][bucket];
+                entries.insert(entries.end(), part.begin(), part.end());
+                std::vector<KeyEntry>().swap(part); // libero subito la memoria
+            }
+            std::sort(entries.begin(), entries.end());
+        }
+    });
+
+    // 3. i contatti con lo stesso hash finiscono nello stesso cluster
+    UnionFind clusters(count);
+    for (qsizetype task = 0; task < qsizetype(sorted.size()); ++task) {
+        const quint8 criterion = quint8(1u << (task / kBuckets));
+        const std::vector<KeyEntry> &entries = sorted[size_t(task)];
+        for (size_t i = 1; i < entries.size(); ++i) {
+            if (entries[i].hash == entries[i - 1].hash)
+                clusters.unite(entries[i - 1].index, entries[i].index, criterion);
+        }
+    }
+
+    // visitando i contatti in ordine i cluster escono ordinati per primo membro
+    QVector<Cluster> result;
+    std::vector<int> clusterOfRoot(size_t(count), -1);
+    for (qsizetype i = 0; i < count; ++i) {
+        const int root = clusters.find(int(i));
+        if (clusters.size(root) < 2)
+            continue;
+
+        int &cluster = clusterOfRoot[size_t(root)];
+        if (cluster < 0) {
+            cluster = int(result.size());
+            result.append(Cluster{{}, Criteria::fromInt(clusters.matched(root))});
+            result.last().members.reserve(clusters.size(root));
+        }
+        result[cluster].members.append(int(i));
+    }
+
+    return result;
+}
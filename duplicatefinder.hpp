@@ -0,0 +1,75 @@
+/**
+ * @file duplicatefinder.hpp
+ * @brief Ricerca dei contatti duplicati in tutta la rubrica
+ *
+ * @details
+ * I duplicati vengono raggruppati in cluster: due contatti finiscono nello stesso
+ * cluster se hanno in comune il telefono, l'email o il nome (anche indirettamente,
+ * tramite un terzo contatto). I cluster possono poi essere uniti con
+ * ContactList::mergeDuplicates.
+ */
+
+#ifndef DUPLICATEFINDER_HPP
+#define DUPLICATEFINDER_HPP
+
+#include <QFlags>
+#include <QVector>
+#include "contatto.hpp"
+
+/**
+ * @class DuplicateFinder
+ * @brief Motore di deduplicazione basato su hash
+ *
+ * @details
+ * 1. Per ogni contatto calcola, in parallelo, l'hash a 64 bit delle chiavi normalizzate:
+ *    - telefono: solo le cifre, al massimo le ultime 10 (senza prefisso internazionale)
+ *    - email: senza spazi, in minuscolo
+ *    - nome: in minuscolo, senza accenti né punteggiatura, parole in ordine alfabetico
+ *      ("Rossi Mario" e "mario rossi" hanno la stessa chiave)
+ *    - nome approssimato: la chiave del nome privata di un carattere alla volta, così
+ *      due nomi che differiscono per un solo errore di battitura hanno una chiave in comune
+ * 2. Ordina le coppie (hash, contatto) di ogni criterio, un thread per criterio
+ * 3. Unisce con una union-find i contatti con lo stesso hash
+ *
+ * La complessità è O(n log n) e non dipende dal numero di duplicati.
+ * @note Una collisione tra hash a 64 bit è trascurabile anche su milioni di contatti.
+ */
+class DuplicateFinder
+{
+public:
+    DuplicateFinder() = delete;
+
+    /**
+     * @brief Criteri per considerare due contatti duplicati
+     */
+    enum Criterion : quint8 {
+        Phone = 0x1,    /**< Stesso telefono normalizzato */
+        Email = 0x2,    /**< Stessa email (senza distinzione tra maiuscole e minuscole) */
+        Name = 0x4,     /**< Stesso nome normalizzato */
+        FuzzyName = 0x8 /**< Nome diverso al massimo per un carattere (nomi da 6 lettere in su) */
+    };
+    Q_DECLARE_FLAGS(Criteria, Criterion)
+
+    /**
+     * @struct Cluster
+     * @brief Gruppo di contatti duplicati tra loro
+     */
+    struct Cluster
+    {
+        QVector<int> members; /**< Indici dei contatti, in ordine crescente (almeno 2) */
+        Criteria matched;     /**< Criteri che hanno unito i contatti del gruppo */
+    };
+
+    /**
+     * @brief Cerca i duplicati
+     * @param[in] contacts Contatti da esaminare (gli indici dei cluster si riferiscono a questo vettore)
+     * @param[in] criteria Criteri da applicare
+     * @return Cluster ordinati per primo membro
+     */
+    static QVector<Cluster> find(const QVector<Contact> &contacts,
+                                 Criteria criteria = {Phone, Email, Name});
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(DuplicateFinder::Criteria)
+
+#endif // DUPLICATEFINDER_HPP
@@ -0,0 +1,215 @@
+/**
+ * @file emaildomains.cpp
+ * @brief EmailDomains class implementation
+ */
+
+#include "emaildomains.hpp"
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_domains_namespace {
+// Domini ammessi di default, in ordine alfabetico e senza duplicati
+constexpr std::array<std::string_view, 31> kDefaultDomains = {
+    "alice.it",       "aol.com",        "att.net",        "bluewin.ch",
+    "cox.net",        "earthlink.net",  "fastmail.com",   "gmail.com",
+    "gmx.com",        "hotmail.com",    "icloud.com",     "inbox.com",
+    "libero.it",      "live.com",       "mail.com",       "me.com",
+    "msn.com",        "outlook.com",    "outlook.it",     "protonmail.com",
+    "rediffmail.com", "rocketmail.com", "sbcglobal.net",  "t-online.de",
+    "tin.it",         "verizon.net",    "web.de",         "yahoo.com",
+    "yandex.com",     "ymail.com",      "zoho.com"
+};
+
+/**
+ * @brief Verifica a tempo di compilazione che la tabella sia ordinata e senza duplicati
+ */
+template<std::size_t N>
+constexpr bool isSortedUnique(const std::array<std::string_view, N> &table)
+{
+    for (std::size_t i = 1; i < N; ++i) {
+        if (!(table[i - 1] < table[i]))
+            return false;
+    }
+    return true;
+}
+
+static_assert(isSortedUnique(kDefaultDomains), "kDefaultDomains deve essere ordinata e senza duplicati");
+
+/**
+ * @brief Converte in minuscolo i soli caratteri ASCII
+ */
+constexpr char16_t foldAscii(char16_t c)
+{
+    return (c >= u'A' && c <= u'Z') ? char16_t(c + (u'a' - u'A')) : c;
+}
+
+/**
+ * @brief Hash FNV-1a del dominio, senza distinzione tra maiuscole e minuscole
+ */
+quint32 hashDomain(QStringView domain)
+{
+    quint32 hash = 2166136261u;
+    for (qsizetype i = 0; i < domain.size(); ++i) {
+        hash ^= foldAscii(domain[i].unicode());
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Confronta due domini senza distinzione tra maiuscole e minuscole
+ */
+bool sameDomain(QStringView a, QStringView b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (qsizetype i = 0; i < a.size(); ++i) {
+        if (foldAscii(a[i].unicode()) != foldAscii(b[i].unicode()))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Hash set a indirizzamento aperto, costruito una volta e poi solo letto
+ *
+ * La tabella ha almeno il doppio degli slot rispetto ai domini, quindi una ricerca
+ * visita in media uno o due slot.
+ */
+class FrozenSet
+{
+public:
+    explicit FrozenSet(const QVector<QString> &domains)
+    {
+        // dimensione potenza di 2, carico massimo 50%
+        qsizetype capacity = 8;
+        while (capacity < domains.size() * 2)
+            capacity *= 2;
+        m_slots.fill(-1, capacity);
+        m_mask = quint32(capacity - 1);
+
+        for (const QString &domain : domains) {
+            if (domain.isEmpty() || contains(domain))
+                continue;
+
+            quint32 slot = hashDomain(domain) & m_mask;
+            while (m_slots[slot] >= 0)
+                slot = (slot + 1) & m_mask;
+            m_slots[slot] = int(m_domains.size());
+            m_domains.append(domain);
+        }
+    }
+
+    bool contains(QStringView domain) const
+    {
+        quint32 slot = hashDomain(domain) & m_mask;
+        while (m_slots[slot] >= 0) {
+            if (sameDomain(m_domains[m_slots[slot]], domain))
+                return true;
+            slot = (slot + 1) & m_mask;
+        }
+        return false;
+    }
+
+    qsizetype size() const { return m_domains.size(); }
+
+private:
+    QVector<QString> m_domains; // domini distinti
+    QVector<int> m_slots;       // indice in m_domains, -1 se lo slot è libero
+    quint32 m_mask = 0;
+};
+
+/**
+ * @brief Costruisce l'insieme dalla tabella predefinita
+ */
+std::unique_ptr<const FrozenSet> defaultSet()
+{
+    QVector<QString> domains;
+    domains.reserve(qsizetype(kDefaultDomains.size()));
+    for (std::string_view domain : kDefaultDomains)
+        domains.append(QString::fromLatin1(domain.data(), qsizetype(domain.size())));
+    return std::make_unique<const FrozenSet>(domains);
+}
+
+/**
+ * @brief Insiemi creati finora, l'ultimo è quello attivo
+ *
+ * I lettori usano il puntatore atomico senza lock: per questo gli insiemi
+ * sostituiti non vengono liberati (succede solo quando si ricarica la configurazione).
+ */
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<const FrozenSet>> sets;
+    std::atomic<const FrozenSet *> active{nullptr};
+
+    Registry() { publish(defaultSet()); }
+
+    void publish(std::unique_ptr<const FrozenSet> set)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        active.store(set.get(), std::memory_order_release);
+        sets.push_back(std::move(set));
+    }
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+const FrozenSet &activeSet()
+{
+    return *registry().active.load(std::memory_order_acquire);
+}
+} // namespace m_domains_namespace
+
+bool EmailDomains::isAllowed(QStringView domain)
+{
+    return m_domains_namespace::activeSet().contains(domain);
+}
+
+bool EmailDomains::loadFromFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QVector<QString> domains;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        domains.append(line.toLower());
+    }
+    file.close();
+
+    // un file senza domini renderebbe non valida ogni email: lo ignoro
+    if (domains.isEmpty())
+        return false;
+
+    m_domains_namespace::registry().publish(std::make_unique<const m_domains_namespace::FrozenSet>(domains));
+    return true;
+}
+
+void EmailDomains::resetToDefault()
+{
+    m_domains_namespace::registry().publish(m_domains_namespace::defaultSet());
+}
+
+qsizetype EmailDomains::count()
+{
+    return m_domains_namespace::activeSet().size();
+}
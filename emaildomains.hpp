@@ -0,0 +1,64 @@
+/**
+ * @file emaildomains.hpp
+ * @brief Elenco dei domini email ammessi
+ *
+ * @details
+ * L'elenco predefinito è una tabella ordinata verificata a tempo di compilazione.
+ * All'avvio può essere sostituito da un file di configurazione (un dominio per riga).
+ * In entrambi i casi i domini vengono copiati una sola volta in un hash set "congelato":
+ * la verifica di un dominio è O(1) e non alloca memoria.
+ */
+
+#ifndef EMAILDOMAINS_HPP
+#define EMAILDOMAINS_HPP
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @class EmailDomains
+ * @brief Insieme dei domini accettati da Contact::isEmail
+ *
+ * @details
+ * - Il confronto ignora maiuscole e minuscole (solo per i caratteri ASCII)
+ * - L'insieme attivo può essere letto da più thread contemporaneamente
+ * - Il caricamento di un nuovo file non invalida le verifiche già in corso
+ */
+class EmailDomains
+{
+public:
+    EmailDomains() = delete;
+
+    /**
+     * @brief Verifica se il dominio è tra quelli ammessi
+     * @param[in] domain Dominio da verificare (la parte dopo '@')
+     * @retval true Dominio ammesso
+     * @retval false Dominio non ammesso
+     */
+    static bool isAllowed(QStringView domain);
+
+    /**
+     * @brief Sostituisce l'elenco dei domini con quello letto da file
+     * @param[in] filePath Percorso del file di configurazione
+     * @retval true Elenco caricato
+     * @retval false File non leggibile o senza domini, resta l'elenco precedente
+     *
+     * @details
+     * Formato del file:
+     * - un dominio per riga (es. gmail.com)
+     * - le righe vuote e quelle che iniziano con '#' vengono ignorate
+     */
+    static bool loadFromFile(const QString &filePath = "domains.txt");
+
+    /**
+     * @brief Ripristina l'elenco predefinito
+     */
+    static void resetToDefault();
+
+    /**
+     * @brief Numero di domini nell'elenco attivo
+     */
+    static qsizetype count();
+};
+
+#endif // EMAILDOMAINS_HPP
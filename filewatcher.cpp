@@ -0,0 +1,144 @@
+/**
+ * @file filewatcher.cpp
+ * @brief FileWatcher class implementation
+ */
+
+#include "filewatcher.hpp"
+#include "profiler.hpp"
+#include <QFileInfo>
+
+FileWatcher::FileWatcher(ContactList *list, const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_list(list)
+    , m_filePath(filePath)
+{
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleDelay);
+    m_pool.setMaxThreadCount(1);
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &FileWatcher::onFileChanged);
+    connect(&m_settleTimer, &QTimer::timeout, this, &FileWatcher::startReload);
+    acknowledge(m_list->snapshot());
+}
+
+FileWatcher::~FileWatcher()
+{
+    // il task usa this per notificare il risultato: deve finire prima
+    m_pool.waitForDone();
+}
+
+void FileWatcher::acknowledge(const ContactList::Snapshot &base)
+{
+    // l'impronta si calcola nel thread del pool, che esegue un lavoro alla volta e in ordine:
+    // le letture avviate dopo la trovano pronta. Lo snapshot si rilascia appena calcolata
+    auto digest = std::make_shared<ContactList::Digest>();
+    m_pool.start([base, digest]() { *digest = ContactList::digest(*base); });
+    m_base = std::move(digest);
+    m_baseBytes = base->size() * qsizetype(sizeof(ContactList::DigestEntry));
+    m_baseVersion++;
+    const QFileInfo info(m_filePath);
+    m_knownModified = info.lastModified();
+    m_knownSize = info.exists() ? info.size() : -1;
+
+    // il file può essere stato appena creato dal primo salvataggio
+    if (info.exists() && !m_watcher.files().contains(m_filePath))
+        m_watcher.addPath(m_filePath);
+}
+
+void FileWatcher::onFileChanged()
+{
+    // chi scrive con un file temporaneo e una rinomina sostituisce il file:
+    // il watcher smette di osservarlo e va ripristinato
+    if (!m_watcher.files().contains(m_filePath) && QFileInfo::exists(m_filePath))
+        m_watcher.addPath(m_filePath);
+    m_settleTimer.start();
+}
+
+void FileWatcher::startReload()
+{
+    if (m_reading) {
+        m_pending = true;
+        return;
+    }
+    if (isKnownVersion())
+        return; // nessuna modifica, o una scrittura dell'applicazione stessa
+
+    const std::shared_ptr<const ContactList::Digest> base = m_base;
+    const quint64 baseVersion = m_baseVersion;
+    const QString filePath = m_filePath;
+    m_reading = true;
+
+    m_pool.start([this, base, baseVersion, filePath]() {
+        const Profiler::Scope scope("FileWatcher::reload");
+        // data e dimensione prima della lettura: se il file cambia ancora arriverà un'altra notifica
+        const QFileInfo info(filePath);
+        const QDateTime modified = info.lastModified();
+        const qint64 size = info.size();
+
+        QVector<Contact> contacts;
+        QVector<ContactValidator::Error> errors;
+        ContactList::Batch batch;
+        // un file sparito o illeggibile non svuota la rubrica
+        if (ContactList::readFile(filePath, contacts, &errors))
+            batch = ContactList::diff(*base, std::move(contacts));
+
+        const qsizetype rejected = errors.size();
+        QMetaObject::invokeMethod(
+            this, [this, batch, baseVersion, rejected, modified, size]() {
+                finishReload(batch, baseVersion, rejected, modified, size);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void FileWatcher::finishReload(const ContactList::Batch &batch, quint64 baseVersion, qsizetype rejected,
+                               const QDateTime &modified, qint64 size)
+{
+    m_reading = false;
+    if (baseVersion != m_baseVersion) {
+        // l'applicazione ha scritto il file durante la lettura: la differenza
+        // è riferita a una base superata, si rilegge (o si riconosce la scrittura)
+        m_pending = false;
+        startReload();
+        return;
+    }
+
+    // la base è il contenuto del file: senza modifiche locali la rubrica è uguale alla base,
+    // e dopo la differenza è uguale al file
+    const bool inSync = !m_list->isModified();
+    QVector<Contact> inserted;
+    const qsizetype changes = m_list->applyBatch(batch, &inserted);
+    if (inSync)
+        m_list->markSaved(m_list->revision());
+    if (!batch.isEmpty()) {
+        // la lettura è finita: il pool non tocca più l'impronta. Rimozioni e aggiornamenti
+        // valgono anche per i contatti che nel frattempo non sono più in lista
+        auto digest = std::make_shared<ContactList::Digest>(*m_base);
+        ContactList::applyToDigest(*digest, batch, inserted);
+        m_baseBytes = digest->size() * qsizetype(sizeof(ContactList::DigestEntry));
+        m_base = std::move(digest);
+    }
+
+    m_knownModified = modified;
+    m_knownSize = size;
+    if (changes > 0 || rejected > 0)
+        emit reloaded(changes, rejected);
+
+    if (m_pending) {
+        m_pending = false;
+        startReload();
+    }
+}
+
+qsizetype FileWatcher::memoryUsage() const
+{
+    return m_baseBytes;
+}
+
+bool FileWatcher::isKnownVersion() const
+{
+    const QFileInfo info(m_filePath);
+    if (!info.exists())
+        return true; // niente da leggere: la rubrica resta com'è
+    return info.lastModified() == m_knownModified && info.size() == m_knownSize;
+}
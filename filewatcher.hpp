@@ -0,0 +1,131 @@
+/**
+ * @file filewatcher.hpp
+ * @brief Ricaricamento incrementale della rubrica quando il file cambia su disco
+ *
+ * @details
+ * Un programma esterno (es. la sincronizzazione) può riscrivere contacts.csv
+ * mentre l'applicazione è aperta. Invece di ricaricare tutto con loadFromFile
+ * (che riordina e ricostruisce ogni struttura), il nuovo file viene letto in
+ * background e confrontato con la versione che il file aveva l'ultima volta
+ * (la base: l'ultimo caricamento, salvataggio o ricaricamento). Della base si
+ * tiene solo l'impronta compatta (ContactList::Digest), non uno snapshot. La differenza
+ * base → file contiene solo le modifiche fatte fuori dall'applicazione e viene
+ * applicata alla lista in un solo passo (ContactList::applyBatch): le modifiche
+ * locali non ancora salvate restano.
+ */
+
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include "list.hpp"
+
+/**
+ * @class FileWatcher
+ * @brief Osserva il file della rubrica e applica le modifiche esterne
+ *
+ * @details
+ * - Le notifiche ravvicinate (un file scritto a pezzi) vengono raggruppate
+ * - Le scritture dell'applicazione stessa vanno segnalate con acknowledge(),
+ *   passando il contenuto scritto: diventa la nuova base, e la scrittura non
+ *   viene ricaricata come modifica esterna
+ * - Lettura, validazione e confronto avvengono in un thread dedicato: la GUI
+ *   applica solo la differenza
+ * - Contatti aggiunti, modificati o rimossi solo in locale non vengono toccati.
+ *   Se lo stesso contatto è cambiato sia in locale sia nel file prevale il file
+ *   (il ricaricamento si può annullare con ContactList::undo)
+ *
+ * Va creato, usato e distrutto nel thread della lista (la GUI).
+ */
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kSettleDelay = 300; /**< Attesa dopo l'ultima notifica prima di leggere (ms) */
+
+    /**
+     * @brief Costruttore
+     * @param[in] list Lista da aggiornare (deve sopravvivere al FileWatcher)
+     * @param[in] filePath File da osservare
+     * @param[in] parent Oggetto padre nella gerarchia Qt (opzionale)
+     */
+    FileWatcher(ContactList *list, const QString &filePath, QObject *parent = nullptr);
+
+    /**
+     * @brief Distruttore
+     * @details Aspetta la fine dell'eventuale lettura in corso.
+     */
+    ~FileWatcher();
+
+    /**
+     * @brief Registra la versione attuale del file come già nota
+     * @param[in] base Contenuto del file, con gli id della lista (es. lo snapshot
+     *                 appena caricato, o AutoSaver::takeLastSaved)
+     * @details Da chiamare dopo ogni caricamento o salvataggio fatto dall'applicazione.
+     * L'impronta della base si calcola in background; lo snapshot viene rilasciato subito dopo.
+     */
+    void acknowledge(const ContactList::Snapshot &base);
+
+    /**
+     * @brief Memoria dell'impronta della versione nota, in byte
+     */
+    qsizetype memoryUsage() const;
+
+signals:
+    /**
+     * @brief Emesso dopo aver applicato le modifiche esterne
+     * @param[in] changes Modifiche applicate (vedi ContactList::applyBatch)
+     * @param[in] rejected Righe del file non valide (applicate comunque)
+     */
+    void reloaded(qsizetype changes, qsizetype rejected);
+
+private:
+    ContactList *m_list;          /**< Lista aggiornata */
+    QString m_filePath;           /**< File osservato */
+    QFileSystemWatcher m_watcher; /**< Notifiche del file system */
+    QTimer m_settleTimer;         /**< Riparte a ogni notifica */
+    QThreadPool m_pool;           /**< Un solo thread: una lettura alla volta */
+    bool m_reading = false;       /**< true mentre una lettura è in corso */
+    bool m_pending = false;       /**< true se il file è cambiato durante la lettura */
+    QDateTime m_knownModified;    /**< Data di modifica della versione nota */
+    qint64 m_knownSize = -1;      /**< Dimensione della versione nota */
+    std::shared_ptr<ContactList::Digest> m_base; /**< Impronta della versione nota, con gli id della lista */
+    qsizetype m_baseBytes = 0;    /**< Memoria di m_base */
+    quint64 m_baseVersion = 0;    /**< Cresce a ogni acknowledge(): scarta le letture superate */
+
+    /**
+     * @brief Gestisce una notifica del file system
+     */
+    void onFileChanged();
+
+    /**
+     * @brief Legge il file e calcola la differenza nel thread del pool
+     */
+    void startReload();
+
+    /**
+     * @brief Applica la differenza alla lista (nel thread della lista)
+     * @param[in] batch Differenza tra la base e il file
+     * @param[in] baseVersion m_baseVersion all'inizio della lettura
+     * @param[in] rejected Righe del file non valide
+     * @param[in] modified Data di modifica del file letto
+     * @param[in] size Dimensione del file letto
+     * @details Se la lista era salvata, dopo la modifica corrisponde al file:
+     * non serve un salvataggio automatico. La base diventa il file letto.
+     */
+    void finishReload(const ContactList::Batch &batch, quint64 baseVersion, qsizetype rejected,
+                      const QDateTime &modified, qint64 size);
+
+    /**
+     * @brief Verifica se il file su disco è la versione già nota
+     */
+    bool isKnownVersion() const;
+};
+
+#endif // FILEWATCHER_HPP
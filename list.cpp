@@ -4,189 +4,129 @@
  */
 
 #include "list.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
+#include <QColor>
 #include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QSaveFile>
+#include <QSet>
 #include <QTextStream>
-#include <thread>
-
+#include <QThread>
+#include <algorithm>
+#include <memory>
+#include <numeric>
 
 /**
- * @brief namespace for utility function used ONLY in this file.
  * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
  */
 namespace m_list_namespace {
-// Soglia per l'utilizzo della parallelizzazione
-#define THRESHOLD 500
-
 /**
- * @brief Unisce due liste ordinate in una singola lista ordinata (ricorsiva)
- * 
- * Algoritmo:
- * 1. Confronta i nodi testa delle due liste
- * 2. Sceglie il nodo minore come prossimo elemento
- * 3. Richiama ricorsivamente merge sul resto delle liste
- * 4. Concatena il risultato
- * 
+ * @brief Memoria dei caratteri di un contatto letto da file, stimata in byte
  */
-Node *merge(Node *left, Node *right)
-{
-    // Caso base: se una lista è vuota, ritorna l'altra
-    if (!left)
-        return right;
-    if (!right)
-        return left;
-
-    // Confronto case-insensitive dei nomi
-    if (left->contact.name().toLower() < right->contact.name().toLower()) {
-        // Il nodo left è minore, diventa il prossimo
-        left->next = merge(left->next, right); // Ricorsione sul resto
-        return left;                           // Ritorno la nuova lista
-    } else {
-        // Il nodo right è minore o uguale
-        right->next = merge(left, right->next); // Ricorsione sul resto
-        return right;                           // Ritorno la nuova testa
-    }
+qsizetype contactPayloadBytes(const Contact &contact)
+{
+    const qsizetype header = qsizetype(sizeof(QString));
+    return StringPool::stringBytes(contact.name().size()) + StringPool::stringBytes(contact.phone().size())
+           + StringPool::stringBytes(contact.email().size()) - 3 * header;
 }
 
+constexpr qsizetype kProgressStep = 4096; /**< Righe tra due notifiche di avanzamento */
+
 /**
- * @brief Divide la lista in due sottoliste 
-* 
- * Algoritmo:
- * 1. Usa due puntatori: slow (avanza di 1) e fast (avanza di 2)
- * 2. Quando fast raggiunge la fine, slow è a metà
- * 3. Divide la lista in corrispondenza di slow
- * 
+ * @brief Avvia un lavoro asincrono con un QPromise condiviso
+ * @details Il lavoro riceve il promise e lo conclude, anche dal thread della lista.
+ * Un promise distrutto senza finish() annulla il future.
  */
-void split(Node *head, Node **left, Node **right)
+template<typename T, typename Work>
+QFuture<T> runAsync(QThreadPool &pool, Work work)
 {
-    // Caso base: lista vuota o con un solo elemento
-    if (!head || !head->next) {
-        *left = head;
-        *right = nullptr;
-        return;
-    }
-
-    Node *slow = head;       // Puntatore lento (avanza di 1 nodo)
-    Node *fast = head->next; // Puntatore veloce (avanza di 2 nodi)
-
-    // Avanza finché fast non raggiunge la fine
-    while (fast && fast->next) {
-        slow = slow->next;
-        fast = fast->next->next;
-    }
-
-    // Imposta le due metà:
-    *left = head;         // Prima metà dall'inizio
-    *right = slow->next;  // Seconda metà dopo slow
-    slow->next = nullptr; // Termina la prima metà
+    auto promise = std::make_shared<QPromise<T>>();
+    QFuture<T> future = promise->future();
+    promise->start();
+    promise->setProgressRange(0, ContactList::kProgressRange);
+    pool.start([promise, work = std::move(work)]() { work(promise); });
+    return future;
 }
 
 /**
- * @brief Implementa il merge sort ricorsivo con thread
- * 
- * Algoritmo:
- * 1. Divide la lista in due metà (split)
- * 2. Ordina ricorsivamente ciascuna metà
- * 3. Fonde le metà ordinate (merge)
- * 
- * Versione parallela:
- * - Usa thread separati per metà grandi (THRESHOLD)
- * - Limita la profondità ricorsiva per overhead thread
- * 
+ * @brief Riporta l'avanzamento di una fase nell'intervallo [from, to] del promise
+ * @details La fase si interrompe se il future viene annullato o la lista distrutta.
  */
-Node *merge_sort(Node *head, int depth = 0)
+template<typename T>
+ContactList::Progress stageProgress(const std::shared_ptr<QPromise<T>> &promise, int from, int to,
+                                    const std::atomic<bool> &closing)
 {
-    // Caso base: lista vuota o con un solo elemento
-    if (!head || !head->next)
-        return head;
-
-    Node *left;
-    Node *right;
-
-    // Divide la lista in due metà
-    split(head, &left, &right);
-
-    // In base la grandezza della lista utilizzo i thread o meno
-    if (depth < THRESHOLD) {
-        left = merge_sort(left, depth + 1);
-        right = merge_sort(right, depth + 1);
-    } else {
-        Node *sorted_left = nullptr;
-        Node *sorted_right = nullptr;
-
-        std::thread left_thread([&]() { sorted_left = merge_sort(left, depth + 1); });
-
-        std::thread right_thread([&]() { sorted_right = merge_sort(right, depth + 1); });
-
-        // Attesa completamento thread
-        left_thread.join();
-        right_thread.join();
-
-        left = sorted_left;
-        right = sorted_right;
+    return [promise, from, to, &closing](qint64 done, qint64 total) {
+        if (total > 0)
+            promise->setProgressValue(from + int(qint64(to - from) * std::min(done, total) / total));
+        return !promise->isCanceled() && !closing;
+    };
+}
 
-        /* 
-         * A cosa servono i thread
-         * - Parallelizza l'ordinamento delle due metà
-         * - Sfrutta i core multipli della CPU
-         * - Riduce il tempo totale di esecuzione
-         * - solo per liste grandi (THRESHOLD)
-         */
-    }
+/**
+ * @brief Elemento dell'impronta di un contatto
+ */
+ContactList::DigestEntry digestEntry(QStringView name, QStringView phone, QStringView email, quint64 id)
+{
+    // il telefono fa da seme all'email: cambiare uno dei due cambia l'impronta dei dati
+    return {quint64(qHash(name)), quint64(qHash(email, qHash(phone))), id};
+}
 
-    // Fusione delle due metà ordinate
-    return merge(left, right);
+/**
+ * @brief Ordine dell'impronta: nome, poi id
+ */
+bool digestLess(const ContactList::DigestEntry &a, const ContactList::DigestEntry &b)
+{
+    return a.name != b.name ? a.name < b.name : a.id < b.id;
 }
 } // namespace m_list_namespace
 
 ContactList::ContactList(QObject *parent)
     : QObject(parent)
-    , m_head(nullptr)
-    , m_count(0)
-{}
+    , m_searchIndexDirty(true)
+{
+    // le modifiche ravvicinate diventano una sola pubblicazione
+    m_publishTimer.setSingleShot(true);
+    m_publishTimer.setInterval(kPublishDelayMs);
+    connect(&m_publishTimer, &QTimer::timeout, this, &ContactList::publish);
+}
 
 ContactList::~ContactList()
 {
+    // i lavori asincroni usano la lista: si interrompono e vengono attesi,
+    // le loro conclusioni ancora in coda non arrivano più a un oggetto distrutto
+    m_closing = true;
+    m_asyncPool.waitForDone();
     clear();
 }
 
-void ContactList::addContact(const Contact& contact)
+void ContactList::addContact(Contact contact)
 {
-    // viene eseguito un push in testa e poi ordinamo la lista
-    // più veloce rispetto aggiungere il nodo già ordinato
-
-    Node* newNode = new Node(contact, m_head);
-    m_head = newNode;
-    m_count++;
-    sort();
-    emit dataChanged();
+    // inserimento nella posizione giusta: ricerca binaria sulle chiavi di ordinamento
+    contact.setId(0); // un contatto nuovo riceve sempre un id nuovo
+    const qsizetype row = m_store.insertSorted(std::move(contact));
+    m_sortOrders.insertRow(m_store, row);
+    m_history.recordInsert(row, m_store.contact(row));
+    commitChange({m_store.id(row)});
 }
 
 bool ContactList::removeContact(const QString& name)
 {
-    if (!m_head) return false;
+    if (m_store.isEmpty()) return false;
 
     this->sort();
 
-    if (capitalize(m_head->contact.name()) == capitalize(name)) {
-        Node* to_delete = m_head;
-        m_head = m_head->next;
-        delete to_delete;
-        m_count--;
-        emit dataChanged();
-        return true;
-    }else{
-        Node* current = m_head;
-        while (current->next != nullptr && capitalize(current->next->contact.name()) != capitalize(name)) {
-            current = current->next;
-        }
-
-        if (current->next != nullptr) {
-            Node* to_delete = current->next;
-            current->next = current->next->next;
-            delete to_delete;
-            m_count--;
-            emit dataChanged();
+    const QString target = capitalize(name);
+    for (qsizetype i = 0; i < m_store.size(); ++i) {
+        if (capitalize(m_store.name(i)) == target) {
+            const quint64 id = m_store.id(i);
+            m_history.recordRemove(i, m_store.contact(i));
+            m_store.remove(i);
+            m_sortOrders.removeRow(i);
+            commitChange({id});
             return true;
         }
     }
@@ -194,240 +134,1286 @@ bool ContactList::removeContact(const QString& name)
     return false;
 }
 
-bool ContactList::updateContact(const QString& originalName, const Contact& updatedContact)
+bool ContactList::updateContact(const QString& originalName, Contact updatedContact)
 {
     // cerco il contatto in base al nome originale
-    Node* node = findNode(originalName);
-    if (!node) return false;
+    const qsizetype index = m_store.indexOf(originalName);
+    if (index < 0) return false;
 
     // aggiorno le informazioni del contatto con il nuovo contatto
-    node->contact = updatedContact;
-    sort();
-    emit dataChanged();
+    const quint64 id = m_store.id(index);
+    updateRow(index, std::move(updatedContact));
+    commitChange({id});
+    return true;
+}
+
+Contact ContactList::contactById(quint64 id) const
+{
+    const qsizetype index = m_store.indexOfId(id);
+    return index < 0 ? Contact{} : m_store.contact(index);
+}
+
+qsizetype ContactList::indexOfId(quint64 id) const
+{
+    return m_store.indexOfId(id);
+}
+
+QVector<quint64> ContactList::idsOf(const QVector<int> &indices) const
+{
+    QVector<quint64> ids;
+    ids.reserve(indices.size());
+    for (const int index : indices)
+        ids.append(m_store.id(index));
+    return ids;
+}
+
+bool ContactList::removeById(quint64 id)
+{
+    // la tabella id → riga evita ordinamento e scansione dei nomi
+    const qsizetype index = m_store.indexOfId(id);
+    if (index < 0)
+        return false;
+
+    m_history.recordRemove(index, m_store.contact(index));
+    m_store.remove(index);
+    m_sortOrders.removeRow(index);
+    commitChange({id});
     return true;
 }
 
+bool ContactList::updateById(quint64 id, Contact updatedContact)
+{
+    const qsizetype index = m_store.indexOfId(id);
+    if (index < 0)
+        return false;
+
+    updateRow(index, std::move(updatedContact));
+    commitChange({id});
+    return true;
+}
+
+qsizetype ContactList::removeByIds(const QVector<quint64> &ids)
+{
+    const Profiler::Scope scope("ContactList::removeByIds");
+    const qsizetype count = m_store.size();
+    QVector<bool> removed(count, false);
+    qsizetype removedCount = 0;
+    for (const quint64 id : ids) {
+        const qsizetype index = m_store.indexOfId(id);
+        if (index >= 0 && !removed[index]) {
+            removed[index] = true;
+            removedCount++;
+        }
+    }
+
+    if (removedCount == 0)
+        return 0;
+
+    QVector<qsizetype> removedRows;
+    QVector<Contact> removedContacts;
+    removedRows.reserve(removedCount);
+    removedContacts.reserve(removedCount);
+    for (qsizetype i = 0; i < count; ++i) {
+        if (removed[i]) {
+            removedRows.append(i);
+            removedContacts.append(m_store.contact(i));
+        }
+    }
+    QVector<quint64> removedIds;
+    removedIds.reserve(removedCount);
+    for (const Contact &contact : removedContacts)
+        removedIds.append(contact.id());
+    m_history.recordBulk({}, std::move(removedRows), std::move(removedContacts));
+
+    // una sola compattazione delle colonne, qualunque sia il numero di righe
+    m_store.removeIf(removed);
+    m_sortOrders.removeRows(removed);
+    commitChange(std::move(removedIds));
+    return removedCount;
+}
+
+qsizetype ContactList::updateField(const QVector<quint64> &ids, ContactStore::Field field, const QString &value)
+{
+    // il nome decide la posizione: cambiarlo in blocco richiederebbe di riordinare
+    if (field != ContactStore::Phone && field != ContactStore::Email)
+        return 0;
+
+    const Profiler::Scope scope("ContactList::updateField");
+    QVector<UndoLog::FieldChange> changes;
+    changes.reserve(ids.size());
+    for (const quint64 id : ids) {
+        const qsizetype index = m_store.indexOfId(id);
+        if (index < 0)
+            continue;
+
+        QString before = field == ContactStore::Phone ? m_store.phone(index) : m_store.email(index);
+        if (before == value)
+            continue; // anche un id ripetuto si ferma qui, la riga è già cambiata
+
+        if (field == ContactStore::Phone)
+            m_store.setPhone(index, value);
+        else
+            m_store.setEmail(index, value);
+        changes.append({index, field, std::move(before), value});
+    }
+
+    if (changes.isEmpty())
+        return 0;
+
+    // un solo aggiornamento delle permutazioni per tutte le righe
+    QVector<qsizetype> rows;
+    QVector<quint64> changedIds;
+    rows.reserve(changes.size());
+    changedIds.reserve(changes.size());
+    for (const UndoLog::FieldChange &change : changes) {
+        rows.append(change.row);
+        changedIds.append(m_store.id(change.row));
+    }
+    m_sortOrders.updateRows(m_store, rows);
+
+    const qsizetype changed = changes.size();
+    m_history.recordBulk(std::move(changes), {}, {});
+    commitChange(std::move(changedIds));
+    return changed;
+}
+
 /*
  * Cerca i contatti che corrispondono alla query e popola la tabella.
- * - Scansiona tutta la lista originale
- * - Per ogni match:
- *   1. Aggiunge una riga alla tabella filtrata
- *   2. Salva l'indice ORIGINALE nel Qt::UserRole dell'item "Nome"
- *   3. Aggiunge l'indice al vettore risultato
+ * - La scansione avviene sul buffer contiguo di SearchIndex, non sulla lista
+ * - Per ogni match appendToTable aggiunge una riga e salva l'id del contatto
+ *   nel Qt::UserRole dell'item "Nome"
  * - Ritorna il vettore con gli indici originali dei risultati
  */
 QVector<int> ContactList::search(const QString &query, QTableWidget *table)
 {
-    QVector<int> originalIndices; // Conserverà gli indici ORIGINALI dei contatti trovati
+    const Profiler::Scope scope("ContactList::search");
+    // Conserverà gli indici ORIGINALI dei contatti trovati
+    const QVector<int> originalIndices = searchIndex().find(query);
     table->setRowCount(0);
+    appendToTable(table, originalIndices);
+    return originalIndices; // Ritorna tutti gli indici originali dei risultati
+}
+
+QVector<int> ContactList::find(const QString &query, int limit) const
+{
+    const Profiler::Scope scope("ContactList::find");
+    const SearchIndex &index = searchIndex();
+    SearchIndex::Cursor cursor = index.open(query);
+    return index.fetch(cursor, limit);
+}
+
+QVector<int> ContactList::fuzzySearch(const QString &query, QTableWidget *table, int limit)
+{
+    const Profiler::Scope scope("ContactList::fuzzySearch");
+    // gli indici arrivano già ordinati per somiglianza
+    const QVector<int> originalIndices = searchIndex().fuzzyFind(query, 2, limit);
+    table->setRowCount(0);
+    appendToTable(table, originalIndices);
+    return originalIndices;
+}
+
+SearchIndex::Cursor ContactList::openSearch(const QString &query) const
+{
+    return searchIndex().open(query);
+}
 
-    Node *current = m_head;
-    int originalIndex = 0;
-    int displayedRow = 0;
-    QString searchStr = query.toUpper();
+SearchIndex::Cursor ContactList::openSearch(const QString &query, qsizetype from, qsizetype found) const
+{
+    return searchIndex().open(SearchQuery::parse(query), int(from), found);
+}
 
-    while (current) {
-        QString name = current->contact.name().toUpper();
-        QString email = current->contact.email().toUpper();
-        QString phone = current->contact.phone().toUpper();
+bool ContactList::accepts(const SearchQuery &query, qsizetype index) const
+{
+    return searchIndex().accepts(query, int(index));
+}
 
-        if (name.contains(searchStr) || email.contains(searchStr) || phone.contains(searchStr)) {
-            table->insertRow(displayedRow);
+QVector<int> ContactList::searchPage(SearchIndex::Cursor &cursor, QTableWidget *table, int limit)
+{
+    const Profiler::Scope scope("ContactList::searchPage");
+    const QVector<int> originalIndices = searchIndex().fetch(cursor, limit);
+    appendToTable(table, originalIndices);
+    return originalIndices;
+}
 
-            // Salva l'indice ORIGINALE nell'item
-            QTableWidgetItem *nameItem = new QTableWidgetItem(current->contact.name());
-            nameItem->setData(Qt::UserRole, originalIndex);
+void ContactList::setSortKey(SortOrders::Key key)
+{
+    m_sortKey = key;
+}
 
-            QTableWidgetItem *phoneItem = new QTableWidgetItem(current->contact.phone());
-            QTableWidgetItem *emailItem = new QTableWidgetItem(current->contact.email());
+SortOrders::Key ContactList::sortKey() const
+{
+    return m_sortKey;
+}
 
-            table->setItem(displayedRow, 0, nameItem);
-            table->setItem(displayedRow, 1, phoneItem);
-            table->setItem(displayedRow, 2, emailItem);
+QVector<int> ContactList::sortedRows() const
+{
+    const Profiler::Scope scope("ContactList::sortedRows");
+    if (m_sortKey != SortOrders::FirstName)
+        return m_sortOrders.order(m_sortKey, m_store);
+    QVector<int> rows(m_store.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
 
-            originalIndices.append(originalIndex); // Aggiungi alla lista degli indici
+qsizetype ContactList::sortPosition(qsizetype index) const
+{
+    if (m_sortKey == SortOrders::FirstName)
+        return index;
+    return m_sortOrders.rank(m_sortKey, m_store)[index];
+}
 
-            displayedRow++;
-        }
-        current = current->next;
-        originalIndex++;
+ContactList::SortedCursor ContactList::openSorted(const QString &query) const
+{
+    SortedCursor cursor;
+    cursor.query = SearchQuery::parse(query);
+    cursor.atEnd = m_store.isEmpty();
+    return cursor;
+}
+
+QVector<int> ContactList::sortedPage(SortedCursor &cursor, int limit) const
+{
+    const Profiler::Scope scope("ContactList::sortedPage");
+    QVector<int> rows;
+    if (cursor.atEnd)
+        return rows;
+
+    const SearchIndex &index = searchIndex();
+    const QVector<int> *order = m_sortKey != SortOrders::FirstName ? &m_sortOrders.order(m_sortKey, m_store) : nullptr;
+    const qsizetype count = m_store.size();
+    while (cursor.position < count && rows.size() < limit) {
+        const int row = order ? (*order)[cursor.position] : int(cursor.position);
+        cursor.position++;
+        if (index.accepts(cursor.query, row))
+            rows.append(row);
     }
+    cursor.found += rows.size();
+    cursor.atEnd = cursor.position >= count;
+    return rows;
+}
 
-    return originalIndices; // Ritorna tutti gli indici originali dei risultati
+qsizetype ContactList::estimatedTotal(const SortedCursor &cursor) const
+{
+    if (cursor.atEnd || cursor.position == 0)
+        return cursor.found;
+    return std::max(cursor.found, qsizetype(qint64(cursor.found) * qint64(m_store.size()) / cursor.position));
+}
+
+void ContactList::showRows(QTableWidget *table, const QVector<int> &rows, int at) const
+{
+    appendToTable(table, rows, at);
+}
+
+qsizetype ContactList::letterStart(int group) const
+{
+    return m_store.letterStart(group);
+}
+
+qsizetype ContactList::letterCount(int group) const
+{
+    return m_store.letterCount(group);
+}
+
+SearchIndex::CacheStats ContactList::searchCacheStats() const
+{
+    return m_searchIndex.cacheStats();
 }
 
 QVector<Contact> ContactList::allContacts() const
 {
     QVector<Contact> contacts;
-    Node* current = m_head;
+    contacts.reserve(m_store.size()); // una sola allocazione per il vettore
 
-    while (current) {
-        contacts.append(current->contact);
-        current = current->next;
-    }
+    for (qsizetype i = 0; i < m_store.size(); ++i)
+        contacts.append(m_store.contact(i));
 
     return contacts;
 }
 
+const QVector<quint64> &ContactList::phoneKeys() const
+{
+    return m_store.phoneKeys();
+}
+
+QVector<DuplicateFinder::Cluster> ContactList::findDuplicates(DuplicateFinder::Criteria criteria) const
+{
+    const Profiler::Scope scope("ContactList::findDuplicates");
+    return DuplicateFinder::find(allContacts(), criteria);
+}
+
+qsizetype ContactList::mergeDuplicates(const QVector<QVector<quint64>> &clusters)
+{
+    const Profiler::Scope scope("ContactList::mergeDuplicates");
+    const qsizetype count = m_store.size();
+    QVector<bool> removed(count, false);
+    qsizetype removedCount = 0;
+    QVector<UndoLog::FieldChange> emailChanges;
+
+    const QVector<quint64> &phoneKeys = m_store.phoneKeys();
+    const auto samePhone = [this, &phoneKeys](int a, int b) {
+        if (PhoneNumber::isOverflow(phoneKeys[a]) || PhoneNumber::isOverflow(phoneKeys[b]))
+            return m_store.phone(a) == m_store.phone(b);
+        return phoneKeys[a] == phoneKeys[b];
+    };
+
+    // contatto che resta di un gruppo, con l'email che avrà dopo l'unione
+    struct Kept
+    {
+        int row;
+        QString email;
+    };
+
+    for (const QVector<quint64> &cluster : clusters) {
+        // righe attuali dei contatti del gruppo, in ordine: resta il primo
+        QVector<int> members;
+        members.reserve(cluster.size());
+        for (const quint64 id : cluster) {
+            const qsizetype row = m_store.indexOfId(id);
+            if (row >= 0)
+                members.append(int(row));
+        }
+        std::sort(members.begin(), members.end());
+
+        // un contatto si unisce solo a uno con lo stesso telefono e un'email compatibile:
+        // nessun dato va perso (es. omonimi con numeri diversi restano separati)
+        QVector<Kept> kept;
+        for (const int member : members) {
+            if (removed[member])
+                continue;
+
+            const QString email = m_store.email(member);
+            Kept *target = nullptr;
+            for (Kept &candidate : kept) {
+                if (samePhone(candidate.row, member)
+                    && (email.isEmpty() || candidate.email.isEmpty()
+                        || email.compare(candidate.email, Qt::CaseInsensitive) == 0)) {
+                    target = &candidate;
+                    break;
+                }
+            }
+            if (!target) {
+                kept.append({member, email});
+                continue;
+            }
+
+            // l'email è l'unico dato che il contatto che resta può non avere
+            if (target->email.isEmpty())
+                target->email = email;
+            removed[member] = true;
+            removedCount++;
+        }
+
+        for (Kept &target : kept) {
+            if (target.email != m_store.email(target.row)) {
+                emailChanges.append({target.row, ContactStore::Email, m_store.email(target.row), target.email});
+                m_store.setEmail(target.row, std::move(target.email));
+            }
+        }
+    }
+
+    if (removedCount == 0)
+        return 0;
+
+    // le email completate aggiornano le permutazioni in un solo passo, prima della rimozione
+    QVector<qsizetype> emailRows;
+    QVector<quint64> changedIds;
+    emailRows.reserve(emailChanges.size());
+    changedIds.reserve(emailChanges.size() + removedCount);
+    for (const UndoLog::FieldChange &change : emailChanges) {
+        emailRows.append(change.row);
+        changedIds.append(m_store.id(change.row));
+    }
+    m_sortOrders.updateRows(m_store, emailRows);
+
+    // salvo le righe rimosse per poter annullare l'unione in un solo passo
+    QVector<qsizetype> removedRows;
+    QVector<Contact> removedContacts;
+    removedRows.reserve(removedCount);
+    removedContacts.reserve(removedCount);
+    for (qsizetype i = 0; i < count; ++i) {
+        if (removed[i]) {
+            removedRows.append(i);
+            removedContacts.append(m_store.contact(i));
+            changedIds.append(m_store.id(i));
+        }
+    }
+    m_history.recordBulk(std::move(emailChanges), std::move(removedRows), std::move(removedContacts));
+
+    // compatto le colonne saltando le righe rimosse, l'ordine resta invariato
+    m_store.removeIf(removed);
+    m_sortOrders.removeRows(removed);
+    commitChange(std::move(changedIds));
+    return removedCount;
+}
+
+void ContactList::setInterning(bool enabled)
+{
+    // cambia solo la rappresentazione in memoria: ordine, indici e ricerca restano validi
+    m_store.setInterning(enabled);
+}
+
+bool ContactList::isInterning() const
+{
+    return m_store.isInterning();
+}
+
+ContactList::MemoryUsage ContactList::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.store = m_store.memoryReport();
+    usage.search = m_searchIndex.memoryUsage();
+    usage.peakLoadBytes = m_peakLoadBytes;
+    usage.peakSortBytes = m_peakSortBytes;
+    usage.historyBytes = m_history.memoryUsage();
+    usage.sortOrderBytes = m_sortOrders.memoryUsage();
+    std::shared_ptr<AsyncSearch> search;
+    {
+        QMutexLocker locker(&m_asyncSearchMutex);
+        search = m_asyncSearch.lock();
+    }
+    if (search) {
+        // una ricerca può leggere una pagina proprio ora: la cache dell'indice cambia
+        QMutexLocker locker(&search->mutex);
+        usage.asyncSearchBytes = search->index.memoryUsage().total();
+    }
+    return usage;
+}
+
+bool ContactList::undo()
+{
+    UndoLog::Delta delta;
+    if (!m_history.undo(m_store, &delta))
+        return false;
+    replayDelta(delta); // l'UndoLog modifica l'archivio direttamente
+    if (delta.kind == UndoLog::Delta::Replaced)
+        commitChange();
+    else
+        commitChange(std::move(delta.ids));
+    return true;
+}
+
+bool ContactList::redo()
+{
+    UndoLog::Delta delta;
+    if (!m_history.redo(m_store, &delta))
+        return false;
+    replayDelta(delta);
+    if (delta.kind == UndoLog::Delta::Replaced)
+        commitChange();
+    else
+        commitChange(std::move(delta.ids));
+    return true;
+}
+
+void ContactList::replayDelta(const UndoLog::Delta &delta)
+{
+    switch (delta.kind) {
+    case UndoLog::Delta::Inserted:
+        m_sortOrders.insertRow(m_store, delta.row);
+        break;
+    case UndoLog::Delta::Removed:
+        m_sortOrders.removeRow(delta.row);
+        break;
+    case UndoLog::Delta::Moved:
+        m_sortOrders.removeRow(delta.row);
+        m_sortOrders.insertRow(m_store, delta.toRow);
+        break;
+    default:
+        // operazioni su più righe o sostituzione della rubrica: si ricostruisce alla richiesta
+        m_sortOrders.reset();
+        break;
+    }
+}
+
+bool ContactList::canUndo() const
+{
+    return m_history.canUndo();
+}
+
+bool ContactList::canRedo() const
+{
+    return m_history.canRedo();
+}
+
+void ContactList::clearHistory()
+{
+    m_history.clear();
+}
+
 bool ContactList::contains(const QString& value) const
 {
-    //return findNode(value) != nullptr;
-    if(findNode(value) != nullptr){
+    //return m_store.indexOf(value) >= 0;
+    if(m_store.indexOf(value) >= 0){
         return true;
     }else{
         return false;
     }
 }
 
-constexpr size_t ContactList::size() const
+size_t ContactList::size() const
 {
-    return m_count;
+    return size_t(m_store.size());
 }
 
-constexpr bool ContactList::isEmpty() const { return m_count == 0; }
+bool ContactList::isEmpty() const { return m_store.isEmpty(); }
 
 bool ContactList::saveToFile(const QString& filePath) const
 {
-    QFile file(filePath);
+    const Profiler::Scope scope("ContactList::saveToFile");
+    return saveStore(m_store, filePath);
+}
+
+bool ContactList::saveStore(const ContactStore &store, const QString &filePath, qint64 *bytesWritten,
+                            const Progress &progress)
+{
+    // scrive in un file temporaneo, rinominato solo da commit()
+    QSaveFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
         return false;
 
     QTextStream out(&file); // Stream di scrittura per il file
-    Node* current = m_head;
 
-    while (current) {
+    for (qsizetype i = 0; i < store.size(); ++i) {
+        const QString &name = store.name(i);
+        const QString &phone = store.phone(i);
+        const QString &email = store.email(i);
+
         // Salva solo contatti non vuoti
-        if(!current->contact.name().isEmpty() ||
-            !current->contact.phone().isEmpty() ||
-            !current->contact.email().isEmpty()) {
+        if(!name.isEmpty() || !phone.isEmpty() || !email.isEmpty()) {
             // scrivo i contatti nel file
-            out << current->contact.name() << ","
-                << current->contact.phone() << ","
-                << current->contact.email() << "\n";
+            out << name << "," << phone << "," << email << "\n";
+        }
+        if (progress && (i + 1) % m_list_namespace::kProgressStep == 0 && !progress(i + 1, store.size())) {
+            file.cancelWriting(); // il file esistente resta com'era
+            return false;
         }
-        current = current->next;
     }
+    if (progress)
+        progress(store.size(), store.size());
+    out.flush(); // prima di commit(), altrimenti il buffer dello stream andrebbe perso
+
+    if (out.status() != QTextStream::Ok)
+        return false; // senza commit() il file temporaneo viene eliminato
+    if (bytesWritten)
+        *bytesWritten = file.pos();
+    return file.commit();
+}
 
-    file.close();
+bool ContactList::loadFromFile(const QString& filePath, QVector<ContactValidator::Error> *errors)
+{
+    const Profiler::Scope scope("ContactList::loadFromFile");
+    QVector<Contact> batch;
+    if (!readFile(filePath, batch, errors))
+        return false;
+
+    qsizetype batchPayloadBytes = 0; // caratteri del lotto, per la stima del picco di memoria
+    for (const Contact &contact : batch)
+        batchPayloadBytes += m_list_namespace::contactPayloadBytes(contact);
+
+    // i contatti vecchi restano nell'UndoLog: convivono con il lotto e poi con la nuova rubrica
+    const qsizetype batchBytes = batch.capacity() * qsizetype(sizeof(Contact));
+    const qsizetype previousBytes = m_store.memoryReport().actualBytes;
+    const qsizetype peakBeforeClear = previousBytes + batchBytes + batchPayloadBytes;
+
+    // la rubrica precedente passa all'UndoLog senza copie, al suo posto una vuota
+    auto previous = std::make_unique<ContactStore>(std::move(m_store));
+    m_store = ContactStore();
+    m_store.setInterning(previous->isInterning());
+    this->clear(); // Pulisci la lista corrente
+
+    // aggiunta in coda dei contatti validi e un solo ordinamento finale,
+    // invece di uno per ogni contatto
+    m_store.reserve(batch.size());
+    for (Contact &contact : batch)
+        m_store.append(std::move(contact));
+    // le stringhe ora sono nelle colonne, ma il lotto occupa ancora il suo vettore
+    // mentre l'ordinamento alloca la sua memoria temporanea
+    const qsizetype peakDuringSort = previousBytes + m_store.memoryReport().actualBytes
+                                     + m_store.sortScratchBytes() + batchBytes;
+    m_peakLoadBytes = std::max(peakBeforeClear, peakDuringSort);
+    sort();
+    m_history.recordReplace(std::move(previous), m_store);
+
+    commitChange();
     return true;
 }
 
-bool ContactList::loadFromFile(const QString& filePath)
+void ContactList::replaceStore(ContactStore store)
+{
+    // stessa sostituzione di loadFromFile: la rubrica precedente passa all'UndoLog senza copie
+    auto previous = std::make_unique<ContactStore>(std::move(m_store));
+    m_store = std::move(store);
+    m_store.setInterning(previous->isInterning());
+    m_sortOrders.reset();
+    sort(); // nessun lavoro se l'archivio arriva già ordinato
+    m_history.recordReplace(std::move(previous), m_store);
+    commitChange();
+}
+
+bool ContactList::readFile(const QString &filePath, QVector<Contact> &contacts,
+                           QVector<ContactValidator::Error> *errors, const Progress &progress,
+                           bool dropInvalid)
 {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
         return false;
 
-    this->clear(); // Pulisci la lista corrente
+    // prima leggo tutte le righe, la validazione avviene sull'intero lotto
+    QVector<Contact> batch;
+    QVector<int> lineNumbers; // riga del file di ogni contatto del lotto
+    int lineNumber = 0;
 
     QTextStream in(&file); // stream di input per il file
     while (!in.atEnd()) {
         QString line = in.readLine().trimmed();
+        lineNumber++;
+        // la posizione nel file include quanto già letto dallo stream: è una stima
+        if (progress && lineNumber % m_list_namespace::kProgressStep == 0 && !progress(file.pos(), file.size()))
+            return false;
         if(line.isEmpty()) continue;
 
         // separa la stringa in sotto stringhe quando il carattere ',' compare
         QStringList parts = line.split(',');
-        if(parts.size() >= 2) {
-            QString name = parts[0].trimmed();
-            QString phone = parts[1].trimmed();
-            // se la size della sotto stringa è maggiore di due,
-            // vuol dire che c'è l'email e la carichiamo, altrimenti mettiamo ""
-            QString email = parts.size() > 2 ? parts[2].trimmed() : "";
-
-            // Aggiungi solo se almeno nome o telefono non sono vuoti
-            if(!name.isEmpty() || !phone.isEmpty()) {
-                addContact(Contact(name, phone, email));
-            }
+        // anche una riga malformata resta in rubrica e torna nel file al salvataggio:
+        // senza virgole è solo un nome, le colonne in più restano nell'email
+        QString name = parts[0].trimmed();
+        QString phone = parts.size() > 1 ? parts[1].trimmed() : QString();
+        QString email = parts.size() > 2 ? parts.mid(2).join(',').trimmed() : QString();
+
+        // Aggiungi solo se almeno un campo non è vuoto
+        if(!name.isEmpty() || !phone.isEmpty() || !email.isEmpty()) {
+            batch.append(Contact(std::move(name), std::move(phone), std::move(email)));
+            lineNumbers.append(lineNumber);
         }
     }
 
     file.close();
-    emit dataChanged();
+
+    const QVector<ContactValidator::Error> report = ContactValidator().validate(batch);
+    if (errors) {
+        errors->clear();
+        errors->reserve(report.size());
+        for (ContactValidator::Error error : report) {
+            error.row = lineNumbers[error.row];
+            errors->append(error);
+        }
+    }
+
+    // le righe non valide sono dati dell'utente: si scartano solo se richiesto
+    if (dropInvalid && !report.isEmpty()) {
+        QVector<bool> rejected(batch.size(), false);
+        for (const ContactValidator::Error &error : report)
+            rejected[error.row] = true;
+
+        // restano solo i contatti validi, compattati senza copie
+        qsizetype kept = 0;
+        for (qsizetype i = 0; i < batch.size(); ++i) {
+            if (rejected[i])
+                continue;
+            if (kept != i)
+                batch[kept] = std::move(batch[i]);
+            kept++;
+        }
+        batch.resize(kept);
+    }
+    contacts = std::move(batch);
     return true;
 }
 
-void ContactList::clear()
+ContactStore ContactList::makeStore(QVector<Contact> contacts)
+{
+    ContactStore store;
+    store.reserve(contacts.size());
+    for (Contact &contact : contacts)
+        store.append(std::move(contact));
+    store.sort();
+    return store;
+}
+
+ContactList::Digest ContactList::digest(const ContactStore &store)
 {
-    while (m_head) {
-        Node* to_delete = m_head;
-        m_head = m_head->next;
-        delete to_delete;
+    const Profiler::Scope scope("ContactList::digest");
+    Digest digest;
+    digest.reserve(store.size());
+    for (qsizetype i = 0; i < store.size(); ++i)
+        digest.append(m_list_namespace::digestEntry(store.name(i), store.phone(i), store.email(i), store.id(i)));
+    std::sort(digest.begin(), digest.end(), m_list_namespace::digestLess);
+    return digest;
+}
+
+void ContactList::applyToDigest(Digest &digest, const Batch &batch, const QVector<Contact> &inserted)
+{
+    const QSet<quint64> removed(batch.removed.cbegin(), batch.removed.cend());
+    QHash<quint64, quint64> updated;
+    for (const FieldUpdate &update : batch.updated)
+        updated.insert(update.id, m_list_namespace::digestEntry({}, update.phone, update.email, update.id).data);
+
+    // rimozioni e aggiornamenti non cambiano l'impronta del nome: l'ordine resta
+    DigestEntry *entries = digest.data();
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < digest.size(); ++i) {
+        if (removed.contains(entries[i].id))
+            continue;
+        entries[kept] = entries[i];
+        const auto update = updated.constFind(entries[kept].id);
+        if (update != updated.constEnd())
+            entries[kept].data = update.value();
+        kept++;
     }
-    m_count = 0;
+    digest.resize(kept);
+
+    Digest added;
+    added.reserve(inserted.size());
+    for (const Contact &contact : inserted)
+        added.append(m_list_namespace::digestEntry(contact.name(), contact.phone(), contact.email(), contact.id()));
+    std::sort(added.begin(), added.end(), m_list_namespace::digestLess);
+    const qsizetype count = digest.size();
+    digest += added;
+    std::inplace_merge(digest.begin(), digest.begin() + count, digest.end(), m_list_namespace::digestLess);
 }
 
-Node* ContactList::findNode(const QString& value) const
+ContactList::Batch ContactList::diff(const Digest &base, QVector<Contact> contacts)
 {
-    Node* current = m_head;
-    while (current) {
-        if (current->contact.name() == value || current->contact.phone() == value)
-            return current;
-        current = current->next;
+    const Profiler::Scope scope("ContactList::diff");
+    Batch batch;
+
+    // impronte dei nuovi contatti: l'id è la posizione in contacts
+    Digest incoming;
+    incoming.reserve(contacts.size());
+    for (qsizetype i = 0; i < contacts.size(); ++i) {
+        const Contact &contact = contacts[i];
+        incoming.append(m_list_namespace::digestEntry(contact.name(), contact.phone(), contact.email(), quint64(i)));
     }
-    return nullptr;
+    std::sort(incoming.begin(), incoming.end(), m_list_namespace::digestLess);
+
+    const qsizetype count = base.size();
+    qsizetype i = 0;
+    qsizetype j = 0;
+    while (i < count || j < incoming.size()) {
+        if (j == incoming.size() || (i < count && base[i].name < incoming[j].name)) {
+            batch.removed.append(base[i++].id);
+            continue;
+        }
+        if (i == count || incoming[j].name < base[i].name) {
+            batch.inserted.append(std::move(contacts[qsizetype(incoming[j++].id)]));
+            continue;
+        }
+
+        // gruppo con lo stesso nome da entrambe le parti (di solito un contatto per parte)
+        const quint64 name = base[i].name;
+        const qsizetype groupBegin = i;
+        while (i < count && base[i].name == name)
+            ++i;
+        const qsizetype newBegin = j;
+        while (j < incoming.size() && incoming[j].name == name)
+            ++j;
+
+        QVector<bool> matched(i - groupBegin, false);
+        QVector<bool> newMatched(j - newBegin, false);
+        // prima i contatti identici
+        for (qsizetype b = 0; b < newMatched.size(); ++b) {
+            for (qsizetype a = 0; a < matched.size(); ++a) {
+                if (!matched[a] && base[groupBegin + a].data == incoming[newBegin + b].data) {
+                    matched[a] = newMatched[b] = true;
+                    break;
+                }
+            }
+        }
+        // poi lo stesso nome con altri dati
+        for (qsizetype b = 0; b < newMatched.size(); ++b) {
+            if (newMatched[b])
+                continue;
+            for (qsizetype a = 0; a < matched.size(); ++a) {
+                if (!matched[a]) {
+                    const Contact &contact = contacts[qsizetype(incoming[newBegin + b].id)];
+                    batch.updated.append({base[groupBegin + a].id, contact.phone(), contact.email()});
+                    matched[a] = newMatched[b] = true;
+                    break;
+                }
+            }
+        }
+        for (qsizetype a = 0; a < matched.size(); ++a) {
+            if (!matched[a])
+                batch.removed.append(base[groupBegin + a].id);
+        }
+        for (qsizetype b = 0; b < newMatched.size(); ++b) {
+            if (!newMatched[b])
+                batch.inserted.append(std::move(contacts[qsizetype(incoming[newBegin + b].id)]));
+        }
+    }
+    return batch;
 }
 
-void ContactList::sort()
+qsizetype ContactList::applyBatch(const Batch &batch, QVector<Contact> *inserted)
 {
-    // se this->size() > 1000 attiverà l'ordinamento con i thread
-    // altrimenti fare un merge sort classico
-    m_head = m_list_namespace::merge_sort(m_head, this->size());
+    const Profiler::Scope scope("ContactList::applyBatch");
+    const qsizetype count = m_store.size();
+
+    QVector<bool> removed(count, false);
+    qsizetype removedCount = 0;
+    for (const quint64 id : batch.removed) {
+        const qsizetype index = m_store.indexOfId(id);
+        if (index >= 0 && !removed[index]) {
+            removed[index] = true;
+            removedCount++;
+        }
+    }
+
+    // gli aggiornamenti usano le righe prima della rimozione, come nel passo di annulla
+    QVector<UndoLog::FieldChange> changes;
+    QVector<qsizetype> updatedRows;
+    QVector<quint64> changedIds;
+    for (const FieldUpdate &update : batch.updated) {
+        const qsizetype index = m_store.indexOfId(update.id);
+        if (index < 0 || removed[index])
+            continue;
+        QString phone = m_store.phone(index);
+        const qsizetype changeCount = changes.size();
+        if (phone != update.phone) {
+            m_store.setPhone(index, update.phone);
+            changes.append({index, ContactStore::Phone, std::move(phone), update.phone});
+        }
+        QString email = m_store.email(index);
+        if (email != update.email) {
+            m_store.setEmail(index, update.email);
+            changes.append({index, ContactStore::Email, std::move(email), update.email});
+        }
+        if (changes.size() != changeCount) {
+            updatedRows.append(index);
+            changedIds.append(update.id);
+        }
+    }
+    m_sortOrders.updateRows(m_store, updatedRows);
+
+    QVector<qsizetype> removedRows;
+    QVector<Contact> removedContacts;
+    if (removedCount > 0) {
+        removedRows.reserve(removedCount);
+        removedContacts.reserve(removedCount);
+        for (qsizetype i = 0; i < count; ++i) {
+            if (removed[i]) {
+                removedRows.append(i);
+                removedContacts.append(m_store.contact(i));
+                changedIds.append(m_store.id(i));
+            }
+        }
+        m_store.removeIf(removed);
+        m_sortOrders.removeRows(removed);
+    }
 
-    /*
-        il merge sort funziona così.
-        dato un container, esso viene diviso in due metà con stesso numero di elementi (se possibile)[1], a questo punto facciamo ricorsivamente la stessa cosa finchè non ci troviamo ad avere sotto container formati da un elemento. Una volta fatto ciò uniamo i sotto continer di singoli elementi nei precedenti sotto container da 2 elementi ma ordinati, facciamo questo cosa ricorsivamente finchè non abbiamo il container originale tutto ordinato[2]
+    QVector<qsizetype> insertedRows;
+    QVector<Contact> insertedContacts;
+    if (!batch.inserted.isEmpty()) {
+        QVector<Contact> contacts = batch.inserted;
+        for (Contact &contact : contacts)
+            contact.setId(0); // id nuovi: quelli di un'altra rubrica non valgono qui
+        insertedRows = m_store.insertSortedRows(std::move(contacts));
+        m_sortOrders.insertRows(m_store, insertedRows);
+        insertedContacts.reserve(insertedRows.size());
+        for (const qsizetype row : insertedRows) {
+            insertedContacts.append(m_store.contact(row)); // con l'id assegnato, per ripetere
+            changedIds.append(m_store.id(row));
+        }
+    }
+    if (inserted)
+        *inserted = insertedContacts;
 
+    const qsizetype applied = removedCount + changes.size() + insertedRows.size();
+    if (applied == 0)
+        return 0;
 
-        [1] => continer [38, 27, 43, 10]
-                        /               \
-                    [38, 27]            [43, 10]
-                      /  \                /  \
-                   [38]  [27]           [43] [10]
-        [2]                      MERGE
-                            [10, 27, 38, 43]
-    */
+    m_history.recordBulk(std::move(changes), std::move(removedRows), std::move(removedContacts),
+                         std::move(insertedRows), std::move(insertedContacts));
+    commitChange(std::move(changedIds));
+    return applied;
 }
 
-Contact ContactList::at(size_t index) const
+QFuture<ContactList::LoadResult> ContactList::loadAsync(const QString &filePath)
 {
-    // controllo per verifica se l'indici non è al difuori dei limiti
-    if (index < 0 || index >= m_count) {
-        return Contact{};
+    using namespace m_list_namespace;
+    return runAsync<LoadResult>(m_asyncPool, [this, filePath](const std::shared_ptr<QPromise<LoadResult>> &promise) {
+        const Profiler::Scope scope("ContactList::loadAsync");
+        LoadResult result;
+        QVector<Contact> contacts;
+        result.ok = readFile(filePath, contacts, &result.errors, stageProgress(promise, 0, 800, m_closing));
+        if (promise->isCanceled() || m_closing)
+            return;
+        if (!result.ok) {
+            promise->addResult(std::move(result));
+            promise->finish();
+            return;
+        }
+
+        ContactStore store = makeStore(std::move(contacts));
+        result.loaded = store.size();
+        promise->setProgressValue(950);
+        if (promise->isCanceled() || m_closing)
+            return;
+
+        // la sostituzione avviene nel thread della lista, in un solo passo
+        QMetaObject::invokeMethod(
+            this, [this, promise, store = std::move(store), result = std::move(result)]() mutable {
+                if (promise->isCanceled())
+                    return;
+                replaceStore(std::move(store));
+                promise->setProgressValue(kProgressRange);
+                promise->addResult(std::move(result));
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+QFuture<bool> ContactList::saveAsync(const QString &filePath)
+{
+    using namespace m_list_namespace;
+    const Snapshot snapshot = this->snapshot();
+    const quint64 revision = m_revision;
+    return runAsync<bool>(m_asyncPool, [this, snapshot, revision, filePath](const std::shared_ptr<QPromise<bool>> &promise) {
+        const Profiler::Scope scope("ContactList::saveAsync");
+        const bool ok = saveStore(*snapshot, filePath, nullptr, stageProgress(promise, 0, kProgressRange, m_closing));
+        if (!ok && (promise->isCanceled() || m_closing))
+            return; // annullato: il file esistente è intatto
+
+        QMetaObject::invokeMethod(
+            this, [this, promise, revision, ok]() {
+                if (ok)
+                    markSaved(revision);
+                promise->addResult(ok);
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+QFuture<Contact> ContactList::searchAsync(const QString &query, int limit)
+{
+    using namespace m_list_namespace;
+    const Snapshot snapshot = this->snapshot();
+    return runAsync<Contact>(m_asyncPool, [this, snapshot, query, limit](const std::shared_ptr<QPromise<Contact>> &promise) {
+        const Profiler::Scope scope("ContactList::searchAsync");
+        constexpr int kPageSize = 1000;
+
+        // un indice solo per le ricerche asincrone: quello della lista appartiene al suo thread.
+        // Il mutex copre solo il controllo e l'eventuale ricostruzione, non la ricerca.
+        // La lista tiene solo un riferimento debole: finite le ricerche, indice e snapshot si liberano
+        std::shared_ptr<AsyncSearch> search;
+        {
+            QMutexLocker locker(&m_asyncSearchMutex);
+            search = m_asyncSearch.lock();
+            if (!search || search->snapshot != snapshot) {
+                search = std::make_shared<AsyncSearch>();
+                search->snapshot = snapshot;
+                indexStore(*snapshot, search->index);
+                m_asyncSearch = search;
+            }
+        }
+
+        // cursore proprio di questa ricerca; l'indice è condiviso solo per il tempo di una pagina
+        SearchIndex::Cursor cursor;
+        {
+            QMutexLocker locker(&search->mutex);
+            cursor = search->index.open(query);
+        }
+        qsizetype found = 0;
+        while (!cursor.atEnd() && (limit < 0 || found < limit)) {
+            if (promise->isCanceled() || m_closing)
+                return;
+            const int page = limit < 0 ? kPageSize : int(std::min<qsizetype>(kPageSize, limit - found));
+            QVector<int> rows;
+            {
+                QMutexLocker locker(&search->mutex);
+                rows = search->index.fetch(cursor, page);
+            }
+            QList<Contact> contacts;
+            contacts.reserve(rows.size());
+            for (const int row : rows)
+                contacts.append(snapshot->contact(row));
+            // i risultati arrivano a pagine: chi aspetta può già mostrarli
+            promise->addResults(contacts);
+            found += rows.size();
+            // la stima del totale si affina a ogni pagina
+            qsizetype total = std::max(found, cursor.estimatedTotal());
+            if (limit >= 0)
+                total = std::min<qsizetype>(total, limit);
+            if (total > 0)
+                promise->setProgressValue(int(qint64(kProgressRange) * found / total));
+        }
+        promise->setProgressValue(kProgressRange);
+        promise->finish();
+    });
+}
+
+QFuture<ContactList::ImportResult> ContactList::importAsync(const QString &filePath)
+{
+    using namespace m_list_namespace;
+    const Snapshot snapshot = this->snapshot();
+    const quint64 revision = m_revision;
+    return runAsync<ImportResult>(m_asyncPool, [this, snapshot, revision, filePath](const std::shared_ptr<QPromise<ImportResult>> &promise) {
+        const Profiler::Scope scope("ContactList::importAsync");
+        ImportResult result;
+        QVector<Contact> contacts;
+        // i contatti importati sono nuovi: valgono le regole dell'inserimento
+        result.ok = readFile(filePath, contacts, &result.errors, stageProgress(promise, 0, 800, m_closing), true);
+        if (promise->isCanceled() || m_closing)
+            return;
+        if (!result.ok) {
+            promise->addResult(std::move(result));
+            promise->finish();
+            return;
+        }
+
+        // telefoni già in rubrica: confronto tra interi (vedi PhoneNumber)
+        QSet<quint64> phones;
+        phones.reserve(snapshot->size());
+        for (const quint64 key : snapshot->phoneKeys()) {
+            if (!PhoneNumber::isOverflow(key))
+                phones.insert(key);
+        }
+        Batch batch;
+        batch.inserted.reserve(contacts.size());
+        for (Contact &contact : contacts) {
+            quint64 key = 0;
+            if (PhoneNumber::pack(contact.phone(), &key) && phones.contains(key)) {
+                result.duplicates++;
+                continue;
+            }
+            batch.inserted.append(std::move(contact));
+        }
+        result.imported = batch.inserted.size();
+        promise->setProgressValue(900);
+        if (promise->isCanceled())
+            return;
+
+        QMetaObject::invokeMethod(
+            this, [this, promise, revision, batch = std::move(batch), result = std::move(result)]() mutable {
+                if (promise->isCanceled())
+                    return;
+                // la rubrica è cambiata durante la lettura: ricontrollo i telefoni sulla versione attuale
+                if (m_revision != revision) {
+                    QSet<quint64> current;
+                    current.reserve(m_store.size());
+                    for (const quint64 key : m_store.phoneKeys()) {
+                        if (!PhoneNumber::isOverflow(key))
+                            current.insert(key);
+                    }
+                    qsizetype kept = 0;
+                    for (qsizetype i = 0; i < batch.inserted.size(); ++i) {
+                        quint64 key = 0;
+                        if (PhoneNumber::pack(batch.inserted[i].phone(), &key) && current.contains(key)) {
+                            result.duplicates++;
+                            continue;
+                        }
+                        if (kept != i)
+                            batch.inserted[kept] = std::move(batch.inserted[i]);
+                        kept++;
+                    }
+                    batch.inserted.resize(kept);
+                    result.imported = kept;
+                }
+                applyBatch(batch);
+                promise->setProgressValue(kProgressRange);
+                promise->addResult(std::move(result));
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void ContactList::clear()
+{
+    m_store.clear();
+    m_sortOrders.reset();
+    m_searchIndexDirty = true;
+}
+
+const SearchIndex &ContactList::searchIndex() const
+{
+    if (!m_searchIndexDirty)
+        return m_searchIndex;
+
+    const Profiler::Scope scope("ContactList::searchIndex");
+    indexStore(m_store, m_searchIndex);
+    m_searchIndexDirty = false;
+    return m_searchIndex;
+}
+
+void ContactList::indexStore(const ContactStore &store, SearchIndex &index)
+{
+    // ricostruisco l'indice con una sola passata sulle colonne
+    const qsizetype count = store.size();
+    index.clear();
+    index.reserve(count, count * 48);
+
+    for (qsizetype i = 0; i < count; ++i)
+        index.append(store.name(i), store.phone(i), store.email(i));
+}
+
+ContactList::Snapshot ContactList::snapshot() const
+{
+    if (QThread::currentThread() == thread())
+        return currentSnapshot();
+    return std::atomic_load(&m_snapshot);
+}
+
+void ContactList::addSnapshotReader()
+{
+    if (m_snapshotReaders++ == 0)
+        publish(); // il nuovo lettore parte dalla versione attuale
+}
+
+void ContactList::removeSnapshotReader()
+{
+    if (m_snapshotReaders > 0 && --m_snapshotReaders == 0) {
+        m_publishTimer.stop();
+        std::atomic_store(&m_snapshot, Snapshot());
     }
+}
 
-    Node* current = m_head;
-    size_t i = 0;
-    while (current != nullptr && i < index) {
-        current = current->next;
-        ++i;
+ContactList::Snapshot ContactList::currentSnapshot() const
+{
+    Snapshot snapshot = m_currentSnapshot.lock();
+    if (!snapshot || m_currentSnapshotRevision != m_revision) {
+        // copia O(1): le colonne restano condivise finché l'archivio non le modifica
+        snapshot = std::make_shared<const ContactStore>(m_store);
+        // la lista tiene solo un riferimento debole: rilasciato lo snapshot, le modifiche non copiano
+        m_currentSnapshot = snapshot;
+        m_currentSnapshotRevision = m_revision;
     }
+    return snapshot;
+}
 
-    // se il contatto è stato trovato lo ritorno, altrimenti no
-    if (current)
-        return current->contact;
-    return Contact{};
+quint64 ContactList::revision() const
+{
+    return m_revision;
 }
 
-bool ContactList::updateAt(size_t index, const Contact &updatedContact)
+bool ContactList::isModified() const
 {
-    // controllo dei limiti
-    if (index < 0 || index >= m_count) {
-        return false;
+    return m_revision != m_savedRevision;
+}
+
+void ContactList::markSaved(quint64 revision)
+{
+    // i salvataggi possono concludersi in ritardo: la versione salvata non torna indietro
+    m_savedRevision = std::max(m_savedRevision, revision);
+}
+
+void ContactList::commitChange()
+{
+    m_lastChange = ChangeSet{};
+    announceChange();
+}
+
+void ContactList::commitChange(QVector<quint64> ids)
+{
+    m_lastChange = ChangeSet{std::move(ids), false};
+    announceChange();
+}
+
+void ContactList::announceChange()
+{
+    m_revision++;
+    m_searchIndexDirty = true;
+    // pubblicare a ogni modifica costringerebbe la successiva a copiare le colonne
+    if (m_snapshotReaders > 0 && !m_publishTimer.isActive())
+        m_publishTimer.start();
+    emit dataChanged();
+}
+
+const ContactList::ChangeSet &ContactList::lastChange() const
+{
+    return m_lastChange;
+}
+
+void ContactList::publish()
+{
+    std::atomic_store(&m_snapshot, currentSnapshot());
+}
+
+void ContactList::appendToTable(QTableWidget *table, const QVector<int> &indices, int at) const
+{
+    const int firstRow = at < 0 ? table->rowCount() : at;
+    if (at < 0)
+        table->setRowCount(firstRow + int(indices.size()));
+    else
+        table->model()->insertRows(firstRow, int(indices.size())); // es. la pagina prima di quelle mostrate
+
+    const ContactValidator validator; // solo i controlli sulla singola riga
+    for (int row = 0; row < indices.size(); ++row) {
+        const int originalIndex = indices[row];
+        const Contact contact = m_store.contact(originalIndex);
+
+        // Salva l'id del contatto nell'item: a differenza dell'indice resta valido dopo le modifiche
+        QTableWidgetItem *nameItem = new QTableWidgetItem(contact.name());
+        nameItem->setData(Qt::UserRole, qulonglong(contact.id()));
+
+        QTableWidgetItem *phoneItem = new QTableWidgetItem(contact.phone());
+        QTableWidgetItem *emailItem = new QTableWidgetItem(contact.email());
+
+        // le righe non valide restano in rubrica, ma si vedono
+        const QVector<ContactValidator::Error> errors = validator.validate(contact);
+        if (!errors.isEmpty()) {
+            QStringList reasons;
+            for (const ContactValidator::Error &error : errors)
+                reasons.append(ContactValidator::describe(error, contact));
+            const QString toolTip = reasons.join('\n');
+            for (QTableWidgetItem *item : {nameItem, phoneItem, emailItem}) {
+                item->setBackground(QColor(255, 224, 224));
+                item->setToolTip(toolTip);
+            }
+        }
+
+        table->setItem(firstRow + row, 0, nameItem);
+        table->setItem(firstRow + row, 1, phoneItem);
+        table->setItem(firstRow + row, 2, emailItem);
     }
+}
 
-    Node* current = m_head;
-    size_t i = 0;
-    while (current != nullptr && i < index) {
-        current = current->next;
-        ++i;
+void ContactList::updateRow(qsizetype index, Contact updatedContact)
+{
+    // il contatto modificato mantiene il suo id
+    Contact before = m_store.contact(index);
+    updatedContact.setId(before.id());
+    m_store.remove(index);
+    m_sortOrders.removeRow(index);
+    const qsizetype row = m_store.insertSorted(updatedContact);
+    m_sortOrders.insertRow(m_store, row);
+    m_history.recordUpdate(index, std::move(before), row, std::move(updatedContact));
+    m_searchIndexDirty = true;
+}
+
+void ContactList::sort()
+{
+    const Profiler::Scope scope("ContactList::sort");
+    // la stima costa una passata O(n), trascurabile rispetto all'ordinamento
+    if (!m_store.isSorted()) {
+        m_peakSortBytes = m_store.memoryReport().actualBytes + m_store.sortScratchBytes();
+        m_sortOrders.reset(); // le righe cambiano posizione
     }
 
-    // se il contatto è stato trovato, aggiorno i suoi dati
-    if (current) {
-        current->contact = updatedContact;
-        emit dataChanged();
-        return true;
+    m_store.sort();
+    m_searchIndexDirty = true;
+}
+
+Contact ContactList::at(size_t index) const
+{
+    // controllo per verifica se l'indici non è al difuori dei limiti
+    if (index >= size()) {
+        return Contact{};
     }
 
-    return false;
+    return m_store.contact(qsizetype(index));
+}
+
+bool ContactList::updateAt(size_t index, Contact updatedContact)
+{
+    // controllo dei limiti
+    if (index >= size()) {
+        return false;
+    }
+
+    const quint64 id = m_store.id(qsizetype(index));
+    updateRow(qsizetype(index), std::move(updatedContact));
+    commitChange({id});
+    return true;
 }
@@ -1,64 +1,111 @@
 /**
  * @file list.hpp
- * @brief Gestione di una rubrica utilizzando una linked list
+ * @brief Gestione di una rubrica con interfaccia da linked list
  *
  * @details
- * Implementazione di una linked list per la gestione di contatti anagrafici.
- * La classe offre operazioni CRUD(Create, Read, Update, Delete), 
+ * Gestione di contatti anagrafici: la classe offre operazioni CRUD(Create, Read, Update, Delete),
  *  persistenza su file CSV e funzionalità di ricerca/ordinamento.
+ * I contatti sono memorizzati a colonne in un ContactStore.
  */
 
 #ifndef LIST_HPP
 #define LIST_HPP
 
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
 #include <QTableWidget>
+#include <QThreadPool>
+#include <QTimer>
 #include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include "contactstore.hpp"
+#include "contactvalidator.hpp"
 #include "contatto.hpp"
-
-/**
- * @struct Node
- * @brief Nodo base per l'implementazione della linked list
- *
- * @details
- * Struttura fondamentale che contiene:
- * - Un oggetto Contact con i dati del contatto
- * - Un puntatore al nodo successivo (nullptr se è l'ultimo nodo)
- */
-struct Node
-{
-    Contact contact; /**< Dati anagrafici del contatto */
-    Node *next;      /**< Puntatore al nodo successivo (nullptr per fine lista) */
-
-    /**
-     * @brief Costruttore del nodo
-     * @param[in] c Contatto da memorizzare
-     * @param[in] n Puntatore al nodo successivo (default: nullptr)
-     */
-    Node(const Contact &c, Node *n = nullptr)
-        : contact(c)
-        , next(n)
-    {}
-};
+#include "duplicatefinder.hpp"
+#include "searchindex.hpp"
+#include "sortorders.hpp"
+#include "undolog.hpp"
 
 /**
  * @class ContactList
  * @brief linked list per la gestione avanzata di contatti
  *
  * @details
- * Classe derivata da QObject che implementa una linked list singola con:
+ * Classe derivata da QObject che offre l'interfaccia di una linked list con:
  * - Inserimento/rimozione/aggiornamento contatti
  * - Ricerca case-insensitive
  * - Ordinamento automatico
  * - Persistenza su file CSV
  * - Notifiche di cambiamento dati via segnali Qt
  *
+ * L'interfaccia è un adattatore sopra ContactStore: i contatti sono in colonne
+ * contigue (nomi, telefoni, email, chiavi di ordinamento), quindi l'accesso per
+ * indice è O(1) e le scansioni su un campo leggono la memoria in sequenza.
+ *
+ * Ogni modifica (aggiunta, rimozione, modifica, unione dei duplicati, caricamento)
+ * viene registrata in un UndoLog e può essere annullata con undo().
+ *
+ * La lista si modifica solo dal thread che la possiede (la GUI). Gli altri thread
+ * (ricerca in background, salvataggio, server di ricerca) leggono uno snapshot(),
+ * una copia immutabile dell'archivio. Le colonne sono condivise con l'archivio
+ * (implicit sharing di Qt): creare lo snapshot costa O(1), ma finché qualcuno lo
+ * tiene la modifica successiva copia le colonne che tocca, O(n). Per questo lo
+ * snapshot non si crea a ogni modifica:
+ * - nel thread della lista si crea alla prima richiesta dopo una modifica
+ * - per i thread registrati con addSnapshotReader() si pubblica al più una volta
+ *   ogni kPublishDelayMs, raggruppando le modifiche arrivate nel frattempo
+ *
+ * Senza lettori le modifiche non copiano nulla. Chi deve ricordare a lungo una
+ * versione (es. FileWatcher, per la versione su disco) ne tiene l'impronta
+ * compatta (digest()), non uno snapshot.
  */
 class ContactList : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Versione immutabile della rubrica, leggibile da qualsiasi thread
+     * @details Resta valida finché qualcuno la conserva, anche se la lista cambia
+     * o viene distrutta.
+     */
+    using Snapshot = std::shared_ptr<const ContactStore>;
+
+    /**
+     * @brief Avanzamento di un'operazione lunga
+     * @details Riceve il lavoro svolto e quello totale (stessa unità, es. byte o righe);
+     * restituisce false per interrompere l'operazione.
+     */
+    using Progress = std::function<bool(qint64 done, qint64 total)>;
+
+    static constexpr int kProgressRange = 1000; /**< Avanzamento dei QFuture asincroni: da 0 a kProgressRange */
+    static constexpr int kPublishDelayMs = 20;  /**< Ritardo massimo degli snapshot per i lettori registrati */
+
+    /**
+     * @brief Esito di loadAsync
+     */
+    struct LoadResult
+    {
+        bool ok = false;                           /**< false se il file non si può aprire */
+        qsizetype loaded = 0;                      /**< Contatti caricati */
+        QVector<ContactValidator::Error> errors;   /**< Righe non valide (caricate comunque) */
+    };
+
+    /**
+     * @brief Esito di importAsync
+     */
+    struct ImportResult
+    {
+        bool ok = false;                           /**< false se il file non si può aprire */
+        qsizetype imported = 0;                    /**< Contatti aggiunti */
+        qsizetype duplicates = 0;                  /**< Contatti saltati: telefono già in rubrica */
+        QVector<ContactValidator::Error> errors;   /**< Righe non valide, non importate */
+    };
+
     /**
      * @brief Costruttore principale
      * @param[in] parent Oggetto padre nella gerarchia Qt (opzionale)
@@ -66,19 +113,29 @@ public:
     ContactList(QObject *parent = nullptr);
 
     /**
-     * @brief Distruttore che libera la memoria allocata
-     * @details
-     * Scorre tutta la lista e dealloca ogni singolo nodo
+     * @brief Distruttore
      */
     ~ContactList();
 
     /**
      * @brief Aggiunge un nuovo contatto alla lista
-     * @param[in] contact Contatto da aggiungere
+     * @param[in] contact Contatto da aggiungere (usare std::move per evitare copie)
      * @post La lista viene riordinata automaticamente
      * @emits dataChanged()
      */
-    void addContact(const Contact &contact);
+    void addContact(Contact contact);
+
+    /**
+     * @brief Crea un nuovo contatto dagli argomenti e lo aggiunge alla lista
+     * @param[in] args Argomenti del costruttore di Contact (nome, telefono, email)
+     * @post La lista viene riordinata automaticamente
+     * @emits dataChanged()
+     */
+    template<typename... Args>
+    void emplaceContact(Args &&...args)
+    {
+        addContact(Contact(std::forward<Args>(args)...));
+    }
 
     /**
      * @brief Rimuove un contatto per nome
@@ -89,6 +146,75 @@ public:
      */
     bool removeContact(const QString &name);
 
+    /**
+     * @brief Rimuove il contatto con l'id indicato
+     * @param[in] id Id del contatto (vedi Contact::id)
+     * @retval true Contatto trovato e rimosso
+     * @retval false Id non presente in rubrica
+     * @details Trova la riga in O(1) con la tabella id → riga: nessun ordinamento
+     * né confronto di nomi, e non può colpire un omonimo.
+     * @emits dataChanged() se la rimozione ha successo
+     */
+    bool removeById(quint64 id);
+
+    /**
+     * @brief Aggiorna il contatto con l'id indicato
+     * @param[in] id Id del contatto
+     * @param[in] updatedContact Nuovi dati (il contatto mantiene il suo id)
+     * @retval true Contatto trovato e aggiornato
+     * @retval false Id non presente in rubrica
+     * @post La lista resta ordinata: la riga viene spostata con una ricerca binaria
+     * @emits dataChanged() se l'aggiornamento ha successo
+     */
+    bool updateById(quint64 id, Contact updatedContact);
+
+    /**
+     * @brief Contatto con l'id indicato
+     * @param[in] id Id del contatto
+     * @return Copia del contatto, Contact vuoto (id 0) se l'id non è in rubrica
+     */
+    Contact contactById(quint64 id) const;
+
+    /**
+     * @brief Posizione attuale del contatto con l'id indicato
+     * @param[in] id Id del contatto
+     * @return Indice nella lista, -1 se l'id non è in rubrica
+     */
+    qsizetype indexOfId(quint64 id) const;
+
+    /**
+     * @brief Converte posizioni (es. risultati di ricerca) in id stabili
+     * @param[in] indices Indici validi dei contatti
+     * @return Id dei contatti, nello stesso ordine
+     */
+    QVector<quint64> idsOf(const QVector<int> &indices) const;
+
+    /**
+     * @brief Rimuove più contatti con una sola operazione
+     * @param[in] ids Id dei contatti da rimuovere (gli id non presenti vengono ignorati)
+     * @return Numero di contatti rimossi
+     * @details
+     * - Le righe si trovano in O(1) con la tabella id → riga
+     * - Le colonne vengono compattate in una sola passata (ContactStore::removeIf)
+     * - La rimozione si annulla in un solo passo
+     * @emits dataChanged() una sola volta, se almeno un contatto viene rimosso
+     */
+    qsizetype removeByIds(const QVector<quint64> &ids);
+
+    /**
+     * @brief Imposta lo stesso valore di un campo su più contatti
+     * @param[in] ids Id dei contatti da modificare (gli id non presenti vengono ignorati)
+     * @param[in] field Campo da modificare: ContactStore::Phone o ContactStore::Email
+     * @param[in] value Nuovo valore, già validato dal chiamante
+     * @return Numero di contatti effettivamente cambiati
+     * @details Telefono ed email non influiscono sull'ordinamento: le righe restano
+     * al loro posto e non serve riordinare. Il nome non si può modificare in blocco
+     * (renderebbe uguali i contatti e li sposterebbe tutti).
+     * La modifica si annulla in un solo passo.
+     * @emits dataChanged() una sola volta, se almeno un contatto cambia
+     */
+    qsizetype updateField(const QVector<quint64> &ids, ContactStore::Field field, const QString &value);
+
     /**
      * @brief Aggiorna un contatto esistente
      * @param[in] originalName Nome attuale del contatto da modificare
@@ -98,7 +224,7 @@ public:
      * @post La lista viene riordinata automaticamente
      * @emits dataChanged() se l'aggiornamento ha successo
      */
-    bool updateContact(const QString &originalName, const Contact &updatedContact);
+    bool updateContact(const QString &originalName, Contact updatedContact);
 
     /**
      * @brief Ricerca avanzata nella rubrica
@@ -110,16 +236,381 @@ public:
      * - Nome completo
      * - Numero di telefono
      * - Indirizzo email
+     *
+     * La scansione avviene sul buffer contiguo di SearchIndex,
+     * ricostruito solo se la lista è cambiata dall'ultima ricerca.
      */
     QVector<int> search(const QString &query, QTableWidget *table);
 
+    /**
+     * @brief Ricerca senza tabella, limitata ai primi risultati
+     * @param[in] query Stringa di ricerca (stessa sintassi di search)
+     * @param[in] limit Numero massimo di risultati
+     * @return Indici crescenti (in ordine di nome) dei primi contatti trovati
+     * @details La scansione si ferma appena trovati limit risultati (vedi SearchIndex::fetch).
+     * @note Usa l'indice di ricerca della lista: non va chiamata da due thread insieme,
+     *       né mentre la lista viene modificata
+     */
+    QVector<int> find(const QString &query, int limit) const;
+
+    /**
+     * @brief Ricerca approssimata nella rubrica (tollerante agli errori di battitura)
+     * @param[in] query Stringa di ricerca (case-insensitive)
+     * @param[in] table Widget tabella per visualizzazione risultati
+     * @param[in] limit Numero massimo di risultati
+     * @return Vector di indici dei contatti trovati, dal più simile al meno simile
+     * @details
+     * Cerca la stringa nel nome ammettendo fino a 2 errori di battitura
+     * (vedi SearchIndex::fuzzyFind). A parità di errori vale l'ordine alfabetico.
+     */
+    QVector<int> fuzzySearch(const QString &query, QTableWidget *table, int limit = 50);
+
+    /**
+     * @brief Apre una ricerca da mostrare a pagine
+     * @param[in] query Stringa di ricerca (stessa sintassi di search)
+     * @return Cursore da passare a searchPage
+     * @note Il cursore non è più valido dopo una modifica della lista
+     */
+    SearchIndex::Cursor openSearch(const QString &query) const;
+
+    /**
+     * @brief Riprende una ricerca dopo una modifica della lista
+     * @param[in] query Stringa di ricerca (stessa sintassi di search)
+     * @param[in] from Primo contatto da controllare (quelli prima sono già mostrati)
+     * @param[in] found Risultati già mostrati
+     * @return Cursore da passare a searchPage, che continua da from
+     */
+    SearchIndex::Cursor openSearch(const QString &query, qsizetype from, qsizetype found) const;
+
+    /**
+     * @brief Verifica se un contatto soddisfa una query
+     * @param[in] query Query già analizzata (vedi SearchQuery::parse)
+     * @param[in] index Indice del contatto
+     */
+    bool accepts(const SearchQuery &query, qsizetype index) const;
+
+    /**
+     * @brief Aggiunge alla tabella la pagina successiva di risultati
+     * @param[in,out] cursor Cursore restituito da openSearch
+     * @param[in] table Widget tabella a cui aggiungere le righe
+     * @param[in] limit Numero massimo di righe da aggiungere
+     * @return Vector di indici dei contatti aggiunti
+     * @details
+     * La scansione si ferma appena trovati limit risultati, quindi la prima pagina
+     * è immediata anche se la query corrisponde a quasi tutta la rubrica.
+     */
+    QVector<int> searchPage(SearchIndex::Cursor &cursor, QTableWidget *table, int limit);
+
+    /**
+     * @brief Imposta il criterio con cui mostrare la rubrica
+     * @param[in] key Criterio (SortOrders::FirstName è l'ordine delle righe)
+     * @details La permutazione del criterio viene costruita alla prima richiesta e
+     * poi aggiornata a ogni modifica: tornare a un criterio già usato non riordina nulla.
+     */
+    void setSortKey(SortOrders::Key key);
+
+    /**
+     * @brief Criterio con cui mostrare la rubrica
+     */
+    SortOrders::Key sortKey() const;
+
+    /**
+     * @brief Tutti i contatti, nell'ordine del criterio attuale
+     * @return Indici dei contatti nell'ordine di sortKey()
+     * @details Restituisce la permutazione in cache (copia O(1) grazie all'implicit sharing).
+     * @note Il risultato non è più valido dopo una modifica della lista
+     */
+    QVector<int> sortedRows() const;
+
+    /**
+     * @brief Posizione di un contatto nell'ordine del criterio attuale
+     * @param[in] index Indice del contatto
+     * @return La riga in ordine di nome, altrimenti la posizione nella permutazione
+     * @details Tempo costante dopo la prima richiesta (vedi SortOrders::rank).
+     */
+    qsizetype sortPosition(qsizetype index) const;
+
+    /**
+     * @brief Stato di una ricerca letta a pagine nell'ordine del criterio attuale
+     */
+    struct SortedCursor
+    {
+        SearchQuery query;       /**< Query analizzata */
+        qsizetype position = 0;  /**< Prossima posizione della permutazione da controllare */
+        qsizetype found = 0;     /**< Risultati letti finora */
+        bool atEnd = true;       /**< true quando la permutazione è stata scorsa tutta */
+    };
+
+    /**
+     * @brief Apre una ricerca da mostrare a pagine nell'ordine di sortKey()
+     * @param[in] query Stringa di ricerca (stessa sintassi di search)
+     * @return Cursore da passare a sortedPage
+     * @note Il cursore non è più valido dopo una modifica della lista o del criterio
+     */
+    SortedCursor openSorted(const QString &query) const;
+
+    /**
+     * @brief Pagina successiva di una ricerca nell'ordine del criterio
+     * @param[in,out] cursor Cursore restituito da openSorted
+     * @param[in] limit Numero massimo di risultati
+     * @return Indici dei contatti trovati, nell'ordine di sortKey()
+     * @details
+     * Scorre la permutazione in cache dal punto raggiunto e controlla ogni contatto
+     * con SearchIndex::accepts: si ferma appena trovati limit risultati. Nessun
+     * ordinamento e nessuna ricerca completa a ogni tasto premuto.
+     */
+    QVector<int> sortedPage(SortedCursor &cursor, int limit) const;
+
+    /**
+     * @brief Stima del numero totale di risultati di una ricerca ordinata
+     * @return Il totale esatto se la ricerca è terminata, altrimenti una stima
+     *         proporzionale alla parte di permutazione già scorsa
+     */
+    qsizetype estimatedTotal(const SortedCursor &cursor) const;
+
+    /**
+     * @brief Inserisce nella tabella i contatti indicati
+     * @param[in] table Tabella da popolare
+     * @param[in] rows Indici dei contatti, nell'ordine in cui mostrarli (es. una pagina di sortedPage)
+     * @param[in] at Riga della tabella da cui inserire (-1 = in fondo)
+     */
+    void showRows(QTableWidget *table, const QVector<int> &rows, int at = -1) const;
+
+    /**
+     * @brief Posizione del primo contatto con l'iniziale nel gruppo, in ordine di nome
+     * @param[in] group Gruppo di iniziali (vedi ContactStore::letterGroup)
+     * @return Indice del primo contatto del gruppo (o del gruppo successivo, se vuoto)
+     * @details Tempo costante: i contatori per iniziale sono aggiornati da ogni modifica.
+     */
+    qsizetype letterStart(int group) const;
+
+    /**
+     * @brief Numero di contatti con l'iniziale nel gruppo
+     * @param[in] group Gruppo di iniziali (vedi ContactStore::letterGroup)
+     */
+    qsizetype letterCount(int group) const;
+
+    /**
+     * @brief Statistiche della cache dei risultati di ricerca
+     * @return Hit, miss e numero di query in cache
+     * @details La cache viene svuotata a ogni modifica della lista (aggiunta,
+     * rimozione, modifica, ordinamento), i contatori restano invariati.
+     */
+    SearchIndex::CacheStats searchCacheStats() const;
+
     /**
      * @brief Restituisce tutti i contatti
      * @return Vector con copia di tutti i contatti
-     * @note Complessità O(n) visto che deve scorrere tutta la lista
+     * @note Complessità O(n); le stringhe sono condivise (implicit sharing), non copiate
      */
     QVector<Contact> allContacts() const;
 
+    /**
+     * @brief Telefoni di tutti i contatti in forma compatta, nell'ordine della lista
+     * @return Riferimento alla colonna dei telefoni (nessuna copia)
+     * @details Da passare a ContactValidator::setExistingPhones per il controllo dei duplicati
+     */
+    const QVector<quint64> &phoneKeys() const;
+
+    /**
+     * @brief Cerca i contatti duplicati in tutta la rubrica
+     * @param[in] criteria Criteri di confronto (vedi DuplicateFinder)
+     * @return Gruppi di indici dei contatti duplicati
+     */
+    QVector<DuplicateFinder::Cluster> findDuplicates(
+        DuplicateFinder::Criteria criteria = {DuplicateFinder::Phone, DuplicateFinder::Email, DuplicateFinder::Name}) const;
+
+    /**
+     * @brief Unisce i contatti di ogni gruppo in un solo contatto
+     * @param[in] clusters Id dei contatti di ogni gruppo (vedi idsOf sui gruppi di findDuplicates)
+     * @return Numero di contatti rimossi
+     * @details
+     * - I gruppi sono per id: restano validi anche se la lista cambia tra la ricerca
+     *   e l'unione (es. un ricaricamento mentre si chiede conferma). Gli id non più
+     *   in rubrica vengono ignorati
+     * - Un contatto viene unito solo a uno precedente dello stesso gruppo con lo stesso
+     *   telefono e un'email uguale o vuota: l'unione non perde mai un telefono né
+     *   un'email. Gli omonimi (gruppi trovati solo per nome) con numeri diversi
+     *   restano contatti separati
+     * - Se il contatto che resta non ha l'email prende quella del contatto unito
+     * - I contatti uniti vengono rimossi con una sola compattazione delle colonne
+     * @emits dataChanged() se almeno un contatto viene rimosso
+     */
+    qsizetype mergeDuplicates(const QVector<QVector<quint64>> &clusters);
+
+    /**
+     * @brief Attiva o disattiva l'interning di nomi e domini email
+     * @param[in] enabled true per memorizzare nomi e domini una sola volta
+     * @details Utile per le rubriche molto grandi, dove nomi, cognomi e domini
+     * si ripetono: vedi ContactStore::setInterning. I contatti non cambiano.
+     */
+    void setInterning(bool enabled);
+
+    /**
+     * @brief Verifica se l'interning è attivo
+     */
+    bool isInterning() const;
+
+    /**
+     * @brief Memoria occupata dalla rubrica, per struttura
+     */
+    struct MemoryUsage
+    {
+        ContactStore::MemoryReport store; /**< Colonne, stringhe e pool dei contatti */
+        SearchIndex::MemoryUsage search;  /**< Buffer, indici e cache della ricerca */
+        qsizetype peakLoadBytes = 0;      /**< Picco stimato durante l'ultimo loadFromFile */
+        qsizetype peakSortBytes = 0;      /**< Picco stimato durante l'ultimo ordinamento */
+        qsizetype historyBytes = 0;       /**< Passi salvati per annulla/ripeti */
+        qsizetype asyncSearchBytes = 0;   /**< Indice delle ricerche asincrone in corso (0 se nessuna) */
+        qsizetype sortOrderBytes = 0;     /**< Permutazioni degli ordinamenti alternativi */
+
+        /**
+         * @brief Memoria totale attuale (contatti, ricerca, ricerche asincrone, ordinamenti e annulla/ripeti)
+         */
+        qsizetype totalBytes() const
+        {
+            return store.actualBytes + search.total() + asyncSearchBytes + sortOrderBytes + historyBytes;
+        }
+    };
+
+    /**
+     * @brief Stima della memoria occupata dalla rubrica
+     * @return Memoria dei contatti e dell'indice di ricerca, picchi di caricamento e ordinamento
+     * @details
+     * Le cifre sono stime: contano la capacità dei vettori e i caratteri delle stringhe
+     * più un overhead fisso per allocazione, non la frammentazione dell'allocatore.
+     * L'indice di ricerca è contato com'è ora: può essere ancora da ricostruire.
+     * Quello delle ricerche asincrone conta solo mentre una di esse è in corso.
+     * @note Complessità O(n)
+     */
+    MemoryUsage memoryUsage() const;
+
+    /**
+     * @brief Annulla l'ultima modifica
+     * @retval true Modifica annullata
+     * @retval false Niente da annullare
+     * @details Le righe tornano nelle posizioni salvate, senza riordinare la lista.
+     * Un caricamento da file si annulla in un solo passo (vedi UndoLog).
+     * @emits dataChanged() se una modifica è stata annullata
+     */
+    bool undo();
+
+    /**
+     * @brief Ripete l'ultima modifica annullata
+     * @retval true Modifica ripetuta
+     * @retval false Niente da ripetere
+     * @emits dataChanged() se una modifica è stata ripetuta
+     */
+    bool redo();
+
+    /**
+     * @brief Verifica se c'è una modifica da annullare
+     */
+    bool canUndo() const;
+
+    /**
+     * @brief Verifica se c'è una modifica da ripetere
+     */
+    bool canRedo() const;
+
+    /**
+     * @brief Dimentica le modifiche salvate (es. dopo il caricamento iniziale)
+     */
+    void clearHistory();
+
+    /**
+     * @brief Versione immutabile della rubrica
+     * @return Snapshot con i contatti dopo una modifica completata
+     * @details
+     * - Nel thread della lista restituisce la versione attuale, creata se serve
+     * - Da un altro thread restituisce l'ultima versione pubblicata, letta con
+     *   std::atomic_load: è aggiornata entro kPublishDelayMs da ogni modifica, ma
+     *   esiste solo mentre c'è almeno un lettore registrato con addSnapshotReader()
+     *   (altrimenti il risultato è nullo). std::atomic_load su shared_ptr non è
+     *   lock-free (libstdc++ usa un lock interno), ma il lock copre solo la copia
+     *   del puntatore
+     *
+     * Lo snapshot non vede le modifiche successive.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Registra un lettore che chiama snapshot() da un altro thread
+     * @details Finché c'è almeno un lettore registrato, le modifiche vengono
+     * pubblicate con un ritardo di kPublishDelayMs. Da chiamare nel thread della lista.
+     */
+    void addSnapshotReader();
+
+    /**
+     * @brief Annulla una chiamata ad addSnapshotReader()
+     * @details Uscito l'ultimo lettore la versione pubblicata viene rilasciata: non
+     * resta in memoria, e le modifiche successive non devono copiare le colonne.
+     */
+    void removeSnapshotReader();
+
+    /**
+     * @brief Versione della lista
+     * @return Contatore incrementato da ogni modifica (anche da undo e redo)
+     */
+    quint64 revision() const;
+
+    /**
+     * @brief Contatti toccati da una modifica
+     */
+    struct ChangeSet
+    {
+        QVector<quint64> ids; /**< Id dei contatti aggiunti, rimossi o modificati */
+        bool all = true;      /**< true se è cambiata tutta la rubrica (es. un caricamento): ids è vuoto */
+    };
+
+    /**
+     * @brief Contatti toccati dall'ultima modifica
+     * @details Valido durante la gestione di dataChanged(): permette alla vista di
+     * aggiornare solo le righe dei contatti indicati invece di ricostruirsi.
+     */
+    const ChangeSet &lastChange() const;
+
+    /**
+     * @brief Verifica se ci sono modifiche non ancora salvate
+     * @retval true La versione attuale è diversa dall'ultima salvata
+     * @retval false Nessuna modifica dall'ultimo markSaved()
+     */
+    bool isModified() const;
+
+    /**
+     * @brief Registra che una versione è stata salvata
+     * @param[in] revision Versione salvata (quella dello snapshot scritto su file)
+     * @details Se nel frattempo la lista è cambiata, resta modificata. Una versione
+     * più vecchia di quella già salvata viene ignorata.
+     */
+    void markSaved(quint64 revision);
+
+    /**
+     * @brief Scrive i contatti di un archivio in un file CSV
+     * @param[in] store Archivio da scrivere (tipicamente uno snapshot)
+     * @param[in] filePath Percorso del file
+     * @param[out] bytesWritten Se non nullo, riceve i byte scritti
+     * @param[in] progress Se valida, riceve i contatti scritti e il totale;
+     *                     se restituisce false il salvataggio viene annullato
+     * @retval true Salvataggio riuscito
+     * @retval false Errore nel salvataggio o salvataggio annullato (il file esistente resta intatto)
+     * @details Stesso formato di saveToFile. Non tocca la lista: con uno snapshot
+     * si può salvare da un altro thread mentre la GUI continua a modificare.
+     * Il file viene scritto a parte e sostituito solo a scrittura completata
+     * (QSaveFile): un'interruzione non lascia mai un CSV troncato.
+     */
+    static bool saveStore(const ContactStore &store, const QString &filePath, qint64 *bytesWritten = nullptr,
+                          const Progress &progress = Progress());
+
+    /**
+     * @brief Costruisce l'indice di ricerca di un archivio
+     * @param[in] store Archivio da indicizzare (tipicamente uno snapshot)
+     * @param[out] index Indice da riempire (viene svuotato)
+     * @details Una sola passata sulle colonne. Con uno snapshot si può cercare da
+     * un altro thread, con un SearchIndex proprio di quel thread.
+     */
+    static void indexStore(const ContactStore &store, SearchIndex &index);
+
     /**
      * @brief Verifica l'esistenza di un contatto
      * @param[in] name Nome esatto da cercare (case-sensitive) oppure numero di telefono
@@ -132,14 +623,14 @@ public:
      * @brief Conta i contatti presenti
      * @return Numero di contatti nella lista
      */
-    constexpr size_t size() const;
+    size_t size() const;
 
     /**
      * @brief Verifica se la lista è vuota
      * @retval true Lista vuota
      * @retval false Lista contiene elementi
      */
-    constexpr bool isEmpty() const;
+    bool isEmpty() const;
 
     /**
      * @brief Salvataggio su file CSV
@@ -160,21 +651,215 @@ public:
     /**
      * @brief Caricamento da file CSV
      * @param[in] filePath Percorso del file (default: "contacts.csv")
+     * @param[out] errors Se non nullo, riceve gli errori di validazione
+     *                    (row è il numero di riga nel file, partendo da 1)
      * @retval true Caricamento riuscito
      * @retval false Errore nel caricamento
      * @details
      * Il file deve avere il formato:
      * Nome,Telefono,Email\n
      * (Un contatto per riga senza intestazione)
-     * @note Sostituisce tutti i contatti esistenti
+     *
+     * Tutte le righe vengono validate in un solo passaggio con ContactValidator:
+     * gli errori vengono riportati, ma anche le righe non valide vengono caricate
+     * (altrimenti il salvataggio successivo le cancellerebbe dal file). La
+     * validazione blocca solo i nuovi inserimenti e le modifiche. Anche le righe
+     * malformate diventano contatti: una riga senza virgole è un nome, le colonne
+     * oltre la terza restano nell'email; si saltano solo le righe vuote. La lista
+     * viene ordinata una sola volta, dopo aver inserito tutti i contatti.
+     * @note Sostituisce tutti i contatti esistenti; la rubrica precedente resta
+     *       nell'UndoLog (spostata, non copiata) e il caricamento si può annullare
      * @emits dataChanged() se il caricamento ha successo
      */
-    bool loadFromFile(const QString &filePath = "contacts.csv");
+    bool loadFromFile(const QString &filePath = "contacts.csv",
+                      QVector<ContactValidator::Error> *errors = nullptr);
+
+    /**
+     * @brief Sostituisce tutti i contatti con quelli di un archivio già pronto
+     * @param[in] store Nuovo archivio (spostato, non copiato), ordinato se possibile
+     * @details Come loadFromFile ma senza lettura del file: l'archivio può essere
+     * costruito e ordinato in un altro thread. La rubrica precedente resta
+     * nell'UndoLog e la sostituzione si può annullare.
+     * @emits dataChanged()
+     */
+    void replaceStore(ContactStore store);
+
+    /**
+     * @brief Legge e valida i contatti di un file CSV, senza toccare la lista
+     * @param[in] filePath Percorso del file
+     * @param[out] contacts Contatti letti, nell'ordine del file
+     * @param[out] errors Se non nullo, riceve gli errori di validazione
+     *                    (row è il numero di riga nel file, partendo da 1)
+     * @param[in] progress Se valida, riceve i byte letti e la dimensione del file;
+     *                     se restituisce false la lettura si interrompe
+     * @param[in] dropInvalid Se true, le righe non valide non finiscono in contacts
+     *                        (es. importazione); di default vengono tenute
+     * @retval true File letto
+     * @retval false Impossibile aprire il file, o lettura interrotta
+     * @details Stesso formato e stesse regole di loadFromFile. È statico:
+     * si può chiamare da un altro thread.
+     */
+    static bool readFile(const QString &filePath, QVector<Contact> &contacts,
+                         QVector<ContactValidator::Error> *errors = nullptr,
+                         const Progress &progress = Progress(), bool dropInvalid = false);
+
+    /**
+     * @brief Costruisce un archivio ordinato da un lotto di contatti
+     * @param[in] contacts Contatti (es. letti con readFile), in qualsiasi ordine
+     * @return Archivio da passare a replaceStore
+     * @details Aggiunta in coda e un solo ordinamento finale. È statico:
+     * si può chiamare da un altro thread.
+     */
+    static ContactStore makeStore(QVector<Contact> contacts);
+
+    /**
+     * @brief Nuovi telefono ed email di un contatto esistente
+     */
+    struct FieldUpdate
+    {
+        quint64 id = 0; /**< Id del contatto */
+        QString phone;  /**< Nuovo telefono */
+        QString email;  /**< Nuova email */
+    };
+
+    /**
+     * @brief Differenza tra due versioni della rubrica, riferita agli id
+     */
+    struct Batch
+    {
+        QVector<quint64> removed;     /**< Id dei contatti da rimuovere */
+        QVector<FieldUpdate> updated; /**< Contatti con lo stesso nome e altri dati */
+        QVector<Contact> inserted;    /**< Contatti nuovi */
+
+        /**
+         * @brief Verifica se la differenza è vuota
+         */
+        bool isEmpty() const { return removed.isEmpty() && updated.isEmpty() && inserted.isEmpty(); }
+    };
+
+    /**
+     * @brief Contatto di una versione della rubrica, in forma compatta
+     */
+    struct DigestEntry
+    {
+        quint64 name = 0; /**< Impronta (hash a 64 bit) del nome */
+        quint64 data = 0; /**< Impronta di telefono ed email */
+        quint64 id = 0;   /**< Id del contatto */
+    };
+
+    /**
+     * @brief Versione della rubrica ridotta a quanto serve a diff: id e impronte
+     * @details 24 byte per contatto, ordinati per impronta del nome e poi per id.
+     * A differenza di uno snapshot non condivide le colonne con la lista: tenerla
+     * non costringe le modifiche successive a copiarle.
+     */
+    using Digest = QVector<DigestEntry>;
+
+    /**
+     * @brief Impronta compatta di un archivio
+     * @param[in] store Archivio (tipicamente uno snapshot)
+     * @return Un elemento per contatto, nell'ordine di Digest
+     * @details O(n log n); è statico: si può chiamare da un altro thread.
+     */
+    static Digest digest(const ContactStore &store);
+
+    /**
+     * @brief Porta un'impronta alla versione descritta da una differenza
+     * @param[in,out] digest Impronta da cui è stata calcolata batch, resta ordinata
+     * @param[in] batch Differenza calcolata con diff
+     * @param[in] inserted Contatti di batch.inserted con l'id assegnato (vedi applyBatch)
+     * @details O(n + k log k): rimozioni e aggiornamenti in una passata, inserimenti con una fusione.
+     */
+    static void applyToDigest(Digest &digest, const Batch &batch, const QVector<Contact> &inserted);
+
+    /**
+     * @brief Calcola le modifiche che portano una versione della rubrica ai contatti indicati
+     * @param[in] base Impronta della versione di partenza (vedi digest)
+     * @param[in] contacts Nuova versione dei contatti (es. letta con readFile), in qualsiasi ordine
+     * @return Rimozioni, aggiornamenti e inserimenti, riferiti agli id di base
+     * @details
+     * Merge join sull'impronta del nome: la base è già ordinata, vanno ordinati solo
+     * i nuovi contatti (O(n log n) in tutto). A parità di nome i contatti identici si
+     * abbinano per primi, poi quelli con altri dati diventano aggiornamenti; un nome
+     * cambiato è una rimozione più un inserimento. È statico: si può chiamare da un
+     * altro thread.
+     * @note Le impronte sono hash a 64 bit: due nomi diversi con la stessa impronta
+     * (probabilità trascurabile) verrebbero trattati come lo stesso nome.
+     */
+    static Batch diff(const Digest &base, QVector<Contact> contacts);
+
+    /**
+     * @brief Applica una differenza come una sola modifica
+     * @param[in] batch Differenza calcolata da diff (anche su uno snapshot meno recente)
+     * @param[out] inserted Se non nullo, riceve i contatti inseriti con l'id assegnato
+     * @return Numero di modifiche applicate (contatti rimossi e inseriti, campi cambiati)
+     * @details
+     * - Gli id che non sono più in rubrica vengono ignorati
+     * - Una sola compattazione per le rimozioni, un solo insertRows per gli inserimenti
+     * - La modifica si annulla in un solo passo
+     * @emits dataChanged() una sola volta, se qualcosa cambia
+     */
+    qsizetype applyBatch(const Batch &batch, QVector<Contact> *inserted = nullptr);
+
+    /**
+     * @brief Caricamento in background
+     * @param[in] filePath Percorso del file
+     * @return Future con un LoadResult; annullato se interrotto con cancel()
+     * @details
+     * Lettura, validazione e ordinamento avvengono nel pool dei lavori asincroni
+     * (asyncPool), la sostituzione dei contatti nel thread della lista, come
+     * replaceStore: il future finisce quando la lista è già aggiornata.
+     * L'avanzamento va da 0 a kProgressRange. Dopo un cancel() la lista non cambia.
+     * @emits dataChanged() se il caricamento ha successo
+     */
+    QFuture<LoadResult> loadAsync(const QString &filePath = "contacts.csv");
+
+    /**
+     * @brief Salvataggio in background
+     * @param[in] filePath Percorso del file
+     * @return Future con l'esito di saveStore; annullato se interrotto con cancel()
+     * @details Scrive lo snapshot attuale: le modifiche successive non entrano
+     * nel file. Se riesce, quella versione risulta salvata (markSaved).
+     * Un salvataggio annullato lascia intatto il file esistente.
+     */
+    QFuture<bool> saveAsync(const QString &filePath = "contacts.csv");
+
+    /**
+     * @brief Ricerca in background
+     * @param[in] query Stringa di ricerca (stessa sintassi di search)
+     * @param[in] limit Numero massimo di risultati (negativo = tutti)
+     * @return Future con i contatti trovati in ordine di nome, disponibili a pagine
+     *         mentre la ricerca procede (QFutureWatcher::resultsReadyAt)
+     * @details Cerca nello snapshot attuale con un indice proprio dei lavori
+     * asincroni, ricostruito solo se la rubrica è cambiata. Più ricerche
+     * procedono insieme: si alternano sull'indice una pagina alla volta.
+     * L'avanzamento è riferito al numero stimato di risultati.
+     */
+    QFuture<Contact> searchAsync(const QString &query, int limit = -1);
+
+    /**
+     * @brief Importazione in background
+     * @param[in] filePath File CSV con i contatti da aggiungere
+     * @return Future con un ImportResult; annullato se interrotto con cancel()
+     * @details
+     * I contatti validi vengono aggiunti a quelli esistenti in una sola modifica
+     * (vedi applyBatch), annullabile con undo. I contatti con un telefono già in
+     * rubrica vengono saltati, compresi quelli aggiunti durante l'importazione.
+     * @emits dataChanged() se almeno un contatto viene aggiunto
+     */
+    QFuture<ImportResult> importAsync(const QString &filePath);
+
+    /**
+     * @brief Pool dei lavori asincroni della lista
+     * @details Separato dal pool globale di Qt: i lavori lunghi della rubrica
+     * non rallentano gli altri e il distruttore aspetta solo i propri.
+     */
+    QThreadPool *asyncPool() { return &m_asyncPool; }
 
     /**
      * @brief Accesso diretto a un contatto per indice
      * @param[in] index Posizione nella lista (partendo da 0)
-     * @return Contatto alla posizione richiesta
+     * @return Contatto alla posizione richiesta (O(1))
      * @throw Contact vuoto Se l'indice è invalido
      */
     Contact at(size_t index) const;
@@ -188,7 +873,7 @@ public:
      * @post La lista viene riordinata automaticamente
      * @emits dataChanged() se l'aggiornamento ha successo
      */
-    bool updateAt(size_t index, const Contact &updatedContact);
+    bool updateAt(size_t index, Contact updatedContact);
 
 signals:
     /**
@@ -202,27 +887,116 @@ signals:
     void dataChanged();
 
 private:
-    Node *m_head; /**< Puntatore alla testa della lista */
-    size_t m_count;  /**< Contatore dei nodi presenti */
+    /**
+     * @brief Indice delle ricerche asincrone, con lo snapshot a cui si riferisce
+     * @details Vive finché c'è una ricerca che lo usa, anche dopo che un'altra ne ha
+     * costruito uno più recente. open e fetch aggiornano le cache interne
+     * dell'indice: vanno chiamati con mutex, una pagina alla volta.
+     */
+    struct AsyncSearch
+    {
+        Snapshot snapshot;  /**< Versione indicizzata */
+        SearchIndex index;  /**< Indice di snapshot */
+        QMutex mutex;       /**< Serializza open e fetch sull'indice */
+    };
+
+    ContactStore m_store; /**< Contatti memorizzati a colonne */
+    UndoLog m_history;    /**< Modifiche da annullare e ripetere */
+    mutable SearchIndex m_searchIndex;  /**< Buffer contiguo usato dalla ricerca */
+    mutable bool m_searchIndexDirty;    /**< true se la lista è cambiata dall'ultima costruzione dell'indice */
+    mutable SortOrders m_sortOrders;    /**< Permutazioni per gli altri criteri, aggiornate a ogni modifica */
+    SortOrders::Key m_sortKey = SortOrders::FirstName; /**< Criterio con cui mostrare la rubrica */
+    qsizetype m_peakLoadBytes = 0;      /**< Picco di memoria stimato dell'ultimo caricamento */
+    qsizetype m_peakSortBytes = 0;      /**< Picco di memoria stimato dell'ultimo ordinamento */
+    Snapshot m_snapshot;                /**< Ultima versione pubblicata per gli altri thread, nulla senza lettori (solo std::atomic_load/atomic_store) */
+    mutable std::weak_ptr<const ContactStore> m_currentSnapshot; /**< Snapshot di m_currentSnapshotRevision, se qualcuno lo tiene */
+    mutable quint64 m_currentSnapshotRevision = 0; /**< Versione di m_currentSnapshot */
+    int m_snapshotReaders = 0;          /**< Lettori registrati con addSnapshotReader */
+    QTimer m_publishTimer;              /**< Raggruppa le pubblicazioni per i lettori registrati */
+    quint64 m_revision = 0;             /**< Versione attuale, incrementata da commitChange */
+    quint64 m_savedRevision = 0;        /**< Ultima versione salvata */
+    ChangeSet m_lastChange;             /**< Contatti toccati dall'ultima modifica */
+    QThreadPool m_asyncPool;            /**< Thread dei lavori asincroni (loadAsync, saveAsync, ...) */
+    std::atomic<bool> m_closing{false}; /**< true durante la distruzione: i lavori in corso si interrompono */
+    mutable QMutex m_asyncSearchMutex;  /**< Protegge m_asyncSearch (controllo e ricostruzione) */
+    std::weak_ptr<AsyncSearch> m_asyncSearch; /**< Indice delle ricerche asincrone in corso, condiviso tra quelle sulla stessa versione */
+
+    /**
+     * @brief Aggiorna le permutazioni dopo un annulla o ripeti
+     * @param[in] delta Righe toccate dal passo (vedi UndoLog::Delta)
+     * @details I passi su una riga si riapplicano come un inserimento o una
+     * rimozione; quelli su più righe invalidano la cache.
+     */
+    void replayDelta(const UndoLog::Delta &delta);
+
+    /**
+     * @brief Conclude una modifica di tutta la rubrica (vedi announceChange)
+     */
+    void commitChange();
+
+    /**
+     * @brief Conclude una modifica dei contatti indicati (vedi lastChange())
+     * @param[in] ids Id dei contatti aggiunti, rimossi o modificati
+     */
+    void commitChange(QVector<quint64> ids);
+
+    /**
+     * @brief Nuova versione, indice invalidato, pubblicazione programmata, dataChanged()
+     */
+    void announceChange();
+
+    /**
+     * @brief Snapshot della versione attuale (solo nel thread della lista)
+     * @details Riusa quello già creato se nessuna modifica è avvenuta e qualcuno lo tiene ancora.
+     */
+    Snapshot currentSnapshot() const;
+
+    /**
+     * @brief Pubblica la versione attuale per i lettori degli altri thread
+     * @details La copia condivide le colonne (O(1)); lo snapshot precedente viene
+     * liberato dall'ultimo lettore che lo rilascia.
+     */
+    void publish();
 
     /**
      * @brief Svuota completamente la lista
-     * @details
-     * Dealloca tutti i nodi e reimposta lo stato iniziale
      */
     void clear();
 
     /**
-     * @brief Ricerca un nodo per nome
-     * @param[in] name Nome esatto da cercare (case-sensitive) oppure numero di telefono
-     * @return Puntatore al nodo trovato o nullptr
+     * @brief Sostituisce il contatto alla posizione indicata e lo sposta al suo posto
+     * @param[in] index Indice valido
+     * @param[in] updatedContact Nuovi dati del contatto
+     * @details La riga viene tolta e reinserita con ricerca binaria (invece di
+     * riordinare tutta la lista), così la modifica si registra come un solo spostamento.
+     */
+    void updateRow(qsizetype index, Contact updatedContact);
+
+    /**
+     * @brief Restituisce l'indice di ricerca aggiornato
+     * @details
+     * L'indice viene ricostruito (una sola passata sulle colonne) solo se la lista
+     * è cambiata dall'ultima ricerca.
+     */
+    const SearchIndex &searchIndex() const;
+
+    /**
+     * @brief Aggiunge in fondo alla tabella i contatti indicati
+     * @param[in] table Tabella da popolare
+     * @param[in] indices Indici dei contatti, nell'ordine in cui mostrarli
+     * @param[in] at Riga della tabella da cui inserire (-1 = in fondo)
+     * @details
+     * - Per ogni riga salva l'id del contatto (qulonglong) nel Qt::UserRole dell'item "Nome"
+     * - I contatti che non rispettano le regole di ContactValidator (es. caricati da un
+     *   file scritto a mano) hanno lo sfondo evidenziato e il motivo nel tooltip.
+     *   Il controllo dei duplicati richiede tutta la rubrica e non viene rifatto qui.
      */
-    Node *findNode(const QString &value) const;
+    void appendToTable(QTableWidget *table, const QVector<int> &indices, int at = -1) const;
 
     /**
      * @brief Ordina la lista per nome
      * @details
-     * Implementa l'algoritmo merge sort ricorsivo.
+     * Delega a ContactStore::sort, che confronta solo la colonna delle chiavi.
      * L'ordinamento è:
      * - Crescente
      * - Case-insensitive
@@ -0,0 +1,235 @@
+/**
+ * @file loadgen.cpp
+ * @brief Generatore di carico per il server di ricerca locale
+ *
+ * @details
+ * Apre più connessioni al LookupServer, ognuna in un thread proprio, e invia
+ * richieste una dopo l'altra per la durata indicata. Alla fine stampa le
+ * richieste e le interrogazioni al secondo e la latenza di una richiesta
+ * (mediana, 99° percentile, massimo), misurata dall'invio alla risposta completa.
+ *
+ * Esempio (con la rubrica aperta e Strumenti > Server di ricerca attivo):
+ * @code
+ * RubricaLoadGen --connections 4 --batch 8 --mode phone --phones contacts.csv
+ * @endcode
+ */
+
+#include "lookupprotocol.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_loadgen_namespace {
+
+/**
+ * @brief Parametri della misura
+ */
+struct Options
+{
+    QString serverName;
+    int connections = 1;
+    int seconds = 10;
+    int batch = 1;
+    QString mode;       /**< phone, prefix, search o mix */
+    QStringList phones; /**< Numeri da cercare (vuoto = numeri casuali) */
+};
+
+/**
+ * @brief Risultato di una connessione
+ */
+struct Worker
+{
+    std::vector<qint64> latencies; /**< Durata di ogni richiesta (ns) */
+    quint64 queries = 0;
+    quint64 found = 0;             /**< Interrogazioni con almeno un contatto */
+    QString error;
+};
+
+/**
+ * @brief Numeri di telefono dalla seconda colonna di un CSV della rubrica
+ */
+QStringList readPhones(const QString &filePath)
+{
+    QStringList phones;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return phones;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList parts = in.readLine().split(',');
+        if (parts.size() >= 2 && !parts[1].trimmed().isEmpty())
+            phones.append(parts[1].trimmed());
+    }
+    return phones;
+}
+
+/**
+ * @brief Interrogazione casuale del tipo richiesto
+ */
+LookupProtocol::Query makeQuery(const Options &options, std::mt19937 &random)
+{
+    static const QStringList kSearches{"ma", "ro", "gi", "an", "lu", "fra", "gmail", "^b", "ross", "pa"};
+
+    LookupProtocol::Query query;
+    QString mode = options.mode;
+    if (mode == "mix") {
+        static const QStringList kModes{"phone", "phone", "prefix", "search"}; // prevale il caso del softphone
+        mode = kModes[random() % kModes.size()];
+    }
+
+    if (mode == "search") {
+        query.op = LookupProtocol::Search;
+        query.limit = 20;
+        query.key = kSearches[random() % kSearches.size()];
+        return query;
+    }
+
+    QString phone = options.phones.isEmpty()
+                        ? QString("3%1").arg(random() % 1000000000u, 9, 10, QChar(u'0'))
+                        : options.phones[random() % options.phones.size()];
+    if (mode == "prefix") {
+        query.op = LookupProtocol::Prefix;
+        query.limit = 20;
+        query.key = phone.left(4);
+    } else {
+        query.op = LookupProtocol::Phone;
+        query.limit = 1;
+        query.key = phone;
+    }
+    return query;
+}
+
+/**
+ * @brief Invia richieste fino alla scadenza e misura ogni risposta
+ */
+void run(const Options &options, int index, qint64 deadline, const QElapsedTimer &clock, Worker *worker)
+{
+    QLocalSocket socket;
+    socket.connectToServer(options.serverName);
+    if (!socket.waitForConnected(1000)) {
+        worker->error = socket.errorString();
+        return;
+    }
+
+    std::mt19937 random(quint32(index) + 1);
+    QByteArray buffer;
+    QByteArray payload;
+    for (quint32 id = 1; clock.nsecsElapsed() < deadline; ++id) {
+        QVector<LookupProtocol::Query> queries;
+        for (int i = 0; i < options.batch; ++i)
+            queries.append(makeQuery(options, random));
+        const QByteArray request = LookupProtocol::frame(LookupProtocol::encodeRequest(id, queries));
+
+        const qint64 sent = clock.nsecsElapsed();
+        socket.write(request);
+        socket.flush();
+
+        bool invalid = false;
+        while (!LookupProtocol::takeFrame(buffer, &payload, &invalid)) {
+            if (invalid || !socket.waitForReadyRead(5000)) {
+                worker->error = invalid ? QString("Risposta non valida") : socket.errorString();
+                return;
+            }
+            buffer.append(socket.readAll());
+        }
+        worker->latencies.push_back(clock.nsecsElapsed() - sent);
+
+        quint32 answered = 0;
+        QVector<LookupProtocol::Answer> answers;
+        if (!LookupProtocol::decodeResponse(payload, &answered, &answers) || answered != id) {
+            worker->error = "Risposta non valida";
+            return;
+        }
+        worker->queries += quint64(answers.size());
+        for (const LookupProtocol::Answer &answer : answers)
+            worker->found += answer.status == LookupProtocol::Ok ? 1 : 0;
+    }
+}
+
+} // namespace m_loadgen_namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace m_loadgen_namespace;
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RubricaLoadGen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Misura richieste al secondo e latenza del server di ricerca della rubrica");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"server", "Nome del socket locale.", "nome", LookupProtocol::kDefaultServerName},
+        {"connections", "Connessioni contemporanee, una per thread.", "n", "4"},
+        {"duration", "Durata della misura in secondi.", "s", "10"},
+        {"batch", "Interrogazioni per richiesta.", "n", "1"},
+        {"mode", "Tipo di interrogazioni: phone, prefix, search o mix.", "tipo", "phone"},
+        {"phones", "CSV della rubrica da cui prendere i numeri (altrimenti casuali).", "file"},
+    });
+    parser.process(app);
+
+    Options options;
+    options.serverName = parser.value("server");
+    options.connections = std::max(1, parser.value("connections").toInt());
+    options.seconds = std::max(1, parser.value("duration").toInt());
+    options.batch = std::clamp(parser.value("batch").toInt(), 1, LookupProtocol::kMaxQueries);
+    options.mode = parser.value("mode");
+    if (!QStringList{"phone", "prefix", "search", "mix"}.contains(options.mode))
+        parser.showHelp(1);
+    if (parser.isSet("phones"))
+        options.phones = readPhones(parser.value("phones"));
+
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 deadline = qint64(options.seconds) * 1000000000;
+    std::vector<Worker> workers(size_t(options.connections));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; ++i)
+        threads.emplace_back(run, std::cref(options), i, deadline, std::cref(clock), &workers[size_t(i)]);
+    for (std::thread &thread : threads)
+        thread.join();
+    const double elapsed = clock.nsecsElapsed() / 1e9;
+
+    QTextStream out(stdout);
+    std::vector<qint64> latencies;
+    quint64 queries = 0;
+    quint64 found = 0;
+    for (const Worker &worker : workers) {
+        if (!worker.error.isEmpty())
+            out << "Errore: " << worker.error << "\n";
+        latencies.insert(latencies.end(), worker.latencies.begin(), worker.latencies.end());
+        queries += worker.queries;
+        found += worker.found;
+    }
+    if (latencies.empty())
+        return 1;
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, size_t(p * double(latencies.size())))] / 1e6;
+    };
+    out << QString("%1 connessioni, %2 interrogazioni per richiesta, modalità %3\n")
+               .arg(options.connections)
+               .arg(options.batch)
+               .arg(options.mode);
+    out << QString("Richieste: %1 (%2 al secondo)\n").arg(latencies.size()).arg(latencies.size() / elapsed, 0, 'f', 0);
+    out << QString("Interrogazioni: %1 (%2 al secondo), %3 con risultati\n")
+               .arg(queries)
+               .arg(queries / elapsed, 0, 'f', 0)
+               .arg(found);
+    out << QString("Latenza (ms): mediana %1, 99° percentile %2, massimo %3\n")
+               .arg(percentile(0.50), 0, 'f', 3)
+               .arg(percentile(0.99), 0, 'f', 3)
+               .arg(latencies.back() / 1e6, 0, 'f', 3);
+    return 0;
+}
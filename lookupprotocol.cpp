@@ -0,0 +1,156 @@
+/**
+ * @file lookupprotocol.cpp
+ * @brief LookupProtocol class implementation
+ */
+
+#include "lookupprotocol.hpp"
+#include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_lookupprotocol_namespace {
+
+constexpr qsizetype kHeaderSize = qsizetype(sizeof(quint32)); /**< Lunghezza davanti a ogni frame */
+
+/**
+ * @brief Stream con il formato fissato dal protocollo
+ */
+void setupStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_5);
+    stream.setByteOrder(QDataStream::BigEndian);
+}
+
+/**
+ * @brief Legge l'intestazione comune di richieste e risposte
+ * @return Numero di elementi che seguono, -1 se l'intestazione non è valida
+ */
+int readHeader(QDataStream &in, quint32 *id)
+{
+    quint8 version = 0;
+    quint16 count = 0;
+    in >> version >> *id >> count;
+    if (in.status() != QDataStream::Ok || version != LookupProtocol::kVersion)
+        return -1;
+    return count;
+}
+
+/**
+ * @brief Legge un testo scritto in UTF-8
+ */
+QString readText(QDataStream &in)
+{
+    QByteArray utf8;
+    in >> utf8;
+    return QString::fromUtf8(utf8);
+}
+
+} // namespace m_lookupprotocol_namespace
+
+QByteArray LookupProtocol::frame(const QByteArray &payload)
+{
+    QByteArray bytes(m_lookupprotocol_namespace::kHeaderSize, Qt::Uninitialized);
+    qToBigEndian(quint32(payload.size()), bytes.data());
+    bytes.append(payload);
+    return bytes;
+}
+
+bool LookupProtocol::takeFrame(QByteArray &buffer, QByteArray *payload, bool *invalid)
+{
+    using namespace m_lookupprotocol_namespace;
+    *invalid = false;
+    if (buffer.size() < kHeaderSize)
+        return false;
+
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    if (length > quint32(kMaxFrame)) {
+        *invalid = true;
+        return false;
+    }
+    if (buffer.size() < kHeaderSize + qsizetype(length))
+        return false;
+
+    *payload = buffer.mid(kHeaderSize, length);
+    buffer.remove(0, kHeaderSize + length);
+    return true;
+}
+
+QByteArray LookupProtocol::encodeRequest(quint32 id, const QVector<Query> &queries)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    m_lookupprotocol_namespace::setupStream(out);
+    out << kVersion << id << quint16(queries.size());
+    for (const Query &query : queries)
+        out << quint8(query.op) << query.limit << query.key.toUtf8();
+    return payload;
+}
+
+bool LookupProtocol::decodeRequest(const QByteArray &payload, quint32 *id, QVector<Query> *queries)
+{
+    using namespace m_lookupprotocol_namespace;
+    QDataStream in(payload);
+    setupStream(in);
+    const int count = readHeader(in, id);
+    if (count < 0 || count > kMaxQueries)
+        return false;
+
+    queries->clear();
+    queries->reserve(count);
+    for (int i = 0; i < count; ++i) {
+        quint8 op = 0;
+        Query query;
+        in >> op >> query.limit;
+        query.op = Op(op); // un tipo sconosciuto riceve BadRequest, non chiude la connessione
+        query.key = readText(in);
+        queries->append(std::move(query));
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray LookupProtocol::encodeResponse(quint32 id, const QVector<Answer> &answers)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    m_lookupprotocol_namespace::setupStream(out);
+    out << kVersion << id << quint16(answers.size());
+    for (const Answer &answer : answers) {
+        out << quint8(answer.status) << quint16(answer.matches.size());
+        for (const Match &match : answer.matches)
+            out << match.name.toUtf8() << match.phone.toUtf8() << match.email.toUtf8();
+    }
+    return payload;
+}
+
+bool LookupProtocol::decodeResponse(const QByteArray &payload, quint32 *id, QVector<Answer> *answers)
+{
+    using namespace m_lookupprotocol_namespace;
+    QDataStream in(payload);
+    setupStream(in);
+    const int count = readHeader(in, id);
+    if (count < 0)
+        return false;
+
+    answers->clear();
+    answers->reserve(count);
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint8 status = 0;
+        quint16 matches = 0;
+        Answer answer;
+        in >> status >> matches;
+        answer.status = Status(status);
+        answer.matches.reserve(std::min<int>(matches, kMaxResults));
+        for (int m = 0; m < matches && in.status() == QDataStream::Ok; ++m) {
+            Match match;
+            match.name = readText(in);
+            match.phone = readText(in);
+            match.email = readText(in);
+            answer.matches.append(std::move(match));
+        }
+        answers->append(std::move(answer));
+    }
+    return in.status() == QDataStream::Ok;
+}
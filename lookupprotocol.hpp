@@ -0,0 +1,146 @@
+/**
+ * @file lookupprotocol.hpp
+ * @brief Protocollo binario del server di ricerca locale
+ *
+ * @details
+ * Ogni messaggio è un frame: lunghezza del contenuto (quint32 big-endian)
+ * seguita dal contenuto, scritto con QDataStream. Una richiesta contiene più
+ * interrogazioni (batch) e riceve una sola risposta, con le risposte nello
+ * stesso ordine e lo stesso id della richiesta.
+ *
+ * Richiesta: versione (quint8), id (quint32), numero di interrogazioni (quint16),
+ * poi per ognuna tipo (quint8), limite (quint16) e chiave (UTF-8).
+ *
+ * Risposta: versione (quint8), id (quint32), numero di risposte (quint16),
+ * poi per ognuna esito (quint8), numero di contatti (quint16) e per ogni
+ * contatto nome, telefono ed email (UTF-8).
+ */
+
+#ifndef LOOKUPPROTOCOL_HPP
+#define LOOKUPPROTOCOL_HPP
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class LookupProtocol
+ * @brief Codifica e decodifica dei messaggi del server di ricerca
+ *
+ * @details Usata sia dal server (LookupServer) sia dai client, come il generatore
+ * di carico. Le funzioni di decodifica rifiutano messaggi troncati, di una versione
+ * diversa o oltre i limiti.
+ */
+class LookupProtocol
+{
+public:
+    LookupProtocol() = delete;
+
+    static constexpr quint8 kVersion = 1;               /**< Versione del protocollo */
+    static constexpr qsizetype kMaxFrame = 1 << 20;     /**< Dimensione massima del contenuto di un frame (byte) */
+    static constexpr int kMaxQueries = 256;             /**< Interrogazioni massime in una richiesta */
+    static constexpr int kMaxResults = 100;             /**< Contatti massimi in una risposta a un'interrogazione */
+    static constexpr char kDefaultServerName[] = "rubrica-lookup"; /**< Nome predefinito del socket locale */
+
+    /**
+     * @brief Tipo di interrogazione
+     */
+    enum Op : quint8 {
+        Phone = 1,  /**< Numero esatto (identificativo del chiamante), anche con prefisso internazionale */
+        Prefix = 2, /**< Numeri che iniziano con le cifre date, in ordine di numero */
+        Search = 3  /**< Ricerca testuale, stessa sintassi di ContactList::search, in ordine di nome */
+    };
+
+    /**
+     * @brief Esito di un'interrogazione
+     */
+    enum Status : quint8 {
+        Ok = 0,        /**< Almeno un contatto trovato */
+        NotFound = 1,  /**< Nessun contatto */
+        BadRequest = 2 /**< Tipo sconosciuto o chiave non valida */
+    };
+
+    /**
+     * @brief Interrogazione
+     */
+    struct Query
+    {
+        Op op = Phone;
+        quint16 limit = 1; /**< Contatti richiesti (al massimo kMaxResults) */
+        QString key;       /**< Numero, cifre iniziali o testo da cercare */
+    };
+
+    /**
+     * @brief Contatto restituito
+     */
+    struct Match
+    {
+        QString name;
+        QString phone;
+        QString email;
+    };
+
+    /**
+     * @brief Risposta a un'interrogazione
+     */
+    struct Answer
+    {
+        Status status = NotFound;
+        QVector<Match> matches;
+    };
+
+    /**
+     * @brief Aggiunge la lunghezza davanti al contenuto
+     * @param[in] payload Contenuto del frame
+     * @return Frame pronto da scrivere sul socket
+     */
+    static QByteArray frame(const QByteArray &payload);
+
+    /**
+     * @brief Estrae il primo frame completo dai byte ricevuti
+     * @param[in,out] buffer Byte ricevuti: il frame estratto viene rimosso
+     * @param[out] payload Contenuto del frame
+     * @param[out] invalid true se la lunghezza supera kMaxFrame (la connessione va chiusa)
+     * @retval true Frame estratto
+     * @retval false Frame incompleto o non valido
+     */
+    static bool takeFrame(QByteArray &buffer, QByteArray *payload, bool *invalid);
+
+    /**
+     * @brief Codifica una richiesta
+     * @param[in] id Identificativo scelto dal client, ripetuto nella risposta
+     * @param[in] queries Interrogazioni (al massimo kMaxQueries)
+     * @return Contenuto del frame
+     */
+    static QByteArray encodeRequest(quint32 id, const QVector<Query> &queries);
+
+    /**
+     * @brief Decodifica una richiesta
+     * @param[in] payload Contenuto del frame
+     * @param[out] id Identificativo della richiesta
+     * @param[out] queries Interrogazioni
+     * @retval true Richiesta valida
+     * @retval false Messaggio troncato, di un'altra versione o con troppe interrogazioni
+     */
+    static bool decodeRequest(const QByteArray &payload, quint32 *id, QVector<Query> *queries);
+
+    /**
+     * @brief Codifica una risposta
+     * @param[in] id Identificativo della richiesta
+     * @param[in] answers Una risposta per interrogazione, nello stesso ordine
+     * @return Contenuto del frame
+     */
+    static QByteArray encodeResponse(quint32 id, const QVector<Answer> &answers);
+
+    /**
+     * @brief Decodifica una risposta
+     * @param[in] payload Contenuto del frame
+     * @param[out] id Identificativo della richiesta
+     * @param[out] answers Risposte
+     * @retval true Risposta valida
+     * @retval false Messaggio troncato o di un'altra versione
+     */
+    static bool decodeResponse(const QByteArray &payload, quint32 *id, QVector<Answer> *answers);
+};
+
+#endif // LOOKUPPROTOCOL_HPP
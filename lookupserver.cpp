@@ -0,0 +1,313 @@
+/**
+ * @file lookupserver.cpp
+ * @brief LookupServer class implementation
+ */
+
+#include "lookupserver.hpp"
+#include "profiler.hpp"
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <algorithm>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_lookupserver_namespace {
+
+using PhoneEntry = std::pair<quint64, int>;
+
+/**
+ * @brief Cifre di un numero, senza i separatori usati per scriverlo
+ * @param[in] text Numero come arriva dal client (es. "+39 333 123-4567")
+ * @param[out] digits Solo le cifre
+ * @retval false Il testo contiene caratteri che non sono cifre né separatori
+ */
+bool phoneDigits(const QString &text, QString *digits)
+{
+    static const QString separators = QStringLiteral(" +-./()");
+    digits->clear();
+    for (const QChar c : text) {
+        if (c >= u'0' && c <= u'9')
+            digits->append(c);
+        else if (!separators.contains(c))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Confronto per std::lower_bound sul solo numero
+ */
+bool keyLess(const PhoneEntry &entry, quint64 key)
+{
+    return entry.first < key;
+}
+
+} // namespace m_lookupserver_namespace
+
+/**
+ * @class LookupServer::Engine
+ * @brief Socket e strutture di ricerca, nel thread del server
+ */
+class LookupServer::Engine : public QObject
+{
+public:
+    Engine(ContactList *list, Counters &counters)
+        : m_list(list)
+        , m_counters(counters)
+    {}
+
+    /**
+     * @brief Mette il server in ascolto
+     */
+    bool listen(const QString &name, QString *serverName, QString *error)
+    {
+        m_server = new QLocalServer(this);
+        m_server->setSocketOptions(QLocalServer::UserAccessOption);
+        if (!m_server->listen(name) && m_server->serverError() == QAbstractSocket::AddressInUseError) {
+            // il socket può essere rimasto da un'esecuzione interrotta: lo rimuovo solo se nessuno risponde
+            QLocalSocket probe;
+            probe.connectToServer(name);
+            if (!probe.waitForConnected(100)) {
+                QLocalServer::removeServer(name);
+                m_server->listen(name);
+            }
+        }
+        if (!m_server->isListening()) {
+            *error = m_server->errorString();
+            return false;
+        }
+
+        *serverName = m_server->fullServerName();
+        connect(m_server, &QLocalServer::newConnection, this, [this]() { acceptConnections(); });
+        return true;
+    }
+
+private:
+    ContactList *m_list;                         /**< Rubrica servita (solo snapshot()) */
+    Counters &m_counters;                        /**< Contatori del LookupServer */
+    QLocalServer *m_server = nullptr;            /**< Socket in ascolto */
+    QHash<QLocalSocket *, QByteArray> m_buffers; /**< Byte ricevuti e non ancora elaborati, per client */
+    ContactList::Snapshot m_snapshot;            /**< Versione servita */
+    QVector<m_lookupserver_namespace::PhoneEntry> m_phones; /**< Telefoni di m_snapshot, ordinati */
+    SearchIndex m_searchIndex;                   /**< Indice testuale di m_snapshot */
+    bool m_searchIndexDirty = true;              /**< true se m_searchIndex non è di m_snapshot */
+
+    /**
+     * @brief Registra le nuove connessioni
+     */
+    void acceptConnections()
+    {
+        while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+            m_counters.connections++;
+            m_buffers.insert(socket, QByteArray());
+            connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+            connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+    /**
+     * @brief Risponde a tutte le richieste complete ricevute da un client
+     */
+    void readRequests(QLocalSocket *socket)
+    {
+        QByteArray &buffer = m_buffers[socket];
+        buffer.append(socket->readAll());
+
+        QByteArray payload;
+        bool invalid = false;
+        while (LookupProtocol::takeFrame(buffer, &payload, &invalid)) {
+            const Profiler::Scope scope("LookupServer::request");
+            quint32 id = 0;
+            QVector<LookupProtocol::Query> queries;
+            if (!LookupProtocol::decodeRequest(payload, &id, &queries)) {
+                invalid = true;
+                break;
+            }
+
+            refresh();
+            QVector<LookupProtocol::Answer> answers;
+            answers.reserve(queries.size());
+            for (const LookupProtocol::Query &query : queries) {
+                if (query.op == LookupProtocol::Search && m_searchIndexDirty) {
+                    ContactList::indexStore(*m_snapshot, m_searchIndex);
+                    m_searchIndexDirty = false;
+                }
+                answers.append(answer(*m_snapshot, m_phones, m_searchIndex, query));
+            }
+            socket->write(LookupProtocol::frame(LookupProtocol::encodeResponse(id, answers)));
+            m_counters.requests++;
+            m_counters.queries += quint64(queries.size());
+        }
+
+        // con un frame non valido il resto del flusso non è più interpretabile
+        if (invalid) {
+            m_counters.rejected++;
+            socket->abort();
+        }
+    }
+
+    /**
+     * @brief Passa all'ultima versione pubblicata della rubrica, se è cambiata
+     */
+    void refresh()
+    {
+        ContactList::Snapshot snapshot = m_list->snapshot();
+        if (snapshot == m_snapshot)
+            return;
+        const Profiler::Scope scope("LookupServer::rebuild");
+        m_snapshot = std::move(snapshot);
+        m_phones = indexPhones(*m_snapshot);
+        m_searchIndexDirty = true; // ricostruito solo alla prima ricerca testuale
+        m_counters.rebuilds++;
+    }
+};
+
+LookupServer::LookupServer(ContactList *list, QObject *parent)
+    : QObject(parent)
+    , m_list(list)
+{
+    m_thread.setObjectName("LookupServer");
+}
+
+LookupServer::~LookupServer()
+{
+    stop();
+}
+
+bool LookupServer::start(const QString &name)
+{
+    if (isRunning())
+        return true;
+
+    m_engine = new Engine(m_list, m_counters);
+    m_engine->moveToThread(&m_thread);
+    // l'Engine (con socket e strutture) viene distrutto nel suo thread
+    connect(&m_thread, &QThread::finished, m_engine, &QObject::deleteLater);
+    m_thread.start();
+
+    bool ok = false;
+    QString serverName;
+    QString error;
+    Engine *engine = m_engine;
+    QMetaObject::invokeMethod(
+        engine, [engine, &ok, &name, &serverName, &error]() { ok = engine->listen(name, &serverName, &error); },
+        Qt::BlockingQueuedConnection);
+
+    if (!ok) {
+        stop();
+        m_errorString = error;
+        return false;
+    }
+    m_serverName = serverName;
+    m_errorString.clear();
+    m_list->addSnapshotReader();
+    return true;
+}
+
+void LookupServer::stop()
+{
+    if (!m_thread.isRunning())
+        return;
+    m_thread.quit();
+    m_thread.wait();
+    m_engine = nullptr;
+    if (!m_serverName.isEmpty())
+        m_list->removeSnapshotReader(); // solo se start() era riuscito
+    m_serverName.clear();
+}
+
+LookupServer::Stats LookupServer::stats() const
+{
+    Stats stats;
+    stats.connections = m_counters.connections;
+    stats.requests = m_counters.requests;
+    stats.queries = m_counters.queries;
+    stats.rejected = m_counters.rejected;
+    stats.rebuilds = m_counters.rebuilds;
+    return stats;
+}
+
+LookupProtocol::Answer LookupServer::answer(const ContactStore &store,
+                                            const QVector<std::pair<quint64, int>> &phones,
+                                            const SearchIndex &index, const LookupProtocol::Query &query)
+{
+    using namespace m_lookupserver_namespace;
+    LookupProtocol::Answer result;
+    const int limit = std::clamp<int>(query.limit, 1, LookupProtocol::kMaxResults);
+    QVector<int> rows;
+
+    switch (query.op) {
+    case LookupProtocol::Phone:
+    case LookupProtocol::Prefix: {
+        QString digits;
+        if (!phoneDigits(query.key, &digits) || digits.isEmpty()) {
+            result.status = LookupProtocol::BadRequest;
+            return result;
+        }
+
+        quint64 first = 0; // intervallo [first, last) dei valori compatti cercati
+        quint64 last = 0;
+        if (query.op == LookupProtocol::Phone) {
+            // l'identificativo del chiamante può avere il prefisso internazionale: contano le ultime 10 cifre
+            if (!PhoneNumber::pack(QStringView(digits).right(PhoneNumber::kDigits), &first)) {
+                result.status = LookupProtocol::NotFound; // meno di 10 cifre: nessun numero conforme
+                return result;
+            }
+            last = first + 1;
+        } else {
+            if (digits.size() > PhoneNumber::kDigits) {
+                result.status = LookupProtocol::BadRequest;
+                return result;
+            }
+            // "333" copre da 3330000000 (incluso) a 3340000000 (escluso)
+            quint64 scale = 1;
+            for (qsizetype i = digits.size(); i < PhoneNumber::kDigits; ++i)
+                scale *= 10;
+            first = digits.toULongLong() * scale;
+            last = first + scale;
+        }
+
+        for (auto it = std::lower_bound(phones.cbegin(), phones.cend(), first, keyLess);
+             it != phones.cend() && it->first < last && rows.size() < limit; ++it)
+            rows.append(it->second);
+        break;
+    }
+    case LookupProtocol::Search: {
+        if (query.key.trimmed().isEmpty()) {
+            result.status = LookupProtocol::BadRequest;
+            return result;
+        }
+        SearchIndex::Cursor cursor = index.open(query.key);
+        rows = index.fetch(cursor, limit);
+        break;
+    }
+    default:
+        result.status = LookupProtocol::BadRequest;
+        return result;
+    }
+
+    result.status = rows.isEmpty() ? LookupProtocol::NotFound : LookupProtocol::Ok;
+    result.matches.reserve(rows.size());
+    for (const int row : rows)
+        result.matches.append(LookupProtocol::Match{store.name(row), store.phone(row), store.email(row)});
+    return result;
+}
+
+QVector<std::pair<quint64, int>> LookupServer::indexPhones(const ContactStore &store)
+{
+    const QVector<quint64> &keys = store.phoneKeys();
+    QVector<std::pair<quint64, int>> phones;
+    phones.reserve(keys.size());
+    for (qsizetype row = 0; row < keys.size(); ++row) {
+        if (!PhoneNumber::isOverflow(keys[row]))
+            phones.append({keys[row], int(row)});
+    }
+    // a parità di numero resta l'ordine per nome
+    std::sort(phones.begin(), phones.end());
+    return phones;
+}
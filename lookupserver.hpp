@@ -0,0 +1,149 @@
+/**
+ * @file lookupserver.hpp
+ * @brief Server di ricerca su socket locale, per l'identificativo del chiamante
+ *
+ * @details
+ * Altri programmi sullo stesso computer (es. il softphone, che deve mostrare il
+ * nome di chi chiama entro pochi millisecondi) interrogano la rubrica con il
+ * protocollo di LookupProtocol invece di leggere contacts.csv.
+ * Il server gira in un thread proprio e risponde da uno snapshot della rubrica
+ * (vedi ContactList::snapshot): la GUI non aspetta mai le richieste e le
+ * richieste non aspettano mai la GUI.
+ */
+
+#ifndef LOOKUPSERVER_HPP
+#define LOOKUPSERVER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <utility>
+#include "list.hpp"
+#include "lookupprotocol.hpp"
+
+/**
+ * @class LookupServer
+ * @brief Risponde alle interrogazioni per numero, prefisso e testo
+ *
+ * @details
+ * - Numero e prefisso usano un array dei telefoni ordinato (ricerca binaria),
+ *   la ricerca testuale un SearchIndex proprio del thread del server
+ * - Le strutture vengono ricostruite nel thread del server alla prima richiesta
+ *   dopo una modifica della rubrica; l'indice testuale solo se serve
+ * - I numeri non conformi (non di 10 cifre) si trovano solo con la ricerca testuale
+ * - Una richiesta con più interrogazioni usa un solo snapshot per tutte
+ * - Mentre il server è attivo è registrato come lettore della lista
+ *   (ContactList::addSnapshotReader): vede le modifiche entro
+ *   ContactList::kPublishDelayMs
+ *
+ * Va creato, usato e distrutto nel thread della lista (la GUI).
+ */
+class LookupServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Contatori delle richieste servite
+     */
+    struct Stats
+    {
+        quint64 connections = 0; /**< Connessioni accettate */
+        quint64 requests = 0;    /**< Richieste (frame) servite */
+        quint64 queries = 0;     /**< Interrogazioni servite */
+        quint64 rejected = 0;    /**< Richieste non valide (la connessione viene chiusa) */
+        quint64 rebuilds = 0;    /**< Ricostruzioni delle strutture dopo una modifica */
+    };
+
+    /**
+     * @brief Costruttore
+     * @param[in] list Rubrica da servire (deve sopravvivere al server)
+     * @param[in] parent Oggetto padre nella gerarchia Qt (opzionale)
+     */
+    explicit LookupServer(ContactList *list, QObject *parent = nullptr);
+
+    /**
+     * @brief Distruttore
+     * @details Chiude le connessioni e aspetta la fine del thread del server.
+     */
+    ~LookupServer();
+
+    /**
+     * @brief Avvia il server
+     * @param[in] name Nome del socket locale
+     * @retval true Server in ascolto
+     * @retval false Nome già in uso da un altro server attivo o non valido (vedi errorString)
+     * @details Un socket rimasto da un'esecuzione interrotta viene rimosso.
+     */
+    bool start(const QString &name = LookupProtocol::kDefaultServerName);
+
+    /**
+     * @brief Ferma il server e chiude le connessioni
+     */
+    void stop();
+
+    /**
+     * @brief Verifica se il server è in ascolto
+     */
+    bool isRunning() const { return m_thread.isRunning(); }
+
+    /**
+     * @brief Percorso completo del socket (da passare ai client)
+     */
+    QString serverName() const { return m_serverName; }
+
+    /**
+     * @brief Errore dell'ultimo start() non riuscito
+     */
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief Contatori dall'avvio dell'applicazione
+     * @details Si può chiamare mentre il server risponde.
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Risponde a un'interrogazione su un archivio
+     * @param[in] store Archivio (tipicamente uno snapshot)
+     * @param[in] phones Coppie (telefono compatto, riga) ordinate, vedi indexPhones
+     * @param[in] index Indice di ricerca dell'archivio, usato solo da Search
+     * @param[in] query Interrogazione
+     * @return Contatti trovati, al massimo query.limit e LookupProtocol::kMaxResults
+     */
+    static LookupProtocol::Answer answer(const ContactStore &store,
+                                         const QVector<std::pair<quint64, int>> &phones,
+                                         const SearchIndex &index, const LookupProtocol::Query &query);
+
+    /**
+     * @brief Ordina i telefoni conformi di un archivio per numero
+     * @param[in] store Archivio
+     * @return Coppie (telefono compatto, riga), senza i numeri non conformi
+     */
+    static QVector<std::pair<quint64, int>> indexPhones(const ContactStore &store);
+
+private:
+    class Engine;
+
+    /**
+     * @brief Contatori aggiornati dal thread del server
+     */
+    struct Counters
+    {
+        std::atomic<quint64> connections{0};
+        std::atomic<quint64> requests{0};
+        std::atomic<quint64> queries{0};
+        std::atomic<quint64> rejected{0};
+        std::atomic<quint64> rebuilds{0};
+    };
+
+    ContactList *m_list;        /**< Rubrica servita (solo snapshot() dal thread del server) */
+    QThread m_thread;           /**< Thread del server, con il suo ciclo di eventi */
+    Engine *m_engine = nullptr; /**< Socket e strutture di ricerca, vive in m_thread */
+    QString m_serverName;       /**< Percorso del socket in ascolto */
+    QString m_errorString;      /**< Errore dell'ultimo avvio */
+    Counters m_counters;        /**< Condivisi con il thread del server */
+};
+
+#endif // LOOKUPSERVER_HPP
@@ -6,33 +6,179 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "utils.hpp"
+#include "emaildomains.hpp"
+#include "profiler.hpp"
+#include <QActionGroup>
+#include <QCloseEvent>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFutureWatcher>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QItemSelection>
+#include <QProgressDialog>
+#include <QScrollBar>
+#include <QToolButton>
+#include <QVBoxLayout>
+#include <QSet>
+#include <algorithm>
+#include <numeric>
+#include <utility>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_contactList(this)
+    , m_autoSaver(&m_contactList, "contacts.csv", this)
+    , m_fileWatcher(&m_contactList, "contacts.csv", this)
+    , m_books(this)
+    , m_lookupServer(&m_contactList, this)
 {
+    m_books.addBook(&m_contactList, "contacts.csv");
     ui->setupUi(this);
     initializeUI();
 
     // i connect servono a collegare un segnale ad uno slot
     connect(&m_contactList, &ContactList::dataChanged,
             this, &MainWindow::onContactListChanged);
+    connect(&m_autoSaver, &AutoSaver::saved, this, [this](bool ok) {
+        if (ok) {
+            // la nostra scrittura non è una modifica esterna
+            if (const ContactList::Snapshot saved = m_autoSaver.takeLastSaved())
+                m_fileWatcher.acknowledge(saved);
+        } else {
+            ui->statusbar->showMessage("Salvataggio automatico di contacts.csv non riuscito");
+        }
+    });
+    connect(&m_fileWatcher, &FileWatcher::reloaded, this, [this](qsizetype changes, qsizetype rejected) {
+        QString message = QString("contacts.csv modificato esternamente: %1 modifiche applicate").arg(changes);
+        if (rejected > 0)
+            message += QString(", %1 righe non valide").arg(rejected);
+        ui->statusbar->showMessage(message);
+    });
 
-    // Carico i contatti se esistenti e aggiorno la tabella
-    m_contactList.loadFromFile();
-    refreshContactTable();
+    // Domini email ammessi: se esiste il file di configurazione sostituisce l'elenco predefinito
+    EmailDomains::loadFromFile();
+
+    // Carico i contatti in background: la finestra resta reattiva anche con rubriche grandi
+    startInitialLoad();
 }
 
 MainWindow::~MainWindow()
 {
-    // Salvo i contatti quando chiudo l'applicazione
-    m_contactList.saveToFile();
+    // le ultime modifiche sono già state salvate (o scartate dall'utente) in closeEvent
     delete ui;
 }
 
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    // salvo qui e non nel distruttore: se la scrittura fallisce l'utente può ancora scegliere
+    while (!m_autoSaver.flush()) {
+        QMessageBox box(QMessageBox::Warning, "Salvataggio non riuscito",
+                        "Non è stato possibile salvare le ultime modifiche in contacts.csv.",
+                        QMessageBox::Cancel, this);
+        QPushButton *retryButton = box.addButton("Riprova", QMessageBox::AcceptRole);
+        QPushButton *saveAsButton = box.addButton("Salva con nome...", QMessageBox::ActionRole);
+        QPushButton *discardButton = box.addButton("Chiudi senza salvare", QMessageBox::DestructiveRole);
+        box.setDefaultButton(retryButton);
+        box.exec();
+
+        if (box.clickedButton() == retryButton)
+            continue;
+        if (box.clickedButton() == discardButton)
+            break;
+        if (box.clickedButton() != saveAsButton) {
+            event->ignore(); // la finestra resta aperta con le modifiche
+            return;
+        }
+
+        const QString filePath = QFileDialog::getSaveFileName(this, "Salva rubrica", "contacts.csv",
+                                                              "Rubrica CSV (*.csv)");
+        if (filePath.isEmpty())
+            continue;
+        // contacts.csv resta com'era: le modifiche sono nel file scelto
+        if (m_contactList.saveToFile(filePath))
+            break;
+        QMessageBox::warning(this, "Errore", QString("Impossibile salvare la rubrica in %1").arg(filePath));
+    }
+    event->accept();
+}
+
+void MainWindow::startInitialLoad()
+{
+    // fino alla fine del caricamento la rubrica non si modifica: verrebbe sostituita
+    ui->centralwidget->setEnabled(false);
+    ui->menubar->setEnabled(false);
+    m_loadProgress = new QProgressBar(this);
+    m_loadProgress->setRange(0, ContactList::kProgressRange);
+    m_loadProgress->setMaximumWidth(200);
+    ui->statusbar->addPermanentWidget(m_loadProgress);
+    ui->statusbar->showMessage("Caricamento di contacts.csv...");
+
+    auto *watcher = new QFutureWatcher<ContactList::LoadResult>(this);
+    connect(watcher, &QFutureWatcherBase::progressValueChanged, m_loadProgress, &QProgressBar::setValue);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        onInitialLoadFinished(watcher->future());
+    });
+    watcher->setFuture(m_contactList.loadAsync("contacts.csv"));
+}
+
+void MainWindow::onInitialLoadFinished(const QFuture<ContactList::LoadResult> &future)
+{
+    ui->statusbar->removeWidget(m_loadProgress);
+    delete m_loadProgress;
+    m_loadProgress = nullptr;
+    ui->centralwidget->setEnabled(true);
+    ui->menubar->setEnabled(true);
+    ui->statusbar->clearMessage();
+
+    const ContactList::LoadResult result =
+        future.resultCount() > 0 ? future.result() : ContactList::LoadResult();
+
+    m_contactList.clearHistory(); // il caricamento iniziale non si annulla
+    // ogni riga non vuota del file è in rubrica, anche se non valida: la rubrica
+    // corrisponde al file. Se il file esiste ma non si è potuto leggere no:
+    // il primo salvataggio lo sostituirebbe con una rubrica vuota
+    const bool unreadable = !result.ok && QFile::exists("contacts.csv");
+    if (!unreadable)
+        m_contactList.markSaved(m_contactList.revision());
+    m_fileWatcher.acknowledge(m_contactList.snapshot());
+    refreshContactTable();
+    updateUndoActions();
+
+    if (unreadable) {
+        m_autoSaver.setBackupPath("contacts.csv.bak");
+        QMessageBox::warning(this, "Attenzione",
+                             "Impossibile leggere contacts.csv. Prima di riscriverlo "
+                             "ne verrà salvata una copia in contacts.csv.bak.");
+        return;
+    }
+
+    // Le righe non valide vengono caricate comunque: ne mostro un riepilogo e,
+    // prima di riscrivere il file, ne conservo una copia com'era
+    const QVector<ContactValidator::Error> &loadErrors = result.errors;
+    if (!loadErrors.isEmpty()) {
+        m_autoSaver.setBackupPath("contacts.csv.bak");
+        QString message = QString("%1 errori in contacts.csv. Le righe non valide sono state caricate "
+                                  "e sono evidenziate nella tabella: correggile o eliminale. "
+                                  "Prima di riscrivere il file ne verrà salvata una copia in "
+                                  "contacts.csv.bak.\n")
+                              .arg(loadErrors.size());
+        const qsizetype shown = std::min<qsizetype>(loadErrors.size(), 10);
+        for (qsizetype i = 0; i < shown; ++i) {
+            message += QString("\nRiga %1: %2")
+                           .arg(loadErrors[i].row)
+                           .arg(ContactValidator::describe(loadErrors[i]));
+        }
+        if (loadErrors.size() > shown)
+            message += QString("\n...");
+        QMessageBox::warning(this, "Attenzione", message);
+    }
+}
+
 void MainWindow::initializeUI()
 {
     // Configuro la tabella, 3 colonne Nome, Telefono, Email
@@ -41,12 +187,79 @@ void MainWindow::initializeUI()
     QStringList headers{"Nome", "Telefono", "Email"};
     ui->tableWidget->setHorizontalHeaderLabels(headers);
     ui->tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+    // Ctrl/Shift + click per selezionare più contatti da eliminare o modificare insieme
+    ui->tableWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
     ui->tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
-
+    // Cliccando l'intestazione si sceglie l'ordine (vedi onHeaderClicked)
+    ui->tableWidget->horizontalHeader()->setSectionsClickable(true);
+    ui->tableWidget->horizontalHeader()->setSortIndicatorShown(true);
+    ui->tableWidget->horizontalHeader()->setSortIndicator(0, Qt::AscendingOrder);
+    connect(ui->tableWidget->horizontalHeader(), &QHeaderView::sectionClicked,
+            this, &MainWindow::onHeaderClicked);
 
     // Connetto l'input della ricerca
     connect(ui->inputSearch, &QLineEdit::textChanged, this, &MainWindow::on_inputSearch_textChanged);
+    connect(ui->chkFuzzy, &QCheckBox::toggled, this, &MainWindow::onSearchModeChanged);
+
+    // Le pagine successive vengono caricate scorrendo la tabella
+    connect(ui->tableWidget->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::onTableScrolled);
+
+    // Menu modifica
+    connect(ui->actionAnnulla, &QAction::triggered, this, &MainWindow::onUndoTriggered);
+    connect(ui->actionRipeti, &QAction::triggered, this, &MainWindow::onRedoTriggered);
+
+    // Barra delle iniziali accanto alla tabella: un pulsante per gruppo (vedi ContactStore::letterGroup)
+    auto *letterLayout = new QVBoxLayout(ui->letterBar);
+    letterLayout->setContentsMargins(0, 0, 0, 0);
+    letterLayout->setSpacing(0);
+    for (int group = 0; group < ContactStore::kLetterGroups; ++group) {
+        auto *button = new QToolButton(ui->letterBar);
+        button->setText(ContactStore::letterLabel(group));
+        button->setAutoRaise(true);
+        button->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+        letterLayout->addWidget(button);
+        connect(button, &QToolButton::clicked, this, [this, group]() { jumpToLetter(group); });
+        m_letterButtons.append(button);
+    }
+
+    // Menu visualizza: un solo ordine alla volta
+    auto *sortGroup = new QActionGroup(this);
+    const std::pair<QAction *, SortOrders::Key> sortActions[] = {
+        {ui->actionOrdinaNome, SortOrders::FirstName},
+        {ui->actionOrdinaCognome, SortOrders::Surname},
+        {ui->actionOrdinaTelefono, SortOrders::Phone},
+        {ui->actionOrdinaEmail, SortOrders::Email},
+        {ui->actionOrdinaRecenti, SortOrders::Modified},
+    };
+    for (const auto &sortAction : sortActions) {
+        const SortOrders::Key key = sortAction.second;
+        sortGroup->addAction(sortAction.first);
+        connect(sortAction.first, &QAction::triggered, this, [this, key]() { setSortKey(key); });
+    }
+    ui->actionOrdinaNome->setChecked(true);
+
+    // Menu rubriche
+    connect(ui->actionApriRubrica, &QAction::triggered, this, &MainWindow::onOpenBooksTriggered);
+    connect(ui->actionCercaRubriche, &QAction::triggered, this, &MainWindow::onSearchBooksTriggered);
+    connect(ui->actionImporta, &QAction::triggered, this, &MainWindow::onImportTriggered);
+
+    // Menu strumenti
+    connect(ui->actionTrovaDuplicati, &QAction::triggered, this, &MainWindow::onFindDuplicatesTriggered);
+    connect(ui->actionInterning, &QAction::toggled, this, &MainWindow::onInterningToggled);
+    connect(ui->actionMemoria, &QAction::triggered, this, &MainWindow::onMemoryUsageTriggered);
+    connect(ui->actionProfilazione, &QAction::toggled, this, &MainWindow::onProfilingToggled);
+    connect(ui->actionTempi, &QAction::triggered, this, &MainWindow::onTimingsTriggered);
+    connect(ui->actionServer, &QAction::toggled, this, &MainWindow::onServerToggled);
+
+    // Con RUBRICA_PROFILE impostata si misura anche il caricamento iniziale
+    if (qEnvironmentVariableIsSet("RUBRICA_PROFILE"))
+        ui->actionProfilazione->setChecked(true);
+
+    // Con RUBRICA_SERVER impostata il server di ricerca parte con l'applicazione
+    if (qEnvironmentVariableIsSet("RUBRICA_SERVER"))
+        ui->actionServer->setChecked(true);
 
     // Connetto tutti pulsanti della UI
     connect(ui->btnAggiungi, &QPushButton::clicked, this, &MainWindow::onAddButtonClicked);
@@ -68,32 +281,123 @@ void MainWindow::initializeUI()
 
 void MainWindow::refreshContactTable()
 {
-    m_searchResultsIndices.clear(); // Resetta gli indici
-    ui->tableWidget->setRowCount(0);
+    const Profiler::Scope scope("MainWindow::refreshContactTable");
+    // Ripeto la ricerca corrente: con la barra vuota vengono mostrati tutti i contatti,
+    // caricati a pagine man mano che si scorre la tabella, dalla posizione già raggiunta
+    showResults(ui->inputSearch->text());
+}
+
+void MainWindow::fetchNextPage()
+{
+    const Profiler::Scope scope("MainWindow::fetchNextPage");
+    // la tabella è una finestra su una sequenza nota: la pagina segue l'ultima riga mostrata
+    if (m_windowed) {
+        const qsizetype from = m_windowStart + ui->tableWidget->rowCount();
+        const qsizetype count = std::min<qsizetype>(kPageSize, windowSize() - from);
+        if (count <= 0)
+            return;
+        const QVector<int> page = windowRows(from, count);
+        m_contactList.showRows(ui->tableWidget, page);
+        m_searchResultIds += m_contactList.idsOf(page);
+        updateStatusBar();
+        return;
+    }
+
+    // ricerca in un ordine diverso dal nome: la permutazione viene scorsa una pagina alla volta
+    if (m_sortedSearch) {
+        const QVector<int> page = m_contactList.sortedPage(m_sortedCursor, kPageSize);
+        m_contactList.showRows(ui->tableWidget, page);
+        m_searchResultIds += m_contactList.idsOf(page);
+        updateStatusBar();
+        return;
+    }
+
+    if (m_searchCursor.atEnd())
+        return;
+
+    // Gli id della pagina si aggiungono a quelli già mostrati
+    m_searchResultIds += m_contactList.idsOf(m_contactList.searchPage(m_searchCursor, ui->tableWidget, kPageSize));
+    updateStatusBar();
+}
 
-    const auto contacts = m_contactList.allContacts();
-    for (size_t originalIndex = 0; originalIndex < contacts.size(); ++originalIndex) {
-        const auto &contact = contacts[originalIndex];
+void MainWindow::fetchPreviousPage()
+{
+    if (!m_windowed || m_windowStart == 0)
+        return;
 
-        // Aggiungi riga alla tabella
-        size_t row = ui->tableWidget->rowCount();
-        ui->tableWidget->insertRow(row);
+    const Profiler::Scope scope("MainWindow::fetchPreviousPage");
+    const qsizetype count = std::min<qsizetype>(kPageSize, m_windowStart);
+    const int topRow = std::max(ui->tableWidget->rowAt(0), 0);
+    m_windowStart -= count;
+    const QVector<int> page = windowRows(m_windowStart, count);
+    m_contactList.showRows(ui->tableWidget, page, 0);
+    m_searchResultIds = m_contactList.idsOf(page) + m_searchResultIds;
 
-        // Salva l'indice ORIGINALE
-        QTableWidgetItem *nameItem = new QTableWidgetItem(contact.name());
-        nameItem->setData(Qt::UserRole, originalIndex); // Salva indice originale
-        ui->tableWidget->setItem(row, 0, nameItem);
+    // la vista resta sugli stessi contatti, che ora sono count righe più in basso
+    if (QTableWidgetItem *item = ui->tableWidget->item(topRow + int(count), 0))
+        ui->tableWidget->scrollToItem(item, QAbstractItemView::PositionAtTop);
+    updateStatusBar();
+}
 
-        // Popola gli altri campi
-        QTableWidgetItem *phoneItem = new QTableWidgetItem(contact.phone());
-        QTableWidgetItem *emailItem = new QTableWidgetItem(contact.email());
+qsizetype MainWindow::windowSize() const
+{
+    return m_showAll ? qsizetype(m_contactList.size()) : m_sortedRows.size();
+}
 
-        ui->tableWidget->setItem(row, 1, phoneItem);
-        ui->tableWidget->setItem(row, 2, emailItem);
+QVector<int> MainWindow::windowRows(qsizetype from, qsizetype count) const
+{
+    if (!m_showAll)
+        return m_sortedRows.mid(from, count);
+
+    // tutta la rubrica in ordine di nome: la posizione è la riga
+    QVector<int> rows(count);
+    std::iota(rows.begin(), rows.end(), int(from));
+    return rows;
+}
 
-        // Memorizza l'indice originale
-        m_searchResultsIndices.append(originalIndex); // Riempie il vettore
+void MainWindow::updateStatusBar()
+{
+    const int shown = ui->tableWidget->rowCount();
+    QString message;
+
+    if (ui->chkFuzzy->isChecked()) {
+        message = QString("%1 risultati").arg(shown);
+    } else if (m_windowed) {
+        const qsizetype total = windowSize();
+        message = shown == total ? QString("%1 contatti").arg(total)
+                                 : QString("Contatti %1–%2 di %3")
+                                       .arg(m_windowStart + 1)
+                                       .arg(m_windowStart + shown)
+                                       .arg(total);
+    } else if (m_sortedSearch) {
+        message = m_sortedCursor.atEnd ? QString("%1 contatti").arg(m_sortedCursor.found)
+                                       : QString("Mostrati %1 di circa %2 contatti")
+                                             .arg(shown)
+                                             .arg(m_contactList.estimatedTotal(m_sortedCursor));
+    } else if (m_searchCursor.atEnd()) {
+        message = QString("%1 contatti").arg(m_searchCursor.found());
+    } else {
+        message = QString("Mostrati %1 di circa %2 contatti")
+                      .arg(shown)
+                      .arg(m_searchCursor.estimatedTotal());
     }
+
+    ui->statusbar->showMessage(message);
+}
+
+void MainWindow::onTableScrolled(int value)
+{
+    // la tabella viene svuotata prima di ogni nuova ricerca: niente da caricare
+    if (ui->tableWidget->rowCount() == 0)
+        return;
+
+    // Carico la pagina successiva quando manca meno di una schermata alla fine
+    const QScrollBar *scrollBar = ui->tableWidget->verticalScrollBar();
+    if (value >= scrollBar->maximum() - scrollBar->pageStep())
+        fetchNextPage();
+    // e quella precedente in cima, se la tabella non parte dal primo contatto (vedi jumpToLetter)
+    if (value == scrollBar->minimum())
+        fetchPreviousPage();
 }
 
 void MainWindow::onAddButtonClicked()
@@ -109,63 +413,20 @@ void MainWindow::onConfirmButtonClicked(){
     QString currentPhone = ui->inputTelefono->text().trimmed();
     QString currentEmail = ui->inputEmail->text().trimmed();
 
-    // Validazione nome e telefono, essi NON POSSONO essere vuoti,
-    // al contrario della email, ma se inserita deve essere valida
-    if(currentName.isEmpty()) {
-        showErrorMessage("Errore", "Il nome è obbligatorio");
-        ui->inputNome->setFocus();
-        return;
-    }
-    if(currentPhone.isEmpty()) {
-        showErrorMessage("Errore", "Il numero di telefono è obbligatorio");
-        ui->inputTelefono->setFocus();
-        return;
-    }
-
-    // converto la stringa del telefono in un numero
-    // toULongLong ritorna il valore di ok_phone,
-    // se ok_phone == false vuol dire che la stringa non era composta da soli numeri
-    bool ok_phone;
-    currentPhone.toULongLong(&ok_phone, 10);
-    if(!ok_phone){
-        QString message = QString("Il numero di telefono deve contenere solo cifre");
-        showErrorMessage("Errore", message);
-        ui->inputTelefono->selectAll();
-        ui->inputTelefono->setFocus();
-        return;
-    }
-
-    if(currentPhone.size() != 10 || !currentPhone.toLongLong()) {
-        QString message = QString("Devi inserire un numero di telefono a 10 cifre, hai inserito %1 cifre").arg(currentPhone.size());
-        showErrorMessage("Errore", message);
-        ui->inputTelefono->selectAll();
-        ui->inputTelefono->setFocus();
-        return;
-    }
+    // Validazione: nome e telefono NON POSSONO essere vuoti, il telefono deve avere
+    // 10 cifre e non essere già in rubrica, l'email è opzionale ma se inserita deve essere valida
+    Contact newContact(currentName, currentPhone, currentEmail);
+    ContactValidator validator;
+    validator.setExistingPhones(m_contactList.phoneKeys());
 
-    if(m_contactList.contains(currentPhone)){
-        QString message = QString("Numero di telefono già esistente");
-        showErrorMessage("Errore", message);
-        ui->inputTelefono->selectAll();
-        ui->inputTelefono->setFocus();
+    const QVector<ContactValidator::Error> errors = validator.validate(newContact);
+    if (!errors.isEmpty()) {
+        showValidationError(errors.first(), newContact, ui->inputNome, ui->inputTelefono, ui->inputEmail);
         return;
     }
 
-    // Validazione email (opzionale ma se presente deve essere valida)
-    if(!currentEmail.isEmpty()) {
-        Contact tempContact("", "", currentEmail);
-        if(!tempContact.isEmail()) {
-            showErrorMessage("Errore",
-                             "Inserisci un indirizzo email valido o lascia il campo vuoto");
-            ui->inputEmail->selectAll();
-            ui->inputEmail->setFocus();
-            return;
-        }
-    }
-
     // Se tutte le validazioni passano, creo un nuovo nodo e lo aggiungo alla lista
-    Contact newContact(currentName, currentPhone, currentEmail);
-    m_contactList.addContact(newContact);
+    m_contactList.addContact(std::move(newContact));
 
     // torno alla home page
     ui->stackedWidget->setCurrentIndex(0);
@@ -181,99 +442,142 @@ void MainWindow::onCancelButtonClicked(){
 
 void MainWindow::onRemoveButtonClicked()
 {
-    int currentRow = ui->tableWidget->currentRow();
-    if (currentRow < 0) {
+    const QVector<quint64> ids = selectedIds();
+    if (ids.isEmpty()) {
         showErrorMessage("Errore", "Seleziona un contatto da eliminare");
         return;
     }
 
-    QString name_to_delete = ui->tableWidget->item(currentRow, 0)->text();
+    // l'id identifica il contatto anche se ci sono omonimi; la tabella viene
+    // aggiornata da onContactListChanged
+    if (ids.size() == 1) {
+        if(m_contactList.removeById(ids.first())) {
+            QMessageBox::information(this, "Successo", "Contatto eliminato");
+        } else {
+            QMessageBox::warning(this, "Errore", "Eliminazione fallita");
+        }
+        return;
+    }
 
-    if(m_contactList.removeContact(name_to_delete)) {
-        QMessageBox::information(this, "Successo", "Contatto eliminato");
-        refreshContactTable();
-    } else {
-        QMessageBox::warning(this, "Errore", "Eliminazione fallita");
+    const QString question = QString("Eliminare i %1 contatti selezionati?").arg(ids.size());
+    if (QMessageBox::question(this, "Elimina", question) != QMessageBox::Yes)
+        return;
+
+    // una sola rimozione: una compattazione, un passo di annulla, un aggiornamento della tabella
+    const qsizetype removed = m_contactList.removeByIds(ids);
+    QMessageBox::information(this, "Successo", QString("%1 contatti eliminati").arg(removed));
+}
+
+void MainWindow::selectIds(const QVector<quint64> &ids)
+{
+    if (ids.isEmpty())
+        return;
+
+    const QSet<quint64> wanted(ids.cbegin(), ids.cend());
+    QItemSelection selection;
+    for (int row = 0; row < ui->tableWidget->rowCount(); ++row) {
+        const QModelIndex index = ui->tableWidget->model()->index(row, 0);
+        if (wanted.contains(index.data(Qt::UserRole).toULongLong()))
+            selection.select(index, index);
     }
+    // una sola selezione per tutte le righe, non una notifica per riga
+    ui->tableWidget->selectionModel()->select(selection, QItemSelectionModel::Select | QItemSelectionModel::Rows);
+}
+
+QVector<quint64> MainWindow::selectedIds() const
+{
+    const QModelIndexList rows = ui->tableWidget->selectionModel()->selectedRows(0);
+    QVector<quint64> ids;
+    ids.reserve(rows.size());
+    for (const QModelIndex &index : rows)
+        ids.append(index.data(Qt::UserRole).toULongLong());
+    return ids;
 }
 
 /*
  * SLOT: onEditButtonClicked
  * 
  * Triggerato quando si clicca "Modifica" su un contatto nella tabella filtrata.
- * - Recupera l'indice ORIGINALE dal Qt::UserRole dell'item Nome
- * - Popola i campi di modifica con i dati del contatto ORIGINALE
- * - Salva l'indice originale in m_editingRow per usarlo nella conferma
+ * - Recupera l'id del contatto dal Qt::UserRole dell'item Nome
+ * - Popola i campi di modifica con i dati del contatto
+ * - Salva l'id in m_editingId per usarlo nella conferma
  */
 void MainWindow::onEditButtonClicked()
 {
+    // con più righe selezionate si modifica solo l'email, tutte insieme
+    const QVector<quint64> ids = selectedIds();
+    if (ids.size() > 1) {
+        editSelectedEmails(ids);
+        return;
+    }
+
     int row = ui->tableWidget->currentRow();
     if (row < 0 || row >= ui->tableWidget->rowCount()) {
         showErrorMessage("Errore", "Seleziona un contatto valido");
         return;
     }
 
-    // Ottieni l'indice ORIGINALE dalla colonna "Nome"
+    // Ottieni l'id dalla colonna "Nome"
     QTableWidgetItem *nameItem = ui->tableWidget->item(row, 0);
-    int originalIndex = nameItem->data(Qt::UserRole).toInt();
+    const quint64 id = nameItem->data(Qt::UserRole).toULongLong();
 
     // Popola i campi di modifica
-    Contact contact = m_contactList.at(originalIndex);
+    Contact contact = m_contactList.contactById(id);
     ui->inputNome_2->setText(contact.name());
     ui->inputTelefono_2->setText(contact.phone());
     ui->inputEmail_2->setText(contact.email());
 
-    m_editingRow = originalIndex; // Conserva per la conferma
+    m_editingId = id; // Conserva per la conferma
     ui->stackedWidget->setCurrentIndex(2);
 }
 
-void MainWindow::on_btnConferma_2_clicked()
+void MainWindow::editSelectedEmails(const QVector<quint64> &ids)
 {
-    QString nome = ui->inputNome_2->text();
-    QString telefono = ui->inputTelefono_2->text();
-    QString email = ui->inputEmail_2->text();
-    if (nome.isEmpty() || telefono.isEmpty()) {
-        showErrorMessage("Errore", "Nome e telefono sono obbligatori");
+    bool ok = false;
+    const QString label = QString("Nuova email per i %1 contatti selezionati:").arg(ids.size());
+    const QString email = QInputDialog::getText(this, "Modifica email", label, QLineEdit::Normal, QString(), &ok)
+                              .trimmed();
+    if (!ok)
         return;
-    }
 
-    if (telefono.size() != 10 || !telefono.toLongLong()) {
-        showErrorMessage("Errore", "Telefono deve avere 10 cifre");
-        ui->inputTelefono->setFocus();
+    // il telefono non si modifica in blocco: deve essere diverso per ogni contatto
+    if (!Contact(QString(), QString(), email).isEmail()) {
+        showErrorMessage("Errore", "Email non valida");
         return;
     }
 
-    if (m_contactList.contains(telefono)) {
-        Contact contatto_attule = m_contactList.at(m_editingRow);
+    const qsizetype changed = m_contactList.updateField(ids, ContactStore::Email, email);
+    QMessageBox::information(this, "Successo", QString("%1 contatti modificati").arg(changed));
+}
 
-        if(contatto_attule.phone() != telefono){
-            QString message = QString("Numero di telefono già esistente");
-            showErrorMessage("Errore", message);
-            ui->inputTelefono->selectAll();
-            ui->inputTelefono->setFocus();
-            return;
-        }
-    }
+void MainWindow::on_btnConferma_2_clicked()
+{
+    QString nome = ui->inputNome_2->text().trimmed();
+    QString telefono = ui->inputTelefono_2->text().trimmed();
+    QString email = ui->inputEmail_2->text().trimmed();
+    Contact updatedContact(nome, telefono, email);
 
-    if (!email.isEmpty() && !Contact("", "", email).isEmail()) {
-        showErrorMessage("Errore", "Email non valida");
-        ui->inputEmail->setFocus();
+    // stesse regole dell'inserimento, ma il contatto in modifica può tenere il suo numero
+    ContactValidator validator;
+    validator.setExistingPhones(m_contactList.phoneKeys(), m_contactList.indexOfId(m_editingId));
+
+    const QVector<ContactValidator::Error> errors = validator.validate(updatedContact);
+    if (!errors.isEmpty()) {
+        showValidationError(errors.first(), updatedContact, ui->inputNome_2, ui->inputTelefono_2, ui->inputEmail_2);
         return;
     }
 
-    Contact updatedContact(nome, telefono, email);
-
-    // Usa l'indice originale conservato
-    m_contactList.updateAt(m_editingRow, updatedContact);
-
-    // Ri-applica la ricerca per aggiornare la vista
-    m_contactList.search(ui->inputSearch->text(), ui->tableWidget);
+    // Usa l'id conservato, la ricerca viene ri-applicata
+    // da onContactListChanged
+    if (!m_contactList.updateById(m_editingId, std::move(updatedContact)))
+        showErrorMessage("Errore", "Il contatto non è più presente in rubrica");
+    m_editingId = 0;
     ui->stackedWidget->setCurrentIndex(0);
 }
 
 void MainWindow::on_btnCancel_2_clicked() {
-    // imposto l'indice di selezioni a -1 e torno alla home page
-    m_editingRow = -1;
+    // azzero il contatto in modifica e torno alla home page
+    m_editingId = 0;
     ui->stackedWidget->setCurrentIndex(0);
 }
 
@@ -293,7 +597,161 @@ void MainWindow::resetForm()
 
 void MainWindow::onContactListChanged()
 {
-    refreshContactTable();
+    // la selezione e la vista seguono gli id: restano sugli stessi contatti anche se cambiano riga
+    const QVector<quint64> selected = selectedIds();
+    const int scroll = ui->tableWidget->verticalScrollBar()->value();
+    const int shown = ui->tableWidget->rowCount();
+    const QTableWidgetItem *top = ui->tableWidget->item(std::max(ui->tableWidget->rowAt(0), 0), 0);
+    const quint64 topId = top ? top->data(Qt::UserRole).toULongLong() : 0;
+
+    const ContactList::ChangeSet &change = m_contactList.lastChange();
+    if (change.all || !patchTable(change.ids)) {
+        refreshContactTable();
+        // la tabella riparte dalla prima pagina: ricarico le pagine che erano già state mostrate
+        int loaded = ui->tableWidget->rowCount();
+        while (loaded < shown) {
+            fetchNextPage();
+            if (ui->tableWidget->rowCount() == loaded)
+                break; // risultati finiti
+            loaded = ui->tableWidget->rowCount();
+        }
+    }
+    selectIds(selected);
+
+    const int topRow = topId != 0 ? int(m_searchResultIds.indexOf(topId)) : -1;
+    if (topRow >= 0)
+        ui->tableWidget->scrollToItem(ui->tableWidget->item(topRow, 0), QAbstractItemView::PositionAtTop);
+    else
+        ui->tableWidget->verticalScrollBar()->setValue(scroll);
+    // le righe arrivate ai bordi della finestra si caricano come scorrendo
+    onTableScrolled(ui->tableWidget->verticalScrollBar()->value());
+    updateUndoActions();
+}
+
+bool MainWindow::patchTable(const QVector<quint64> &ids)
+{
+    // i risultati approssimati dipendono dalla distanza di tutti i contatti: si rifà la ricerca
+    QTableWidget *table = ui->tableWidget;
+    if (ui->chkFuzzy->isChecked() || table->rowCount() == 0)
+        return false;
+
+    const Profiler::Scope scope("MainWindow::patchTable");
+    const QSet<quint64> changed(ids.cbegin(), ids.cend());
+
+    // posizioni nell'ordine mostrato dei contatti rimasti: restano in sequenza tra loro
+    QVector<quint64> remaining;
+    QVector<qsizetype> positions;
+    remaining.reserve(m_searchResultIds.size());
+    positions.reserve(m_searchResultIds.size());
+    for (const quint64 id : std::as_const(m_searchResultIds)) {
+        if (!changed.contains(id)) {
+            remaining.append(id);
+            positions.append(m_contactList.sortPosition(m_contactList.indexOfId(id)));
+        }
+    }
+    if (positions.isEmpty())
+        return false;
+    const qsizetype firstPos = positions.first();
+    const qsizetype lastPos = positions.last();
+
+    // contatti toccati che cadono tra le righe mostrate. Quelli dopo l'ultima arrivano
+    // con la pagina successiva; quelli prima della prima solo se la tabella è una finestra
+    // (con la pagina precedente), altrimenti la ricerca parte dal primo risultato e vanno mostrati
+    struct Added
+    {
+        qsizetype position;
+        int index;
+        quint64 id;
+    };
+    const SearchQuery query = SearchQuery::parse(ui->inputSearch->text());
+    QVector<Added> added;
+    for (const quint64 id : changed) {
+        const qsizetype index = m_contactList.indexOfId(id);
+        if (index < 0 || !m_contactList.accepts(query, index))
+            continue;
+        const qsizetype position = m_contactList.sortPosition(index);
+        if (position <= lastPos && (position >= firstPos || !m_windowed))
+            added.append({position, int(index), id});
+    }
+    if (added.size() > kPageSize)
+        return false; // più di una pagina: conviene ricaricare
+    std::sort(added.begin(), added.end(),
+              [](const Added &a, const Added &b) { return a.position < b.position; });
+
+    // tolgo le righe dei contatti toccati, dal basso per non spostare quelle da controllare
+    for (int row = table->rowCount() - 1; row >= 0; --row) {
+        if (changed.contains(m_searchResultIds[row]))
+            table->removeRow(row);
+    }
+
+    // i contatti consecutivi nella tabella entrano con una sola chiamata, dall'ultimo
+    // gruppo al primo: le righe prima del punto di inserimento non si spostano
+    QVector<qsizetype> rowsAt(added.size());
+    for (qsizetype i = 0; i < added.size(); ++i)
+        rowsAt[i] = std::lower_bound(positions.cbegin(), positions.cend(), added[i].position) - positions.cbegin();
+    for (qsizetype end = added.size(); end > 0;) {
+        qsizetype begin = end - 1;
+        while (begin > 0 && rowsAt[begin - 1] == rowsAt[end - 1])
+            --begin;
+        QVector<int> rows;
+        for (qsizetype i = begin; i < end; ++i)
+            rows.append(added[i].index);
+        m_contactList.showRows(table, rows, int(rowsAt[begin]));
+        end = begin;
+    }
+
+    // gli id seguono le righe della tabella
+    m_searchResultIds.clear();
+    m_searchResultIds.reserve(remaining.size() + added.size());
+    for (qsizetype i = 0, next = 0; next < remaining.size() || i < added.size();) {
+        if (i < added.size() && rowsAt[i] <= next)
+            m_searchResultIds.append(added[i++].id);
+        else
+            m_searchResultIds.append(remaining[next++]);
+    }
+
+    // le pagine successive riprendono dall'ultimo contatto mostrato
+    const qsizetype resume = lastPos + 1;
+    if (m_windowed) {
+        if (!m_showAll)
+            m_sortedRows = m_contactList.sortedRows();
+        m_windowStart = firstPos;
+    } else if (m_sortedSearch) {
+        m_sortedCursor.position = resume;
+        m_sortedCursor.found = table->rowCount();
+        m_sortedCursor.atEnd = resume >= qsizetype(m_contactList.size());
+    } else {
+        m_searchCursor = m_contactList.openSearch(ui->inputSearch->text(), resume, table->rowCount());
+    }
+    updateStatusBar();
+    updateLetterBar();
+    return true;
+}
+
+void MainWindow::updateUndoActions()
+{
+    ui->actionAnnulla->setEnabled(m_contactList.canUndo());
+    ui->actionRipeti->setEnabled(m_contactList.canRedo());
+}
+
+void MainWindow::onUndoTriggered()
+{
+    // la riga in modifica potrebbe spostarsi: torno alla pagina principale
+    m_editingId = 0;
+    ui->stackedWidget->setCurrentIndex(0);
+
+    // la tabella viene aggiornata da onContactListChanged
+    if (m_contactList.undo())
+        ui->statusbar->showMessage("Modifica annullata");
+}
+
+void MainWindow::onRedoTriggered()
+{
+    m_editingId = 0;
+    ui->stackedWidget->setCurrentIndex(0);
+
+    if (m_contactList.redo())
+        ui->statusbar->showMessage("Modifica ripetuta");
 }
 
 void MainWindow::clearInputFields()
@@ -319,15 +777,427 @@ void MainWindow::showErrorMessage(const QString& title, const QString& message)
     msgBox.exec();
 }
 
+void MainWindow::showValidationError(const ContactValidator::Error &error, const Contact &contact,
+                                     QLineEdit *name, QLineEdit *phone, QLineEdit *email)
+{
+    showErrorMessage("Errore", ContactValidator::describe(error, contact));
+
+    // seleziono il campo da correggere
+    QLineEdit *field = error.field == ContactValidator::Name    ? name
+                       : error.field == ContactValidator::Phone ? phone
+                                                                : email;
+    field->selectAll();
+    field->setFocus();
+}
+
+void MainWindow::on_inputSearch_textChanged(const QString &query)
+{
+    // una nuova ricerca parte dal primo risultato
+    m_windowStart = 0;
+    showResults(query);
+}
+
 /**
  * - Esegue la ricerca nella contactList usando la query
- * - Salva gli indici originali dei risultati in m_searchResultsIndices
+ * - Salva gli id dei risultati in m_searchResultIds
  * - Aggiorna la tabella UI con solo i risultati trovati
  */
-void MainWindow::on_inputSearch_textChanged(const QString &query)
+void MainWindow::showResults(const QString &query)
+{
+    const Profiler::Scope scope("MainWindow::showResults");
+    m_searchCursor = SearchIndex::Cursor();
+    m_sortedCursor = ContactList::SortedCursor();
+    m_sortedSearch = false;
+    m_sortedRows.clear();
+    m_windowed = false;
+    m_showAll = false;
+
+    // in modalità approssimata i risultati sono già limitati ai più simili
+    if (ui->chkFuzzy->isChecked()) {
+        m_searchResultIds = m_contactList.idsOf(m_contactList.fuzzySearch(query, ui->tableWidget));
+        updateStatusBar();
+        updateLetterBar();
+        return;
+    }
+
+    // altrimenti mostro subito la prima pagina, le altre arrivano scorrendo
+    m_searchResultIds.clear();
+    ui->tableWidget->setRowCount(0);
+    if (m_contactList.sortKey() != SortOrders::FirstName && query.trimmed().isEmpty()) {
+        // tutta la rubrica: la permutazione in cache, mostrata a pagine
+        m_sortedRows = m_contactList.sortedRows();
+        m_windowed = true;
+    } else if (m_contactList.sortKey() != SortOrders::FirstName) {
+        // i risultati si leggono scorrendo la permutazione: nessun ordinamento a ogni tasto
+        m_sortedCursor = m_contactList.openSorted(query);
+        m_sortedSearch = true;
+    } else if (query.trimmed().isEmpty()) {
+        // tutta la rubrica: le posizioni sono le righe, si può partire da qualsiasi punto
+        m_showAll = true;
+        m_windowed = true;
+    } else {
+        m_searchCursor = m_contactList.openSearch(query);
+    }
+    // dopo una modifica la finestra resta dov'era, purché ci siano ancora contatti da mostrare
+    if (!m_windowed)
+        m_windowStart = 0;
+    else if (m_windowStart >= windowSize())
+        m_windowStart = std::max<qsizetype>(0, windowSize() - kPageSize);
+    fetchNextPage();
+    updateStatusBar();
+    updateLetterBar();
+}
+
+void MainWindow::updateLetterBar()
+{
+    // le posizioni delle iniziali valgono solo per tutta la rubrica in ordine di nome
+    ui->letterBar->setEnabled(m_showAll);
+    for (int group = 0; group < m_letterButtons.size(); ++group)
+        m_letterButtons[group]->setEnabled(m_contactList.letterCount(group) > 0);
+}
+
+void MainWindow::jumpToLetter(int group)
+{
+    if (!m_showAll)
+        return;
+
+    const Profiler::Scope scope("MainWindow::jumpToLetter");
+    // posizione in tempo costante; le righe tra la pagina mostrata e questa non vengono caricate
+    const qsizetype target = m_contactList.letterStart(group);
+    m_windowStart = target;
+    m_searchResultIds.clear();
+    ui->tableWidget->setRowCount(0);
+    fetchNextPage();
+    fetchPreviousPage(); // una pagina sopra, per poter scorrere subito anche verso l'alto
+
+    if (QTableWidgetItem *item = ui->tableWidget->item(int(target - m_windowStart), 0))
+        ui->tableWidget->scrollToItem(item, QAbstractItemView::PositionAtTop);
+    updateStatusBar();
+}
+
+void MainWindow::setSortKey(SortOrders::Key key)
+{
+    const Profiler::Scope scope("MainWindow::setSortKey");
+    m_contactList.setSortKey(key);
+    m_windowStart = 0;
+
+    QAction *const actions[] = {ui->actionOrdinaNome, ui->actionOrdinaCognome, ui->actionOrdinaTelefono,
+                                ui->actionOrdinaEmail, ui->actionOrdinaRecenti};
+    actions[key]->setChecked(true);
+
+    // l'indicatore resta sulla colonna ordinata, nessuno per l'ordine delle modifiche
+    static constexpr int kColumns[] = {0, 0, 1, 2, -1};
+    ui->tableWidget->horizontalHeader()->setSortIndicator(kColumns[key], Qt::AscendingOrder);
+
+    refreshContactTable();
+    ui->tableWidget->scrollToTop();
+}
+
+void MainWindow::onHeaderClicked(int column)
+{
+    switch (column) {
+    case 0:
+        setSortKey(m_contactList.sortKey() == SortOrders::FirstName ? SortOrders::Surname : SortOrders::FirstName);
+        break;
+    case 1:
+        setSortKey(SortOrders::Phone);
+        break;
+    case 2:
+        setSortKey(SortOrders::Email);
+        break;
+    default:
+        break;
+    }
+}
+
+void MainWindow::onSearchModeChanged(bool fuzzy)
+{
+    Q_UNUSED(fuzzy);
+    on_inputSearch_textChanged(ui->inputSearch->text());
+}
+
+
+
+
+void MainWindow::onFindDuplicatesTriggered()
+{
+    // il nome approssimato trova anche gli errori di battitura,
+    // ma può raggruppare persone diverse con nomi simili
+    const QStringList modes{"Telefono, email e nome",
+                            "Telefono, email e nome (anche con un errore di battitura)"};
+    bool ok = false;
+    const QString mode = QInputDialog::getItem(this, "Trova duplicati", "Criteri di confronto:",
+                                               modes, 0, false, &ok);
+    if (!ok)
+        return;
+
+    DuplicateFinder::Criteria criteria{DuplicateFinder::Phone, DuplicateFinder::Email, DuplicateFinder::Name};
+    if (mode == modes[1])
+        criteria |= DuplicateFinder::FuzzyName;
+
+    const QVector<DuplicateFinder::Cluster> clusters = m_contactList.findDuplicates(criteria);
+    if (clusters.isEmpty()) {
+        QMessageBox::information(this, "Duplicati", "Nessun contatto duplicato trovato");
+        return;
+    }
+
+    qsizetype duplicates = 0;
+    for (const DuplicateFinder::Cluster &cluster : clusters)
+        duplicates += cluster.members.size() - 1;
+
+    // riepilogo dei primi gruppi, con i nomi dei contatti
+    const QVector<Contact> contacts = m_contactList.allContacts();
+    QString message = QString("Trovati %1 gruppi di duplicati (%2 contatti in più):\n")
+                          .arg(clusters.size())
+                          .arg(duplicates);
+    const qsizetype shown = std::min<qsizetype>(clusters.size(), 10);
+    for (qsizetype i = 0; i < shown; ++i) {
+        QStringList names;
+        for (int member : clusters[i].members)
+            names.append(contacts[member].name());
+        message += "\n- " + names.join(", ");
+    }
+    if (clusters.size() > shown)
+        message += "\n...";
+    message += "\n\nUnire i duplicati? Vengono uniti solo i contatti con lo stesso telefono "
+               "e un'email uguale o vuota: quelli con numeri diversi restano separati.";
+
+    // i gruppi passano per id: durante la domanda la rubrica può cambiare
+    // (ricaricamento del file, importazione) e le righe spostarsi
+    QVector<QVector<quint64>> groups;
+    groups.reserve(clusters.size());
+    for (const DuplicateFinder::Cluster &cluster : clusters)
+        groups.append(m_contactList.idsOf(cluster.members));
+
+    if (QMessageBox::question(this, "Duplicati", message) != QMessageBox::Yes)
+        return;
+
+    const qsizetype removed = m_contactList.mergeDuplicates(groups);
+    QMessageBox::information(this, "Duplicati", QString("%1 contatti duplicati uniti").arg(removed));
+}
+
+void MainWindow::onOpenBooksTriggered()
 {
-    m_searchResultsIndices = m_contactList.search(query, ui->tableWidget);
+    const QStringList filePaths = QFileDialog::getOpenFileNames(this, "Apri rubrica", QString(),
+                                                                "Rubrica CSV (*.csv)");
+    if (filePaths.isEmpty())
+        return;
+
+    QStringList failed;
+    const qsizetype opened = m_books.openFiles(filePaths, &failed);
+    ui->statusbar->showMessage(QString("%1 rubriche aperte, %2 in totale").arg(opened).arg(m_books.count()));
+    if (!failed.isEmpty())
+        showErrorMessage("Errore", "Impossibile aprire:\n" + failed.join("\n"));
 }
 
+void MainWindow::onSearchBooksTriggered()
+{
+    constexpr int kMaxResults = 1000;
+
+    bool ok = false;
+    const QString query = QInputDialog::getText(this, "Cerca in tutte le rubriche", "Cerca:",
+                                                QLineEdit::Normal, ui->inputSearch->text(), &ok);
+    if (!ok || query.trimmed().isEmpty())
+        return;
+
+    const QVector<BookSet::Result> results = m_books.search(query, kMaxResults);
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("Risultati in %1 rubriche: %2%3")
+                              .arg(m_books.count())
+                              .arg(results.size())
+                              .arg(results.size() == kMaxResults ? " (solo i primi)" : ""));
+    dialog.resize(800, 500);
+
+    auto *table = new QTableWidget(int(results.size()), 4, &dialog);
+    table->setHorizontalHeaderLabels({"Rubrica", "Nome", "Telefono", "Email"});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    for (int row = 0; row < results.size(); ++row) {
+        const BookSet::Result &result = results[row];
+        table->setItem(row, 0, new QTableWidgetItem(m_books.name(result.book)));
+        table->setItem(row, 1, new QTableWidgetItem(result.contact.name()));
+        table->setItem(row, 2, new QTableWidgetItem(result.contact.phone()));
+        table->setItem(row, 3, new QTableWidgetItem(result.contact.email()));
+    }
 
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    auto *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(table);
+    layout->addWidget(buttons);
+    dialog.exec();
+}
+
+void MainWindow::onImportTriggered()
+{
+    const QString filePath = QFileDialog::getOpenFileName(this, "Importa contatti", QString(),
+                                                          "Rubrica CSV (*.csv)");
+    if (filePath.isEmpty())
+        return;
+
+    // lettura e validazione in background: la finestra resta reattiva e l'importazione si può annullare
+    auto *progress = new QProgressDialog("Importazione dei contatti...", "Annulla", 0,
+                                         ContactList::kProgressRange, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+
+    auto *watcher = new QFutureWatcher<ContactList::ImportResult>(this);
+    connect(watcher, &QFutureWatcherBase::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcherBase::cancel);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, progress, filePath]() {
+        watcher->deleteLater();
+        progress->deleteLater();
+        const QFuture<ContactList::ImportResult> future = watcher->future();
+        if (future.isCanceled() || future.resultCount() == 0) {
+            ui->statusbar->showMessage("Importazione annullata");
+            return;
+        }
+
+        const ContactList::ImportResult result = future.result();
+        if (!result.ok) {
+            showErrorMessage("Errore", QString("Impossibile aprire %1").arg(filePath));
+            return;
+        }
+        ui->statusbar->showMessage(QString("%1 contatti importati, %2 già presenti, %3 righe non valide")
+                                       .arg(result.imported)
+                                       .arg(result.duplicates)
+                                       .arg(result.errors.size()));
+    });
+    watcher->setFuture(m_contactList.importAsync(filePath));
+}
+
+void MainWindow::onInterningToggled(bool enabled)
+{
+    m_contactList.setInterning(enabled);
+
+    const ContactStore::MemoryReport report = m_contactList.memoryUsage().store;
+    constexpr double kMegabyte = 1024.0 * 1024.0;
+    ui->statusbar->showMessage(QString("Memoria contatti: %1 MB, risparmiati %2 MB (%3 stringhe condivise)")
+                                   .arg(report.actualBytes / kMegabyte, 0, 'f', 1)
+                                   .arg(report.savedBytes() / kMegabyte, 0, 'f', 1)
+                                   .arg(report.pooledStrings));
+}
 
+void MainWindow::onMemoryUsageTriggered()
+{
+    const ContactList::MemoryUsage usage = m_contactList.memoryUsage();
+    const qsizetype count = qsizetype(m_contactList.size());
+
+    constexpr double kMegabyte = 1024.0 * 1024.0;
+    const auto megabytes = [](qsizetype bytes) { return QString::number(bytes / kMegabyte, 'f', 2); };
+
+    QString message = QString("Contatti: %1\n\n").arg(count);
+    message += QString("Colonne: %1 MB\n").arg(megabytes(usage.store.columnBytes));
+    message += QString("Stringhe: %1 MB\n").arg(megabytes(usage.store.stringBytes));
+    message += QString("Pool condivisi: %1 MB (%2 stringhe)\n")
+                   .arg(megabytes(usage.store.poolBytes))
+                   .arg(usage.store.pooledStrings);
+    message += QString("Buffer di ricerca: %1 MB\n").arg(megabytes(usage.search.buffer));
+    message += QString("Indici di ricerca: %1 MB\n").arg(megabytes(usage.search.indexes));
+    message += QString("Cache dei risultati: %1 MB\n").arg(megabytes(usage.search.cache));
+    message += QString("Ricerche in background: %1 MB\n").arg(megabytes(usage.asyncSearchBytes));
+    message += QString("Ordinamenti: %1 MB\n").arg(megabytes(usage.sortOrderBytes));
+    message += QString("Annulla/ripeti: %1 MB\n").arg(megabytes(usage.historyBytes));
+    message += QString("Versione nota di contacts.csv: %1 MB\n\n").arg(megabytes(m_fileWatcher.memoryUsage()));
+    const qsizetype total = usage.totalBytes() + m_fileWatcher.memoryUsage();
+    message += QString("Totale: %1 MB").arg(megabytes(total));
+    if (count > 0)
+        message += QString(" (%1 byte per contatto)").arg(total / count);
+    message += QString("\n\nPicco ultimo caricamento: %1 MB\n").arg(megabytes(usage.peakLoadBytes));
+    message += QString("Picco ultimo ordinamento: %1 MB\n\n").arg(megabytes(usage.peakSortBytes));
+    message += "Valori stimati: capacità dei vettori e caratteri delle stringhe, "
+               "senza la frammentazione dell'allocatore.";
+
+    QMessageBox::information(this, "Utilizzo memoria", message);
+}
+
+void MainWindow::onProfilingToggled(bool enabled)
+{
+    Profiler::setEnabled(enabled);
+    ui->statusbar->showMessage(enabled ? "Misura dei tempi attiva" : "Misura dei tempi disattivata");
+}
+
+void MainWindow::onTimingsTriggered()
+{
+    const QVector<Profiler::Stats> stats = Profiler::stats();
+    const auto milliseconds = [](qint64 nanoseconds) { return QString::number(nanoseconds / 1e6, 'f', 2); };
+
+    QString message;
+    if (stats.isEmpty()) {
+        message = Profiler::isEnabled() ? "Nessuna operazione misurata finora."
+                                        : "Nessuna misura: attivare Strumenti > Misura tempi.";
+    } else {
+        message = "Operazione: chiamate, mediana / 99° percentile / massimo (ms)\n";
+        for (const Profiler::Stats &entry : stats) {
+            message += QString("\n%1: %2, %3 / %4 / %5")
+                           .arg(entry.name)
+                           .arg(entry.count)
+                           .arg(milliseconds(entry.p50), milliseconds(entry.p99), milliseconds(entry.max));
+        }
+    }
+
+    const AutoSaver::Stats autosave = m_autoSaver.stats();
+    message += QString("\n\nSalvataggi automatici: %1 (%2 KB scritti, ultimo %3 ms), %4 saltati, %5 falliti")
+                   .arg(autosave.saves)
+                   .arg(autosave.bytesWritten / 1024)
+                   .arg(milliseconds(autosave.lastDuration))
+                   .arg(autosave.skipped)
+                   .arg(autosave.failures);
+
+    if (m_lookupServer.isRunning()) {
+        const LookupServer::Stats server = m_lookupServer.stats();
+        message += QString("\nServer di ricerca: %1 connessioni, %2 richieste (%3 interrogazioni), "
+                           "%4 non valide, %5 aggiornamenti")
+                       .arg(server.connections)
+                       .arg(server.requests)
+                       .arg(server.queries)
+                       .arg(server.rejected)
+                       .arg(server.rebuilds);
+    }
+
+    QMessageBox box(QMessageBox::Information, "Tempi operazioni", message, QMessageBox::Close, this);
+    QPushButton *exportButton = box.addButton("Esporta traccia...", QMessageBox::ActionRole);
+    QPushButton *resetButton = box.addButton("Azzera", QMessageBox::ResetRole);
+    exportButton->setEnabled(!stats.isEmpty());
+    box.exec();
+
+    if (box.clickedButton() == resetButton) {
+        Profiler::reset();
+        return;
+    }
+    if (box.clickedButton() != exportButton)
+        return;
+
+    const QString filePath = QFileDialog::getSaveFileName(this, "Esporta traccia", "rubrica-trace.json",
+                                                          "Traccia JSON (*.json)");
+    if (filePath.isEmpty())
+        return;
+
+    if (Profiler::writeTrace(filePath))
+        ui->statusbar->showMessage(QString("Traccia salvata in %1").arg(filePath));
+    else
+        showErrorMessage("Errore", QString("Impossibile scrivere %1").arg(filePath));
+}
+
+void MainWindow::onServerToggled(bool enabled)
+{
+    if (!enabled) {
+        m_lookupServer.stop();
+        ui->statusbar->showMessage("Server di ricerca fermato");
+        return;
+    }
+
+    if (m_lookupServer.start()) {
+        ui->statusbar->showMessage(QString("Server di ricerca in ascolto su %1").arg(m_lookupServer.serverName()));
+    } else {
+        const QSignalBlocker blocker(ui->actionServer);
+        ui->actionServer->setChecked(false);
+        showErrorMessage("Errore", QString("Impossibile avviare il server di ricerca: %1")
+                                       .arg(m_lookupServer.errorString()));
+    }
+}
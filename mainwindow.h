@@ -13,10 +13,18 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QFuture>
+#include <QLineEdit>
 #include <QMainWindow>
+#include <QProgressBar>
 #include <QSortFilterProxyModel>
+#include <QToolButton>
 #include <QTableWidgetItem>
+#include "autosaver.hpp"
+#include "bookset.hpp"
+#include "filewatcher.hpp"
 #include "list.hpp"
+#include "lookupserver.hpp"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -56,6 +64,15 @@ public:
      */
     ~MainWindow();
 
+protected:
+    /**
+     * @brief Salva le ultime modifiche prima di chiudere la finestra
+     * @param[in] event Evento di chiusura (ignorato se l'utente annulla)
+     * @details Se contacts.csv non si può scrivere, l'utente può riprovare, salvare
+     * la rubrica in un altro file, chiudere senza salvare o tornare alla finestra.
+     */
+    void closeEvent(QCloseEvent *event) override;
+
     // metodi che corrispondono ad un evento/segnale
 private slots:
     /**
@@ -113,12 +130,26 @@ private slots:
      * @brief Slot per l'aggiornamento dell'interfaccia
      * @details
      * Chiamato quando la lista contatti cambia:
-     * - Ricarica la tabella
+     * - Aggiorna solo le righe dei contatti toccati (vedi patchTable); ricarica la
+     *   tabella solo se è cambiata tutta la rubrica o la ricerca è approssimata
+     * - Mantiene selezionati gli stessi contatti (per id), con in cima lo stesso contatto
      * - Aggiorna i contatori
      * - Ripristina lo stato iniziale
      */
     void onContactListChanged();
 
+    /**
+     * @brief Slot per la voce di menu "Annulla" (Ctrl+Z)
+     * @details Annulla l'ultima modifica alla rubrica (vedi ContactList::undo).
+     * Un'eventuale modifica in corso nel form viene abbandonata.
+     */
+    void onUndoTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Ripeti" (Ctrl+Y)
+     */
+    void onRedoTriggered();
+
     /**
      * @brief Slot per la ricerca in tempo reale
      * @param[in] query Testo da cercare
@@ -131,23 +162,136 @@ private slots:
      */
     void on_inputSearch_textChanged(const QString &query);
 
+    /**
+     * @brief Slot per il cambio della modalità di ricerca
+     * @param[in] fuzzy true per la ricerca approssimata, false per quella esatta
+     * @details
+     * Ripete la ricerca corrente con la nuova modalità
+     */
+    void onSearchModeChanged(bool fuzzy);
+
+    /**
+     * @brief Slot per lo scorrimento della tabella
+     * @param[in] value Posizione della barra di scorrimento verticale
+     * @details
+     * Quando manca meno di una schermata alla fine della tabella
+     * carica la pagina successiva di risultati
+     */
+    void onTableScrolled(int value);
+
+    /**
+     * @brief Slot per la voce di menu "Trova duplicati"
+     * @details
+     * - Chiede i criteri di confronto (con o senza nome approssimato)
+     * - Mostra un riepilogo dei gruppi di duplicati trovati
+     * - Se confermato, unisce ogni gruppo in un solo contatto
+     */
+    void onFindDuplicatesTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Riduci memoria"
+     * @param[in] enabled true per attivare l'interning di nomi e domini email
+     * @details
+     * Cambia la rappresentazione in memoria dei contatti (vedi ContactList::setInterning)
+     * e mostra nella barra di stato la memoria stimata e quella risparmiata
+     */
+    void onInterningToggled(bool enabled);
+
+    /**
+     * @brief Slot per la voce di menu "Utilizzo memoria"
+     * @details
+     * Mostra la memoria stimata di ogni struttura (colonne, stringhe, pool,
+     * buffer e indici della ricerca, cache dei risultati) e i picchi
+     * dell'ultimo caricamento e dell'ultimo ordinamento
+     */
+    void onMemoryUsageTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Misura tempi"
+     * @param[in] enabled true per misurare la durata delle operazioni (vedi Profiler)
+     */
+    void onProfilingToggled(bool enabled);
+
+    /**
+     * @brief Slot per la voce di menu "Tempi operazioni"
+     * @details
+     * Mostra per ogni operazione misurata numero di chiamate, mediana, 99° percentile
+     * e massimo. Da qui si può esportare la traccia in formato JSON di Chrome
+     * oppure azzerare le misure.
+     */
+    void onTimingsTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Server di ricerca"
+     * @param[in] enabled true per avviare il server di ricerca locale (vedi LookupServer)
+     */
+    void onServerToggled(bool enabled);
+
+    /**
+     * @brief Slot per la voce di menu "Apri rubrica"
+     * @details
+     * Apre uno o più file di rubrica insieme (vedi BookSet::openFiles) e li aggiunge
+     * a quelli su cui cerca "Cerca in tutte le rubriche". Le rubriche aperte così
+     * sono in sola lettura.
+     */
+    void onOpenBooksTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Cerca in tutte le rubriche"
+     * @details
+     * Chiede la stringa di ricerca e mostra i risultati di tutte le rubriche
+     * in ordine di nome, con la rubrica di provenienza di ognuno
+     */
+    void onSearchBooksTriggered();
+
+    /**
+     * @brief Slot per la voce di menu "Importa contatti"
+     * @details
+     * Aggiunge alla rubrica i contatti di un file CSV (vedi ContactList::importAsync),
+     * con una finestra di avanzamento da cui si può annullare
+     */
+    void onImportTriggered();
+
+    /**
+     * @brief Slot per il click sull'intestazione di una colonna
+     * @param[in] column Colonna cliccata
+     * @details
+     * - "Nome" alterna l'ordine per nome e per cognome
+     * - "Telefono" ed "Email" ordinano per quella colonna
+     */
+    void onHeaderClicked(int column);
+
 private:
     Ui::MainWindow *ui;                  /**< Puntatore all'interfaccia generata da Qt Designer */
     ContactList m_contactList;           /**< Istanza della lista contatti (model) */
-    int m_editingRow = -1;               /**< Riga in modifica (-1 = nessuna modifica) */
-    QVector<int> m_searchResultsIndices; /**< Indici dei risultati di ricerca */
+    AutoSaver m_autoSaver;               /**< Salvataggio automatico di contacts.csv */
+    FileWatcher m_fileWatcher;           /**< Ricaricamento delle modifiche esterne a contacts.csv */
+    BookSet m_books;                     /**< Rubrica principale e rubriche aperte, per la ricerca federata */
+    LookupServer m_lookupServer;         /**< Ricerche di altri programmi sulla rubrica principale */
+    QProgressBar *m_loadProgress = nullptr; /**< Avanzamento del caricamento iniziale nella barra di stato */
+    quint64 m_editingId = 0;             /**< Id del contatto in modifica (0 = nessuna modifica) */
+    QVector<quint64> m_searchResultIds;  /**< Id dei risultati di ricerca */
 
     /*
-    *VARIABILE MEMBRO: m_searchResultsIndices
+    *VARIABILE MEMBRO: m_searchResultIds
      * 
-     * Conserva gli indici ORIGINALI dei contatti che corrispondono alla ricerca attuale.
-     * Esempio: se cerco "a" e trovo i contatti con indice originale 3 e 100,
-     * questo vettore conterrà [3, 100].
-     * Serve per mappare gli indici della tabella filtrata a quelli della lista completa.
+     * Conserva gli id dei contatti che corrispondono alla ricerca attuale, nell'ordine
+     * della tabella filtrata. A differenza degli indici nella lista completa gli id
+     * restano validi anche dopo modifiche e riordinamenti.
      */
 
     QSortFilterProxyModel *m_proxyModel; /**< Modello per il filtraggio dei dati */
 
+    SearchIndex::Cursor m_searchCursor;  /**< Ricerca in corso, letta a pagine */
+    ContactList::SortedCursor m_sortedCursor; /**< Ricerca in corso nell'ordine scelto, letta a pagine */
+    bool m_sortedSearch = false;         /**< true se la ricerca in corso usa m_sortedCursor */
+    QVector<int> m_sortedRows;           /**< Tutta la rubrica nell'ordine scelto (solo se diverso dal nome) */
+    bool m_windowed = false;             /**< true se la tabella è una finestra su m_sortedRows o su tutta la rubrica */
+    bool m_showAll = false;              /**< true se si mostra tutta la rubrica in ordine di nome */
+    qsizetype m_windowStart = 0;         /**< Posizione del contatto nella prima riga della tabella */
+    QVector<QToolButton *> m_letterButtons; /**< Pulsanti della barra delle iniziali, per gruppo */
+    static constexpr int kPageSize = 200; /**< Righe caricate per ogni pagina */
+
     /**
      * @brief Inizializza l'interfaccia grafica
      * @details
@@ -159,17 +303,130 @@ private:
      */
     void initializeUI();
 
+    /**
+     * @brief Avvia il caricamento di contacts.csv in background
+     * @details Tabella e menu restano disabilitati fino alla fine, con l'avanzamento
+     * nella barra di stato (vedi ContactList::loadAsync)
+     */
+    void startInitialLoad();
+
+    /**
+     * @brief Conclude il caricamento iniziale
+     * @param[in] future Risultato di ContactList::loadAsync
+     * @details Riabilita la finestra, segna la rubrica come salvata e mostra
+     * un riepilogo delle righe non valide. Se il file ha righe non valide o non
+     * si è potuto leggere, il primo salvataggio automatico ne fa prima una copia
+     * in contacts.csv.bak
+     */
+    void onInitialLoadFinished(const QFuture<ContactList::LoadResult> &future);
+
     /**
      * @brief Aggiorna la tabella dei contatti
      * @details
-     * Ricarica tutti i contatti:
+     * Ripete la ricerca corrente (tutti i contatti se la barra è vuota):
      * - Cancella il contenuto corrente
-     * - Ricostruisce le righe
+     * - Carica la prima pagina di righe
      * - Mantiene l'ordinamento
-     * - Ripristina le selezioni
      */
     void refreshContactTable();
 
+    /**
+     * @brief Ripete una ricerca mantenendo la posizione raggiunta nella tabella
+     * @param[in] query Testo da cercare (vuoto = tutti i contatti)
+     */
+    void showResults(const QString &query);
+
+    /**
+     * @brief Aggiunge alla tabella la pagina successiva della ricerca corrente
+     */
+    void fetchNextPage();
+
+    /**
+     * @brief Aggiunge in cima alla tabella la pagina che precede la prima riga mostrata
+     * @details Solo quando la tabella è una finestra che non parte dal primo contatto
+     * (es. dopo jumpToLetter); la vista resta sugli stessi contatti.
+     */
+    void fetchPreviousPage();
+
+    /**
+     * @brief Numero di contatti della sequenza mostrata a finestra
+     */
+    qsizetype windowSize() const;
+
+    /**
+     * @brief Indici dei contatti in un tratto della sequenza mostrata a finestra
+     * @param[in] from Prima posizione
+     * @param[in] count Numero di posizioni
+     */
+    QVector<int> windowRows(qsizetype from, qsizetype count) const;
+
+    /**
+     * @brief Mostra la rubrica a partire dal primo contatto con l'iniziale indicata
+     * @param[in] group Gruppo di iniziali (vedi ContactStore::letterGroup)
+     * @details La posizione arriva dai contatori per iniziale (tempo costante): viene
+     * caricata solo la pagina attorno al contatto, non le righe che lo precedono.
+     */
+    void jumpToLetter(int group);
+
+    /**
+     * @brief Abilita la barra delle iniziali e i pulsanti dei gruppi non vuoti
+     */
+    void updateLetterBar();
+
+    /**
+     * @brief Cambia l'ordine in cui vengono mostrati i contatti
+     * @param[in] key Criterio (vedi ContactList::setSortKey)
+     * @details Aggiorna il menu Visualizza, l'indicatore nell'intestazione e la tabella.
+     * Le permutazioni già costruite restano in cache: tornare a un criterio è immediato.
+     */
+    void setSortKey(SortOrders::Key key);
+
+    /**
+     * @brief Mostra nella barra di stato il numero di risultati
+     * @details
+     * Il totale è esatto quando tutte le pagine sono state caricate,
+     * altrimenti è una stima
+     */
+    void updateStatusBar();
+
+    /**
+     * @brief Abilita "Annulla" e "Ripeti" solo se c'è qualcosa da annullare o ripetere
+     */
+    void updateUndoActions();
+
+    /**
+     * @brief Id dei contatti selezionati nella tabella
+     * @return Id letti dal Qt::UserRole della colonna "Nome", nell'ordine della tabella
+     */
+    QVector<quint64> selectedIds() const;
+
+    /**
+     * @brief Aggiorna la tabella dopo una modifica di pochi contatti
+     * @param[in] ids Id dei contatti aggiunti, rimossi o modificati (vedi ContactList::lastChange)
+     * @retval true Tabella aggiornata
+     * @retval false Va ricaricata (ricerca approssimata, tabella vuota o più di una pagina di righe)
+     * @details
+     * Le righe degli altri contatti restano dove sono: si tolgono quelle dei contatti
+     * toccati e si reinseriscono, nella nuova posizione, quelli che soddisfano ancora la
+     * ricerca e cadono tra le righe mostrate. La finestra mantiene il suo inizio e i
+     * cursori riprendono dopo l'ultima riga, senza rileggere le pagine già mostrate.
+     */
+    bool patchTable(const QVector<quint64> &ids);
+
+    /**
+     * @brief Seleziona le righe della tabella dei contatti indicati
+     * @param[in] ids Id da selezionare (quelli non presenti nella tabella vengono ignorati)
+     */
+    void selectIds(const QVector<quint64> &ids);
+
+    /**
+     * @brief Cambia l'email di tutti i contatti selezionati
+     * @param[in] ids Id dei contatti selezionati (più di uno)
+     * @details Chiede la nuova email, la valida e la applica con un solo
+     * ContactList::updateField (un passo di annulla, un aggiornamento della tabella).
+     */
+    void editSelectedEmails(const QVector<quint64> &ids);
+
     /**
      * @brief Pulisce i campi di input
      * @details
@@ -188,6 +445,17 @@ private:
      */
     void showErrorMessage(const QString &title, const QString &message);
 
+    /**
+     * @brief Mostra un errore di validazione e seleziona il campo da correggere
+     * @param[in] error Errore restituito da ContactValidator
+     * @param[in] contact Contatto validato, per il dettaglio del messaggio
+     * @param[in] name Campo del nome nel form
+     * @param[in] phone Campo del telefono nel form
+     * @param[in] email Campo dell'email nel form
+     */
+    void showValidationError(const ContactValidator::Error &error, const Contact &contact,
+                             QLineEdit *name, QLineEdit *phone, QLineEdit *email);
+
     /**
      * @brief Ripristina il form allo stato iniziale
      * @details
@@ -0,0 +1,65 @@
+/**
+ * @file parallel.hpp
+ * @brief Esecuzione parallela di cicli su intervalli di indici
+ *
+ * @details
+ * Usata dalle elaborazioni su tutta la rubrica (validazione, ricerca duplicati):
+ * l'intervallo viene diviso in blocchi contigui, uno per thread, e il primo
+ * blocco viene elaborato dal thread chiamante.
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <QtGlobal>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Numero di thread da usare per un certo numero di elementi
+ * @param[in] count Elementi da elaborare
+ * @param[in] minPerThread Elementi minimi per thread (sotto conviene un thread solo)
+ * @return Numero di thread, tra 1 e i core disponibili
+ */
+inline qsizetype parallelThreads(qsizetype count, qsizetype minPerThread)
+{
+    const qsizetype hardware = qsizetype(std::max(1u, std::thread::hardware_concurrency()));
+    return std::clamp<qsizetype>(count / std::max<qsizetype>(minPerThread, 1), 1, hardware);
+}
+
+/**
+ * @brief Esegue work(thread, begin, end) su blocchi contigui di [0, count)
+ * @param[in] count Elementi da elaborare
+ * @param[in] minPerThread Elementi minimi per thread
+ * @param[in] work Funzione chiamata una volta per blocco, con l'indice del thread (da 0)
+ *
+ * @details
+ * Ogni blocco deve scrivere solo nei propri elementi (o in dati del proprio thread):
+ * la funzione non sincronizza nulla oltre all'attesa finale dei thread.
+ * L'indice del thread è sempre minore di parallelThreads(count, minPerThread).
+ */
+template<typename Work>
+void parallelFor(qsizetype count, qsizetype minPerThread, const Work &work)
+{
+    const qsizetype threads = parallelThreads(count, minPerThread);
+    if (threads == 1) {
+        work(qsizetype(0), qsizetype(0), count);
+        return;
+    }
+
+    const qsizetype chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(size_t(threads - 1));
+    for (qsizetype t = 1; t < threads; ++t) {
+        const qsizetype begin = std::min(count, t * chunk);
+        const qsizetype end = std::min(count, begin + chunk);
+        workers.emplace_back([&work, t, begin, end]() { work(t, begin, end); });
+    }
+    work(qsizetype(0), qsizetype(0), std::min(count, chunk));
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+#endif // PARALLEL_HPP
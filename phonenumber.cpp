@@ -0,0 +1,37 @@
+/**
+ * @file phonenumber.cpp
+ * @brief PhoneNumber class implementation
+ */
+
+#include "phonenumber.hpp"
+
+bool PhoneNumber::pack(QStringView phone, quint64 *packed)
+{
+    if (phone.size() != kDigits)
+        return false;
+
+    // nessun salto dipendente dai dati dentro il ciclo: il compilatore può vettorializzarlo
+    bool digits = true;
+    quint64 value = 0;
+    for (qsizetype i = 0; i < kDigits; ++i) {
+        const unsigned digit = unsigned(phone[i].unicode()) - u'0';
+        digits &= digit <= 9;
+        value = value * 10 + digit;
+    }
+
+    if (!digits)
+        return false;
+    *packed = value;
+    return true;
+}
+
+QString PhoneNumber::unpack(quint64 packed)
+{
+    QString phone(kDigits, QLatin1Char('0'));
+    QChar *digits = phone.data();
+    for (qsizetype i = kDigits - 1; i >= 0 && packed != 0; --i) {
+        digits[i] = QChar(u'0' + char16_t(packed % 10));
+        packed /= 10;
+    }
+    return phone;
+}
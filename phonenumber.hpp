@@ -0,0 +1,58 @@
+/**
+ * @file phonenumber.hpp
+ * @brief Rappresentazione compatta dei numeri di telefono
+ *
+ * @details
+ * Un numero di esattamente 10 cifre ASCII (il formato richiesto dalla rubrica)
+ * viene memorizzato come intero a 64 bit: il suo valore numerico, che sta in 34 bit.
+ * Gli zeri iniziali non si perdono perché le cifre sono sempre 10.
+ *
+ * I numeri non conformi (internazionali, con spazi o simboli, vuoti) non sono
+ * convertibili: chi li memorizza usa il bit kOverflow e un id in una tabella a parte.
+ */
+
+#ifndef PHONENUMBER_HPP
+#define PHONENUMBER_HPP
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @class PhoneNumber
+ * @brief Conversione tra numero di telefono e intero a 64 bit
+ *
+ * @details
+ * Il valore coincide con la chiave usata da ContactValidator per i duplicati,
+ * quindi confronti, hash e controllo dei duplicati diventano operazioni su interi.
+ */
+class PhoneNumber
+{
+public:
+    PhoneNumber() = delete;
+
+    static constexpr qsizetype kDigits = 10;         /**< Cifre di un numero conforme */
+    static constexpr quint64 kOverflow = 1ull << 63; /**< Bit dei valori che non sono un numero conforme */
+
+    /**
+     * @brief Converte un numero di 10 cifre in intero
+     * @param[in] phone Numero di telefono
+     * @param[out] packed Valore numerico (valido solo se la funzione ritorna true)
+     * @retval true Numero conforme
+     * @retval false Numero vuoto, di lunghezza diversa o con caratteri non numerici
+     */
+    static bool pack(QStringView phone, quint64 *packed);
+
+    /**
+     * @brief Ricostruisce le 10 cifre da un valore restituito da pack()
+     * @param[in] packed Valore senza il bit kOverflow
+     * @return Numero di telefono, con gli eventuali zeri iniziali
+     */
+    static QString unpack(quint64 packed);
+
+    /**
+     * @brief Verifica se il valore è un riferimento alla tabella dei numeri non conformi
+     */
+    static constexpr bool isOverflow(quint64 value) { return (value & kOverflow) != 0; }
+};
+
+#endif // PHONENUMBER_HPP
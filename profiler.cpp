@@ -0,0 +1,250 @@
+/**
+ * @file profiler.cpp
+ * @brief Profiler class implementation
+ */
+
+#include "profiler.hpp"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_profiler_namespace {
+// Bucket per ogni potenza di 2 (3 bit di mantissa)
+constexpr int kSubBits = 3;
+constexpr int kSubBuckets = 1 << kSubBits;
+// Le durate sono positive e stanno in 63 bit
+constexpr int kBuckets = (63 - kSubBits + 1) * kSubBuckets;
+
+/**
+ * @brief Bucket di una durata: i valori piccoli hanno un bucket ciascuno,
+ * poi 8 bucket per ogni potenza di 2
+ */
+int bucketIndex(quint64 value)
+{
+    if (value < quint64(kSubBuckets))
+        return int(value);
+    int msb = 63;
+    while ((value >> msb) == 0)
+        --msb;
+    const int shift = msb - kSubBits;
+    const int sub = int((value >> shift) & (kSubBuckets - 1));
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+/**
+ * @brief Valore più grande che cade nel bucket
+ */
+qint64 bucketUpperBound(int index)
+{
+    if (index < kSubBuckets)
+        return index;
+    const int shift = index / kSubBuckets - 1;
+    const quint64 sub = quint64(index % kSubBuckets);
+    return qint64(((quint64(kSubBuckets) + sub + 1) << shift) - 1);
+}
+
+/**
+ * @brief Istogramma delle durate di un'operazione
+ */
+struct Histogram
+{
+    quint64 count = 0;
+    qint64 total = 0;
+    qint64 max = 0;
+    std::array<quint64, kBuckets> buckets{};
+
+    void add(qint64 duration)
+    {
+        count++;
+        total += duration;
+        max = std::max(max, duration);
+        buckets[size_t(bucketIndex(quint64(duration)))]++;
+    }
+
+    /**
+     * @brief Percentile stimato: il limite superiore del bucket, mai oltre il massimo
+     */
+    qint64 percentile(double fraction) const
+    {
+        const quint64 rank = std::max<quint64>(1, quint64(fraction * double(count) + 0.5));
+        quint64 seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += buckets[size_t(i)];
+            if (seen >= rank)
+                return std::min(bucketUpperBound(i), max);
+        }
+        return max;
+    }
+};
+
+/**
+ * @brief Evento della traccia
+ */
+struct Event
+{
+    const char *name;
+    qint64 start;
+    qint64 duration;
+    int thread;
+};
+
+/**
+ * @brief Dati raccolti, protetti da un solo mutex (usato solo con la profilazione attiva)
+ */
+struct Registry
+{
+    std::atomic<bool> enabled{false};
+    const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    std::map<std::string_view, Histogram> histograms; // per nome, anche se i puntatori differiscono
+    std::vector<Event> events;                        // buffer circolare di al massimo kMaxEvents
+    size_t nextEvent = 0;                             // posizione del prossimo evento a buffer pieno
+    std::vector<std::thread::id> threads;             // la posizione è l'id del thread nella traccia
+
+    int threadIndex(std::thread::id id)
+    {
+        const auto it = std::find(threads.begin(), threads.end(), id);
+        if (it != threads.end())
+            return int(it - threads.begin());
+        threads.push_back(id);
+        return int(threads.size()) - 1;
+    }
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+/**
+ * @brief Scrive un nome come stringa JSON
+ */
+QString jsonString(const char *text)
+{
+    QString escaped(QLatin1Char('"'));
+    for (const QChar c : QString::fromUtf8(text)) {
+        if (c.unicode() < 0x20)
+            continue;
+        if (c == QLatin1Char('"') || c == QLatin1Char('\\'))
+            escaped += QLatin1Char('\\');
+        escaped += c;
+    }
+    escaped += QLatin1Char('"');
+    return escaped;
+}
+} // namespace m_profiler_namespace
+
+void Profiler::setEnabled(bool enabled)
+{
+    m_profiler_namespace::registry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled()
+{
+    return m_profiler_namespace::registry().enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::reset()
+{
+    m_profiler_namespace::Registry &data = m_profiler_namespace::registry();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.histograms.clear();
+    data.events.clear();
+    data.nextEvent = 0;
+}
+
+QVector<Profiler::Stats> Profiler::stats()
+{
+    m_profiler_namespace::Registry &data = m_profiler_namespace::registry();
+    QVector<Stats> result;
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        result.reserve(qsizetype(data.histograms.size()));
+        for (const auto &[name, histogram] : data.histograms) {
+            Stats stats;
+            stats.name = QString::fromUtf8(name.data(), qsizetype(name.size()));
+            stats.count = histogram.count;
+            stats.total = histogram.total;
+            stats.p50 = histogram.percentile(0.50);
+            stats.p99 = histogram.percentile(0.99);
+            stats.max = histogram.max;
+            result.append(stats);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const Stats &a, const Stats &b) { return a.total > b.total; });
+    return result;
+}
+
+bool Profiler::writeTrace(const QString &filePath)
+{
+    // copio gli eventi per non bloccare le misure durante la scrittura
+    m_profiler_namespace::Registry &data = m_profiler_namespace::registry();
+    std::vector<m_profiler_namespace::Event> events;
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        events.reserve(data.events.size());
+        // a buffer pieno gli eventi più vecchi partono da nextEvent
+        events.insert(events.end(), data.events.begin() + qsizetype(data.nextEvent), data.events.end());
+        events.insert(events.end(), data.events.begin(), data.events.begin() + qsizetype(data.nextEvent));
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const m_profiler_namespace::Event &event = events[i];
+        if (i > 0)
+            out << ",";
+        // i tempi della traccia sono in microsecondi
+        out << "\n{\"name\":" << m_profiler_namespace::jsonString(event.name)
+            << ",\"cat\":\"rubrica\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << QString::number(double(event.start) / 1000.0, 'f', 3)
+            << ",\"dur\":" << QString::number(double(event.duration) / 1000.0, 'f', 3) << "}";
+    }
+    out << "\n]}\n";
+    out.flush(); // prima di close(), altrimenti il buffer dello stream andrebbe perso
+
+    const bool written = out.status() == QTextStream::Ok;
+    file.close();
+    return written;
+}
+
+qint64 Profiler::now()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - m_profiler_namespace::registry().origin;
+    return qint64(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Profiler::record(const char *name, qint64 start, qint64 end)
+{
+    m_profiler_namespace::Registry &data = m_profiler_namespace::registry();
+    const qint64 duration = std::max<qint64>(0, end - start);
+
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.histograms[std::string_view(name)].add(duration);
+
+    const m_profiler_namespace::Event event{name, start, duration, data.threadIndex(std::this_thread::get_id())};
+    if (data.events.size() < size_t(kMaxEvents)) {
+        data.events.push_back(event);
+    } else {
+        data.events[data.nextEvent] = event;
+        data.nextEvent = (data.nextEvent + 1) % data.events.size();
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file profiler.hpp
+ * @brief Misura dei tempi delle operazioni principali della rubrica
+ *
+ * @details
+ * Le operazioni da misurare (ordinamento, caricamento, ricerca, aggiornamento
+ * della tabella) creano un Profiler::Scope all'inizio: alla fine dello scope
+ * la durata viene aggiunta all'istogramma dell'operazione e alla traccia.
+ *
+ * Finché la profilazione è disattivata uno Scope si limita a leggere un flag
+ * atomico, senza leggere l'orologio né prendere lock.
+ */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @class Profiler
+ * @brief Raccolta dei tempi: istogrammi per operazione e traccia esportabile
+ *
+ * @details
+ * - Gli istogrammi hanno bucket logaritmici (8 per ogni potenza di 2): memoria
+ *   fissa per operazione e percentili con errore massimo del 12.5%
+ * - La traccia conserva gli ultimi kMaxEvents eventi e si esporta nel formato
+ *   JSON di Chrome (chrome://tracing, Perfetto)
+ * - Può essere usato da più thread contemporaneamente
+ */
+class Profiler
+{
+public:
+    Profiler() = delete;
+
+    class Scope;
+
+    static constexpr qsizetype kMaxEvents = 100000; /**< Eventi conservati nella traccia */
+
+    /**
+     * @brief Tempi di un'operazione, in nanosecondi
+     */
+    struct Stats
+    {
+        QString name;      /**< Nome dell'operazione */
+        quint64 count = 0; /**< Misure raccolte */
+        qint64 total = 0;  /**< Somma delle durate */
+        qint64 p50 = 0;    /**< Mediana (stima per eccesso) */
+        qint64 p99 = 0;    /**< 99° percentile (stima per eccesso) */
+        qint64 max = 0;    /**< Durata massima (esatta) */
+    };
+
+    /**
+     * @brief Attiva o disattiva la raccolta dei tempi
+     * @param[in] enabled true per misurare le operazioni
+     * @note I dati già raccolti restano disponibili
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief Verifica se la raccolta dei tempi è attiva
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Cancella istogrammi e traccia
+     */
+    static void reset();
+
+    /**
+     * @brief Tempi di ogni operazione misurata
+     * @return Statistiche in ordine di tempo totale decrescente
+     */
+    static QVector<Stats> stats();
+
+    /**
+     * @brief Scrive la traccia nel formato JSON di Chrome
+     * @param[in] filePath Percorso del file da creare
+     * @retval true Traccia scritta
+     * @retval false Errore nella scrittura del file
+     * @details Un evento completo ("ph": "X") per ogni misura, con i tempi in
+     * microsecondi dall'avvio del programma. Il file si apre con chrome://tracing
+     * o con ui.perfetto.dev.
+     */
+    static bool writeTrace(const QString &filePath);
+
+private:
+    /**
+     * @brief Istante attuale in nanosecondi dall'avvio del programma
+     */
+    static qint64 now();
+
+    /**
+     * @brief Registra una misura
+     * @param[in] name Nome dell'operazione (stringa costante)
+     * @param[in] start Inizio in nanosecondi (da now())
+     * @param[in] end Fine in nanosecondi (da now())
+     */
+    static void record(const char *name, qint64 start, qint64 end);
+};
+
+/**
+ * @class Profiler::Scope
+ * @brief Misura la durata dello scope in cui è dichiarato
+ *
+ * @details
+ * @code
+ * void ContactList::sort()
+ * {
+ *     const Profiler::Scope scope("ContactList::sort");
+ *     ...
+ * }
+ * @endcode
+ * Il nome deve restare valido fino alla fine del programma (una stringa letterale).
+ */
+class Profiler::Scope
+{
+public:
+    /**
+     * @brief Inizia la misura, se la profilazione è attiva
+     * @param[in] name Nome dell'operazione (stringa letterale)
+     */
+    explicit Scope(const char *name)
+        : m_name(Profiler::isEnabled() ? name : nullptr)
+    {
+        if (m_name != nullptr)
+            m_start = Profiler::now();
+    }
+
+    /**
+     * @brief Termina la misura e la registra
+     */
+    ~Scope()
+    {
+        if (m_name != nullptr)
+            Profiler::record(m_name, m_start, Profiler::now());
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name; /**< Operazione misurata, nullptr se la profilazione era disattivata */
+    qint64 m_start = 0; /**< Inizio della misura in nanosecondi */
+};
+
+#endif // PROFILER_HPP
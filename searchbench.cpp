@@ -0,0 +1,170 @@
+/**
+ * @file searchbench.cpp
+ * @brief Confronto tra la vecchia ricerca per scansione e SearchIndex
+ *
+ * @details
+ * Genera una rubrica sintetica e, per ogni query, misura:
+ * - la ricerca originale di ContactList::search: una lista concatenata di
+ *   contatti, per ognuno toUpper() dei tre campi e QString::contains
+ * - SearchIndex::find sulla query già analizzata, che scansiona il buffer
+ *   contiguo senza passare dalla cache dei risultati
+ * - SearchIndex::find sul testo, che dalla seconda volta usa la cache
+ *
+ * Per ogni misura vale il migliore di --repeat giri. Il numero di risultati
+ * delle tre misure deve coincidere: altrimenti il programma esce con 1.
+ *
+ * Esempio:
+ * @code
+ * RubricaSearchBench --contacts 200000 --repeat 5 rossi 333 gmail
+ * @endcode
+ */
+
+#include "contatto.hpp"
+#include "searchindex.hpp"
+#include "searchquery.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <random>
+#include <utility>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_searchbench_namespace {
+
+/**
+ * @brief Rubrica sintetica con nomi, telefoni ed email ripetuti come in una rubrica vera
+ */
+QVector<Contact> makeBook(int count)
+{
+    static const QStringList kNames{"Mario", "Anna", "Luca", "Giulia", "Paolo", "Chiara", "Marco", "Sara", "Ugo", "Zeno"};
+    static const QStringList kSurnames{"Rossi", "Bianchi", "De Luca", "Verdi", "Ferrari", "Russo", "Esposito", "Romano"};
+    static const QStringList kDomains{"gmail.com", "libero.it", "outlook.com", "azienda.it"};
+
+    std::mt19937 random(1);
+    QVector<Contact> contacts;
+    contacts.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString name = QString("%1 %2 %3")
+                                 .arg(kNames[random() % kNames.size()], kSurnames[random() % kSurnames.size()])
+                                 .arg(random() % 1000);
+        const QString phone = QString("3%1").arg(random() % 1000000000u, 9, 10, QChar(u'0'));
+        // un contatto su tre senza email
+        const QString email = random() % 3 == 0
+                                  ? QString()
+                                  : QString("utente%1@%2").arg(i).arg(kDomains[random() % kDomains.size()]);
+        contacts.append(Contact(name, phone, email));
+    }
+    return contacts;
+}
+
+/**
+ * @brief La ricerca di ContactList::search prima di SearchIndex
+ * @return Numero di contatti trovati
+ */
+qsizetype scan(const std::list<Contact> &nodes, const QString &query)
+{
+    qsizetype found = 0;
+    const QString searchStr = query.toUpper();
+    for (const Contact &contact : nodes) {
+        const QString name = contact.name().toUpper();
+        const QString email = contact.email().toUpper();
+        const QString phone = contact.phone().toUpper();
+        if (name.contains(searchStr) || email.contains(searchStr) || phone.contains(searchStr))
+            found++;
+    }
+    return found;
+}
+
+/**
+ * @brief Migliore durata di repeat esecuzioni, in nanosecondi
+ * @param[out] result Risultato dell'ultima esecuzione
+ */
+template<typename Work>
+qint64 best(int repeat, qsizetype *result, Work work)
+{
+    qint64 fastest = std::numeric_limits<qint64>::max();
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        *result = work();
+        fastest = std::min(fastest, timer.nsecsElapsed());
+    }
+    return fastest;
+}
+
+} // namespace m_searchbench_namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace m_searchbench_namespace;
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RubricaSearchBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Confronta la ricerca per scansione con SearchIndex su una rubrica sintetica");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"contacts", "Contatti della rubrica.", "n", "100000"},
+        {"repeat", "Giri per ogni misura (vale il migliore).", "n", "5"},
+    });
+    parser.addPositionalArgument("query", "Query da misurare (predefinite: rossi, mario rossi, 333, gmail, zzz).");
+    parser.process(app);
+    const int count = std::max(1, parser.value("contacts").toInt());
+    const int repeat = std::max(1, parser.value("repeat").toInt());
+    QStringList queries = parser.positionalArguments();
+    if (queries.isEmpty())
+        queries = QStringList{"rossi", "mario rossi", "333", "gmail", "zzz"};
+
+    const QVector<Contact> contacts = makeBook(count);
+    const std::list<Contact> nodes(contacts.cbegin(), contacts.cend());
+
+    QElapsedTimer timer;
+    timer.start();
+    SearchIndex index;
+    index.reserve(count, qsizetype(count) * 48);
+    for (const Contact &contact : contacts)
+        index.append(contact.name(), contact.phone(), contact.email());
+    const qint64 buildNanos = timer.nsecsElapsed();
+
+    QTextStream out(stdout);
+    out << QString("%1 contatti, indice costruito in %2 ms\n\n").arg(count).arg(buildNanos / 1e6, 0, 'f', 1);
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg("query", -12)
+               .arg("risultati", 10)
+               .arg("scansione ms", 13)
+               .arg("indice ms", 10)
+               .arg("cache ms", 9)
+               .arg("rapporto", 9);
+
+    bool mismatch = false;
+    for (const QString &query : std::as_const(queries)) {
+        qsizetype scanned = 0;
+        qsizetype indexed = 0;
+        qsizetype cached = 0;
+        const qint64 scanNanos = best(repeat, &scanned, [&]() { return scan(nodes, query); });
+        const SearchQuery parsed = SearchQuery::parse(query);
+        const qint64 indexNanos = best(repeat, &indexed, [&]() { return index.find(parsed).size(); });
+        index.find(query); // riempie la cache
+        const qint64 cacheNanos = best(repeat, &cached, [&]() { return index.find(query).size(); });
+
+        out << QString("%1 %2 %3 %4 %5 %6x\n")
+                   .arg(query, -12)
+                   .arg(indexed, 10)
+                   .arg(scanNanos / 1e6, 13, 'f', 2)
+                   .arg(indexNanos / 1e6, 10, 'f', 2)
+                   .arg(cacheNanos / 1e6, 9, 'f', 3)
+                   .arg(double(scanNanos) / double(std::max<qint64>(1, indexNanos)), 8, 'f', 1);
+        if (scanned != indexed || cached != indexed) {
+            out << QString("  risultati diversi: scansione %1, indice %2, cache %3\n").arg(scanned).arg(indexed).arg(cached);
+            mismatch = true;
+        }
+    }
+    return mismatch ? 1 : 0;
+}
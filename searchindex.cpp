@@ -0,0 +1,864 @@
+/**
+ * @file searchindex.cpp
+ * @brief SearchIndex class implementation
+ */
+
+#include "searchindex.hpp"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCH_HAS_SSE2 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_search_namespace {
+// Separatore tra i campi nel buffer (ASCII "unit separator")
+constexpr char kSeparator = '\x1F';
+
+// Capacità della cache dei risultati, in indici di contatto (4 MB)
+constexpr qsizetype kResultCacheCost = 1 << 20;
+// Costo fisso di ogni query in cache: limita anche il numero di query (al massimo 256)
+constexpr qsizetype kResultEntryCost = 4096;
+// Stima dell'overhead di una query in cache: nodo del QCache, QVector e intestazioni dei buffer
+constexpr qsizetype kResultEntryBytes = 64 + qsizetype(sizeof(QString)) + qsizetype(sizeof(QVector<int>)) + 2 * 32;
+
+// Firma comune delle implementazioni della scansione
+using FindFunction = const char *(*) (const char *, const char *, const char *, qsizetype);
+
+/**
+ * @brief Codifica un code point in UTF-8 in coda al buffer
+ */
+void appendUtf8(QByteArray &out, char32_t ucs4)
+{
+    if (ucs4 < 0x80) {
+        out.append(char(ucs4));
+    } else if (ucs4 < 0x800) {
+        out.append(char(0xC0 | (ucs4 >> 6)));
+        out.append(char(0x80 | (ucs4 & 0x3F)));
+    } else if (ucs4 < 0x10000) {
+        out.append(char(0xE0 | (ucs4 >> 12)));
+        out.append(char(0x80 | ((ucs4 >> 6) & 0x3F)));
+        out.append(char(0x80 | (ucs4 & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (ucs4 >> 18)));
+        out.append(char(0x80 | ((ucs4 >> 12) & 0x3F)));
+        out.append(char(0x80 | ((ucs4 >> 6) & 0x3F)));
+        out.append(char(0x80 | (ucs4 & 0x3F)));
+    }
+}
+
+/**
+ * @brief Converte il testo in maiuscolo UTF-8 senza creare QString temporanee
+ *
+ * I caratteri ASCII (quasi tutti, tra telefoni ed email) passano dal percorso veloce,
+ * gli altri vengono convertiti con QChar::toUpper sul singolo code point.
+ */
+void appendNormalized(QByteArray &out, QStringView text)
+{
+    const qsizetype count = text.size();
+    for (qsizetype i = 0; i < count; ++i) {
+        const char16_t c = text[i].unicode();
+        if (c < 0x80) {
+            out.append(char(c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c));
+            continue;
+        }
+
+        char32_t ucs4 = c;
+        if (QChar::isHighSurrogate(c) && i + 1 < count && text[i + 1].isLowSurrogate()) {
+            ucs4 = QChar::surrogateToUcs4(c, text[i + 1].unicode());
+            ++i;
+        }
+        appendUtf8(out, QChar::toUpper(ucs4));
+    }
+}
+
+/**
+ * @brief Scansione scalare: memchr sul primo byte, controllo dell'ultimo, memcmp del resto
+ * @note Richiede n >= 2
+ */
+const char *findScalar(const char *p, const char *end, const char *needle, qsizetype n)
+{
+    const char last = needle[n - 1];
+    while (end - p >= n) {
+        p = static_cast<const char *>(std::memchr(p, needle[0], size_t((end - p) - n + 1)));
+        if (!p)
+            return nullptr;
+        if (p[n - 1] == last && std::memcmp(p + 1, needle + 1, size_t(n - 2)) == 0)
+            return p;
+        ++p;
+    }
+    return nullptr;
+}
+
+#ifdef SEARCH_HAS_SSE2
+/**
+ * @brief Scansione SSE2: confronta 16 posizioni alla volta su primo e ultimo byte
+ *
+ * Algoritmo:
+ * 1. Carica il blocco che inizia in p e quello che inizia in p + n - 1
+ * 2. Confronta il primo con needle[0] e il secondo con needle[n - 1]
+ * 3. L'AND dei due confronti dà le posizioni candidate, verificate con memcmp
+ *
+ * @note Richiede n >= 2
+ */
+const char *findSse2(const char *p, const char *end, const char *needle, qsizetype n)
+{
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[n - 1]);
+
+    // entrambi i blocchi da 16 byte devono restare dentro al buffer
+    while (end - p >= n - 1 + 16) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + n - 1));
+        quint32 mask = quint32(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+
+        while (mask) {
+            const int bit = int(qCountTrailingZeroBits(mask));
+            if (std::memcmp(p + bit + 1, needle + 1, size_t(n - 2)) == 0)
+                return p + bit;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+
+    // la coda più corta di un blocco viene gestita in modo scalare
+    return findScalar(p, end, needle, n);
+}
+#endif // SEARCH_HAS_SSE2
+
+#if defined(SEARCH_HAS_SSE2) && (defined(__GNUC__) || defined(__AVX2__))
+#define SEARCH_HAS_AVX2 1
+/**
+ * @brief Scansione AVX2: come findSse2 ma su 32 posizioni alla volta
+ *
+ * Con GCC/Clang la funzione viene compilata per AVX2 anche se il resto del
+ * programma non lo è, e viene scelta a runtime solo se la CPU lo supporta.
+ *
+ * @note Richiede n >= 2
+ */
+#if defined(__GNUC__) && !defined(__AVX2__)
+__attribute__((target("avx2")))
+#endif
+const char *findAvx2(const char *p, const char *end, const char *needle, qsizetype n)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+
+    while (end - p >= n - 1 + 32) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + n - 1));
+        quint32 mask = quint32(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                             _mm256_cmpeq_epi8(last, blockLast))));
+
+        while (mask) {
+            const int bit = int(qCountTrailingZeroBits(mask));
+            if (std::memcmp(p + bit + 1, needle + 1, size_t(n - 2)) == 0)
+                return p + bit;
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+
+    return findSse2(p, end, needle, n);
+}
+#endif // SEARCH_HAS_AVX2
+
+/**
+ * @brief Sceglie una sola volta l'implementazione migliore per la CPU corrente
+ */
+FindFunction pickImplementation()
+{
+#if defined(SEARCH_HAS_AVX2) && defined(__AVX2__)
+    return findAvx2;
+#elif defined(SEARCH_HAS_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return findAvx2;
+    return findSse2;
+#elif defined(SEARCH_HAS_SSE2)
+    return findSse2;
+#else
+    return findScalar;
+#endif
+}
+
+/**
+ * @brief Cerca needle in [begin, end)
+ * @return Puntatore alla prima occorrenza oppure nullptr
+ */
+const char *findBytes(const char *begin, const char *end, const char *needle, qsizetype n)
+{
+    static const FindFunction implementation = pickImplementation();
+
+    if (n == 0)
+        return begin;
+    if (end - begin < n)
+        return nullptr;
+    if (n == 1)
+        return static_cast<const char *>(std::memchr(begin, needle[0], size_t(end - begin)));
+    return implementation(begin, end, needle, n);
+}
+
+/**
+ * @brief Firma a 64 bit dei byte presenti nel testo (un bit per byte, modulo 64)
+ *
+ * Se un bit della query manca nel testo serve almeno un errore per coprirlo,
+ * anche quando più byte condividono lo stesso bit: il filtro non scarta mai un match valido.
+ */
+quint64 byteSignature(const char *p, qsizetype n)
+{
+    quint64 signature = 0;
+    for (qsizetype i = 0; i < n; ++i)
+        signature |= quint64(1) << (uchar(p[i]) & 63);
+    return signature;
+}
+
+/**
+ * @brief Distanza di edit minima tra la query e una qualsiasi sottostringa del testo
+ *
+ * Algoritmo bit-parallel di Myers (nella formulazione di Hyyrö):
+ * - peq[c] ha un bit per ogni posizione della query che contiene il byte c
+ * - pv/mv codificano le differenze verticali (+1/-1) della colonna della matrice DP
+ * - score è il valore dell'ultima riga, cioè la distanza della query intera
+ * - non inserendo 1 nel bit basso dopo lo shift la prima riga resta a 0,
+ *   così il match può iniziare in qualsiasi punto del testo
+ *
+ * @return La distanza minima, oppure maxDistance + 1 se supera maxDistance
+ */
+int myersDistance(const quint64 *peq, int m, const char *text, qsizetype len, int maxDistance)
+{
+    const quint64 high = quint64(1) << (m - 1);
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = m;
+    int best = m;
+
+    for (qsizetype j = 0; j < len && best > 0; ++j) {
+        const quint64 eq = peq[uchar(text[j])];
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+
+        if (ph & high)
+            ++score;
+        else if (mh & high)
+            --score;
+
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        best = std::min(best, score);
+    }
+
+    return best <= maxDistance ? best : maxDistance + 1;
+}
+} // namespace m_search_namespace
+
+SearchIndex::SearchIndex()
+    : m_resultCache(m_search_namespace::kResultCacheCost)
+{
+    clear();
+}
+
+void SearchIndex::clear()
+{
+    m_generation++;
+    m_buffer.clear();
+    m_offsets.clear();
+    m_offsets.append(0);
+    m_nameSignatures.clear();
+    m_byteCounts.fill(0, FieldCount * 256);
+    m_fieldBytes.fill(0, FieldCount);
+    for (QVector<int> &sorted : m_sortedByField)
+        sorted.clear();
+    // gli indici salvati si riferiscono ai contatti precedenti
+    m_resultCache.clear();
+}
+
+void SearchIndex::reserve(qsizetype records, qsizetype bytes)
+{
+    m_buffer.reserve(bytes);
+    m_offsets.reserve(records * FieldCount + 1);
+    m_nameSignatures.reserve(records);
+}
+
+void SearchIndex::append(QStringView name, QStringView phone, QStringView email)
+{
+    const quint32 nameBegin = m_offsets.last();
+
+    // ogni campo viene chiuso dal separatore, l'offset salvato è l'inizio del campo successivo
+    int field = Name;
+    for (QStringView text : {name, phone, email}) {
+        const qsizetype begin = m_buffer.size();
+        m_search_namespace::appendNormalized(m_buffer, text);
+
+        // frequenza dei byte del campo, usata per stimare la selettività delle query
+        quint64 *counts = m_byteCounts.data() + field * 256;
+        for (qsizetype i = begin; i < m_buffer.size(); ++i)
+            counts[uchar(m_buffer[i])]++;
+        m_fieldBytes[field] += quint64(m_buffer.size() - begin);
+
+        m_buffer.append(m_search_namespace::kSeparator);
+        m_offsets.append(quint32(m_buffer.size()));
+        field++;
+    }
+
+    const quint32 nameEnd = m_offsets[m_offsets.size() - FieldCount] - 1;
+    m_nameSignatures.append(m_search_namespace::byteSignature(m_buffer.constData() + nameBegin,
+                                                              nameEnd - nameBegin));
+}
+
+qsizetype SearchIndex::size() const
+{
+    return (m_offsets.size() - 1) / FieldCount;
+}
+
+QVector<int> SearchIndex::find(const QString &query) const
+{
+    // passando dal cursore la query usa anche la cache dei risultati
+    Cursor cursor = open(query);
+    return fetch(cursor, std::numeric_limits<int>::max());
+}
+
+QVector<int> SearchIndex::find(const SearchQuery &query) const
+{
+    Cursor cursor = open(query);
+    return fetch(cursor, std::numeric_limits<int>::max());
+}
+
+SearchIndex::Cursor SearchIndex::open(const QString &query) const
+{
+    const SearchQuery parsed = SearchQuery::parse(query);
+    // la query vuota non richiede alcuna scansione, inutile salvarla
+    if (parsed.matchesAll())
+        return open(parsed);
+
+    const QString key = QLatin1Char('=') + query;
+    QVector<int> cached;
+    if (cachedResult(key, &cached)) {
+        Cursor cursor;
+        cursor.m_generation = m_generation;
+        cursor.m_records = int(size());
+        cursor.m_cacheHit = true;
+        cursor.m_results = cached;
+        cursor.m_atEnd = cached.isEmpty();
+        return cursor;
+    }
+
+    Cursor cursor = open(parsed);
+    cursor.m_cacheKey = key;
+    return cursor;
+}
+
+SearchIndex::Cursor SearchIndex::open(const SearchQuery &query) const
+{
+    Cursor cursor;
+    cursor.m_generation = m_generation;
+    cursor.m_records = int(size());
+    cursor.m_matchesAll = query.matchesAll();
+
+    if (!cursor.m_matchesAll) {
+        cursor.m_groups = plan(query);
+        cursor.m_next.fill(-1, cursor.m_groups.size());
+    }
+
+    cursor.m_atEnd = cursor.m_records == 0;
+    return cursor;
+}
+
+SearchIndex::Cursor SearchIndex::open(const SearchQuery &query, int from, qsizetype found) const
+{
+    Cursor cursor = open(query);
+    cursor.m_from = std::clamp(from, 0, cursor.m_records);
+    cursor.m_found = found;
+    cursor.m_atEnd = cursor.m_from >= cursor.m_records;
+    return cursor;
+}
+
+QVector<int> SearchIndex::fetch(Cursor &cursor, int limit) const
+{
+    QVector<int> result;
+    if (cursor.m_atEnd)
+        return result;
+
+    // l'indice è stato ricostruito: il piano e le posizioni non sono più validi
+    if (cursor.m_generation != m_generation) {
+        cursor.m_atEnd = true;
+        return result;
+    }
+
+    // risultati dalla cache: m_from è la posizione nei risultati salvati
+    if (cursor.m_cacheHit) {
+        const qsizetype end = std::min<qsizetype>(qsizetype(cursor.m_from) + limit, cursor.m_results.size());
+        result = cursor.m_results.mid(cursor.m_from, end - cursor.m_from);
+        cursor.m_from = int(end);
+        cursor.m_found += result.size();
+        cursor.m_atEnd = end >= cursor.m_results.size();
+        return result;
+    }
+
+    const int records = cursor.m_records;
+
+    if (cursor.m_matchesAll) {
+        const int end = int(std::min<qint64>(qint64(cursor.m_from) + limit, records));
+        result.reserve(end - cursor.m_from);
+        for (int record = cursor.m_from; record < end; ++record)
+            result.append(record);
+        cursor.m_from = end;
+    } else {
+        // per ogni gruppo tengo il prossimo contatto trovato, il risultato è
+        // l'unione ordinata dei gruppi (OR)
+        while (cursor.m_from < records && result.size() < limit) {
+            int best = records;
+            for (qsizetype g = 0; g < cursor.m_groups.size(); ++g) {
+                if (cursor.m_next[g] < cursor.m_from)
+                    cursor.m_next[g] = nextInGroup(cursor.m_groups[g], cursor.m_from);
+                best = std::min(best, cursor.m_next[g]);
+            }
+
+            if (best >= records) {
+                cursor.m_from = records;
+                break;
+            }
+            result.append(best);
+            cursor.m_from = best + 1;
+        }
+    }
+
+    cursor.m_found += result.size();
+    cursor.m_atEnd = cursor.m_from >= records;
+
+    // a scansione completa i risultati raccolti pagina per pagina finiscono in cache
+    if (!cursor.m_cacheKey.isEmpty()) {
+        if (cursor.m_results.isEmpty())
+            cursor.m_results = result;
+        else
+            cursor.m_results += result;
+
+        if (cursor.m_atEnd) {
+            storeResult(cursor.m_cacheKey, cursor.m_results);
+            cursor.m_cacheKey.clear();
+            cursor.m_results.clear();
+        }
+    }
+
+    return result;
+}
+
+QVector<int> SearchIndex::fuzzyFind(const QString &query, int maxDistance, int limit) const
+{
+    QVector<int> result;
+    if (limit <= 0)
+        return result;
+
+    QByteArray needle = normalize(query);
+    if (needle.size() > 64)
+        needle.truncate(64);
+    const int m = int(needle.size());
+    const qsizetype records = size();
+
+    // query vuota: come la ricerca esatta corrisponde a tutti i contatti
+    if (m == 0) {
+        for (int record = 0; record < records && result.size() < limit; ++record)
+            result.append(record);
+        return result;
+    }
+
+    const QString key = QString("~%1:%2:").arg(maxDistance).arg(limit) + query;
+    if (cachedResult(key, &result))
+        return result;
+
+    // le query corte ammettono meno errori, altrimenti corrisponderebbe quasi tutto
+    maxDistance = std::min(maxDistance, m < 3 ? 0 : (m < 6 ? 1 : m));
+    maxDistance = std::max(maxDistance, 0);
+
+    quint64 peq[256] = {};
+    for (int i = 0; i < m; ++i)
+        peq[uchar(needle[i])] |= quint64(1) << i;
+    const quint64 needleSignature = m_search_namespace::byteSignature(needle.constData(), m);
+
+    // un contenitore per ogni distanza: i contatti sono visitati in ordine,
+    // quindi ogni contenitore è già ordinato per indice
+    QVector<QVector<int>> buckets(maxDistance + 1);
+    int threshold = maxDistance; // distanza massima ancora utile
+    qsizetype found = 0;         // risultati a distanza <= threshold
+    const char *base = m_buffer.constData();
+
+    for (int record = 0; record < records && threshold >= 0; ++record) {
+        // pre-filtro: ogni classe di byte della query assente nel nome costa almeno un errore
+        const quint64 missing = needleSignature & ~m_nameSignatures[record];
+        if (qPopulationCount(missing) > uint(threshold))
+            continue;
+
+        const quint32 begin = m_offsets[record * FieldCount + Name];
+        const qsizetype length = qsizetype(m_offsets[record * FieldCount + Name + 1] - begin) - 1;
+        if (length < m - threshold)
+            continue;
+
+        const int distance = m_search_namespace::myersDistance(peq, m, base + begin, length, threshold);
+        if (distance > threshold)
+            continue;
+
+        buckets[distance].append(record);
+        found++;
+
+        // se ci sono già 'limit' risultati a distanza <= threshold, un nuovo contatto
+        // a distanza threshold finirebbe comunque dopo di loro: servono solo distanze minori
+        while (threshold >= 0 && found >= limit) {
+            found -= buckets[threshold].size();
+            threshold--;
+        }
+    }
+
+    for (const QVector<int> &bucket : buckets) {
+        const qsizetype take = std::min<qsizetype>(bucket.size(), limit - result.size());
+        for (qsizetype i = 0; i < take; ++i)
+            result.append(bucket[i]);
+    }
+
+    storeResult(key, result);
+    return result;
+}
+
+QVector<SearchIndex::GroupPlan> SearchIndex::plan(const SearchQuery &query) const
+{
+    QVector<GroupPlan> groups;
+
+    for (const QVector<SearchTerm> &terms : query.groups()) {
+        GroupPlan group;
+        bool impossible = false;
+
+        for (const SearchTerm &term : terms) {
+            // il separatore non compare mai dentro un campo
+            if (term.text.contains(m_search_namespace::kSeparator)) {
+                impossible = true;
+                break;
+            }
+
+            TermPlan planned;
+            planned.term = term;
+            planned.estimate = estimate(term);
+            group.append(planned);
+        }
+
+        if (impossible)
+            continue;
+
+        // il termine più selettivo guida, gli altri vengono verificati dal più selettivo
+        std::stable_sort(group.begin(), group.end(), [](const TermPlan &a, const TermPlan &b) {
+            return a.estimate < b.estimate;
+        });
+
+        // un prefisso che guida non scansiona nulla: i candidati vengono dall'indice ordinato
+        TermPlan &driver = group.first();
+        if (driver.term.prefix) {
+            const int first = driver.term.field == SearchTerm::AnyField ? 0 : driver.term.field;
+            const int last = driver.term.field == SearchTerm::AnyField ? FieldCount - 1 : driver.term.field;
+
+            for (int field = first; field <= last; ++field) {
+                qsizetype begin = 0;
+                qsizetype end = 0;
+                prefixRange(field, driver.term.text, &begin, &end);
+                const QVector<int> &sorted = sortedBy(field);
+                for (qsizetype i = begin; i < end; ++i)
+                    driver.candidates.append(sorted[i]);
+            }
+
+            std::sort(driver.candidates.begin(), driver.candidates.end());
+            driver.candidates.erase(std::unique(driver.candidates.begin(), driver.candidates.end()),
+                                    driver.candidates.end());
+            driver.indexed = true;
+        }
+
+        groups.append(group);
+    }
+
+    return groups;
+}
+
+qsizetype SearchIndex::estimate(const SearchTerm &term) const
+{
+    const qsizetype records = size();
+    const int first = term.field == SearchTerm::AnyField ? 0 : term.field;
+    const int last = term.field == SearchTerm::AnyField ? FieldCount - 1 : term.field;
+
+    // per i prefissi l'indice ordinato dà il conteggio esatto
+    if (term.prefix) {
+        qsizetype total = 0;
+        for (int field = first; field <= last; ++field) {
+            qsizetype begin = 0;
+            qsizetype end = 0;
+            prefixRange(field, term.text, &begin, &end);
+            total += end - begin;
+        }
+        return std::min(total, records);
+    }
+
+    // altrimenti stimo la probabilità che il testo compaia in un campo, supponendo
+    // i byte indipendenti, moltiplicata per le posizioni in cui può iniziare
+    double probability = 0;
+    for (int field = first; field <= last; ++field) {
+        const quint64 bytes = m_fieldBytes[field];
+        if (bytes == 0 || records == 0)
+            continue;
+
+        const quint64 *counts = m_byteCounts.constData() + field * 256;
+        double p = 1;
+        for (const char c : term.text)
+            p *= double(counts[uchar(c)]) / double(bytes);
+
+        const double averageLength = double(bytes) / double(records);
+        const double positions = std::max(1.0, averageLength - double(term.text.size()) + 1);
+        probability += std::min(1.0, p * positions);
+    }
+
+    return qsizetype(std::min(1.0, probability) * double(records));
+}
+
+int SearchIndex::nextForTerm(const TermPlan &term, int from) const
+{
+    const int records = int(size());
+
+    if (term.indexed) {
+        const auto it = std::lower_bound(term.candidates.cbegin(), term.candidates.cend(), from);
+        return it == term.candidates.cend() ? records : *it;
+    }
+
+    // su tutti i campi scansiono direttamente il buffer, saltando i separatori
+    if (term.term.field == SearchTerm::AnyField && !term.term.prefix) {
+        if (from >= records)
+            return records;
+
+        const char *base = m_buffer.constData();
+        const char *end = base + m_buffer.size();
+        const char *hit = m_search_namespace::findBytes(base + m_offsets[from * FieldCount], end,
+                                                        term.term.text.constData(),
+                                                        term.term.text.size());
+        if (!hit)
+            return records;
+
+        // risalgo al contatto: l'ultimo offset <= posizione trovata indica il campo
+        const quint32 offset = quint32(hit - base);
+        const auto field = std::upper_bound(m_offsets.cbegin(), m_offsets.cend(), offset) - 1;
+        return int(field - m_offsets.cbegin()) / FieldCount;
+    }
+
+    for (int record = from; record < records; ++record) {
+        if (matches(term.term, record))
+            return record;
+    }
+    return records;
+}
+
+int SearchIndex::nextInGroup(const GroupPlan &group, int from) const
+{
+    const int records = int(size());
+
+    while (from < records) {
+        const int candidate = nextForTerm(group.first(), from);
+        if (candidate >= records)
+            return records;
+
+        bool accepted = true;
+        for (qsizetype i = 1; i < group.size() && accepted; ++i)
+            accepted = matches(group[i].term, candidate);
+
+        if (accepted)
+            return candidate;
+        from = candidate + 1;
+    }
+
+    return records;
+}
+
+bool SearchIndex::accepts(const SearchQuery &query, int record) const
+{
+    if (query.matchesAll())
+        return true;
+
+    // gruppi in OR, termini in AND, come nel piano di find
+    for (const QVector<SearchTerm> &terms : query.groups()) {
+        bool accepted = true;
+        for (const SearchTerm &term : terms) {
+            if (term.text.contains(m_search_namespace::kSeparator) || !matches(term, record)) {
+                accepted = false;
+                break;
+            }
+        }
+        if (accepted)
+            return true;
+    }
+    return false;
+}
+
+bool SearchIndex::matches(const SearchTerm &term, int record) const
+{
+    const char *base = m_buffer.constData();
+    const char *needle = term.text.constData();
+    const qsizetype n = term.text.size();
+    const quint32 *offsets = m_offsets.constData() + record * FieldCount;
+
+    // su tutti i campi basta una sola scansione del contatto
+    if (term.field == SearchTerm::AnyField && !term.prefix)
+        return m_search_namespace::findBytes(base + offsets[Name], base + offsets[FieldCount] - 1,
+                                             needle, n) != nullptr;
+
+    const int first = term.field == SearchTerm::AnyField ? 0 : term.field;
+    const int last = term.field == SearchTerm::AnyField ? FieldCount - 1 : term.field;
+
+    for (int field = first; field <= last; ++field) {
+        const char *begin = base + offsets[field];
+        const char *end = base + offsets[field + 1] - 1;
+
+        if (term.prefix) {
+            if (end - begin >= n && std::memcmp(begin, needle, size_t(n)) == 0)
+                return true;
+        } else if (m_search_namespace::findBytes(begin, end, needle, n)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SearchIndex::prefixRange(int field, const QByteArray &prefix, qsizetype *begin, qsizetype *end) const
+{
+    const QVector<int> &sorted = sortedBy(field);
+    const char *base = m_buffer.constData();
+    const qsizetype n = prefix.size();
+
+    // <0 se il campo viene prima del prefisso, 0 se inizia con il prefisso, >0 se viene dopo
+    const auto compare = [&](int record) {
+        const quint32 start = m_offsets[record * FieldCount + field];
+        const qsizetype length = qsizetype(m_offsets[record * FieldCount + field + 1] - start) - 1;
+        const int result = std::memcmp(base + start, prefix.constData(), size_t(std::min(length, n)));
+        if (result != 0)
+            return result;
+        return length < n ? -1 : 0;
+    };
+
+    const auto lower = std::partition_point(sorted.cbegin(), sorted.cend(),
+                                            [&](int record) { return compare(record) < 0; });
+    const auto upper = std::partition_point(lower, sorted.cend(),
+                                            [&](int record) { return compare(record) == 0; });
+    *begin = lower - sorted.cbegin();
+    *end = upper - sorted.cbegin();
+}
+
+const QVector<int> &SearchIndex::sortedBy(int field) const
+{
+    QVector<int> &sorted = m_sortedByField[field];
+    if (sorted.size() == size())
+        return sorted;
+
+    const char *base = m_buffer.constData();
+    sorted.resize(size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+
+    // ordine lessicografico dei byte normalizzati, come quello usato da prefixRange
+    std::sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        const quint32 startA = m_offsets[a * FieldCount + field];
+        const quint32 startB = m_offsets[b * FieldCount + field];
+        const qsizetype lengthA = qsizetype(m_offsets[a * FieldCount + field + 1] - startA) - 1;
+        const qsizetype lengthB = qsizetype(m_offsets[b * FieldCount + field + 1] - startB) - 1;
+        const int result = std::memcmp(base + startA, base + startB, size_t(std::min(lengthA, lengthB)));
+        return result < 0 || (result == 0 && lengthA < lengthB);
+    });
+
+    return sorted;
+}
+
+QByteArray SearchIndex::normalize(QStringView text)
+{
+    QByteArray normalized;
+    normalized.reserve(text.size());
+    m_search_namespace::appendNormalized(normalized, text);
+    return normalized;
+}
+
+SearchIndex::CacheStats SearchIndex::cacheStats() const
+{
+    CacheStats stats = m_cacheStats;
+    stats.entries = m_resultCache.count();
+    return stats;
+}
+
+SearchIndex::MemoryUsage SearchIndex::memoryUsage() const
+{
+    using m_search_namespace::kResultEntryBytes;
+    using m_search_namespace::kResultEntryCost;
+
+    MemoryUsage usage;
+    usage.buffer = m_buffer.capacity();
+
+    usage.indexes = m_offsets.capacity() * qsizetype(sizeof(quint32))
+                    + (m_nameSignatures.capacity() + m_byteCounts.capacity() + m_fieldBytes.capacity())
+                          * qsizetype(sizeof(quint64));
+    for (const QVector<int> &sorted : m_sortedByField)
+        usage.indexes += sorted.capacity() * qsizetype(sizeof(int));
+
+    // il costo di ogni query è kResultEntryCost più il numero di risultati:
+    // non si legge la cache con object(), che cambierebbe l'ordine LRU
+    const qsizetype entries = m_resultCache.count();
+    const qsizetype results = m_resultCache.totalCost() - entries * kResultEntryCost;
+    usage.cache = results * qsizetype(sizeof(int)) + entries * kResultEntryBytes;
+    const QList<QString> keys = m_resultCache.keys();
+    for (const QString &key : keys)
+        usage.cache += key.size() * qsizetype(sizeof(QChar));
+
+    return usage;
+}
+
+bool SearchIndex::cachedResult(const QString &key, QVector<int> *result) const
+{
+    // object() sposta anche la query in testa alla lista LRU
+    const QVector<int> *cached = m_resultCache.object(key);
+    if (cached == nullptr) {
+        m_cacheStats.misses++;
+        return false;
+    }
+
+    m_cacheStats.hits++;
+    *result = *cached; // copia condivisa (implicit sharing), nessuna allocazione
+    return true;
+}
+
+void SearchIndex::storeResult(const QString &key, const QVector<int> &result) const
+{
+    // se supera da sola la capacità della cache la query non viene salvata
+    m_resultCache.insert(key, new QVector<int>(result),
+                         m_search_namespace::kResultEntryCost + result.size());
+}
+
+bool SearchIndex::Cursor::atEnd() const
+{
+    return m_atEnd;
+}
+
+qsizetype SearchIndex::Cursor::found() const
+{
+    return m_found;
+}
+
+qsizetype SearchIndex::Cursor::estimatedTotal() const
+{
+    if (m_cacheHit)
+        return m_results.size();
+    if (m_atEnd || m_from == 0)
+        return m_found;
+
+    // i risultati finora sono proporzionali alla parte di rubrica già scansionata
+    return qsizetype(double(m_found) * double(m_records) / double(m_from));
+}
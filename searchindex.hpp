@@ -0,0 +1,365 @@
+/**
+ * @file searchindex.hpp
+ * @brief Buffer contiguo per la ricerca per sottostringa nella rubrica
+ *
+ * @details
+ * Invece di scorrere la linked list e chiamare QString::contains su ogni campo,
+ * tutti i campi (nome, telefono, email) vengono normalizzati una sola volta
+ * (maiuscolo, codifica UTF-8) e copiati uno dopo l'altro in un unico buffer.
+ * Un vettore di offset permette di risalire dal byte trovato al contatto.
+ */
+
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include <QByteArray>
+#include <QCache>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "searchquery.hpp"
+
+/**
+ * @class SearchIndex
+ * @brief Indice di ricerca a buffer contiguo
+ *
+ * @details
+ * Struttura del buffer, per ogni contatto:
+ * NOME\\x1F TELEFONO\\x1F EMAIL\\x1F
+ *
+ * - Il separatore non può comparire in una query, quindi un match non può
+ *   mai "scavalcare" due campi
+ * - m_offsets contiene l'inizio di ogni campo (3 per contatto) più la fine del buffer
+ * - La scansione usa un filtro vettoriale sul primo e sull'ultimo byte della
+ *   query (AVX2/SSE2, con fallback scalare) e verifica con memcmp solo i candidati
+ *
+ * Gli indici restituiti sono le posizioni dei contatti nell'ordine di inserimento
+ * nell'indice (per ContactList: l'ordine della lista).
+ *
+ * Oltre alla ricerca esatta è disponibile una ricerca approssimata sul nome
+ * (fuzzyFind), tollerante a qualche errore di battitura.
+ *
+ * Le query strutturate (vedi SearchQuery) vengono pianificate: per ogni campo
+ * l'indice tiene la frequenza dei byte e, costruito solo al primo utilizzo,
+ * l'ordine dei contatti per valore del campo, usato per i termini "^prefisso".
+ *
+ * I risultati possono essere letti a pagine con un Cursor (open/fetch), così la
+ * prima pagina arriva subito anche quando la query corrisponde a quasi tutti i contatti.
+ *
+ * I risultati delle ultime query (esatte e approssimate) restano in una cache LRU,
+ * svuotata quando l'indice viene ricostruito: ripetere una ricerca recente non
+ * richiede una nuova scansione.
+ */
+class SearchIndex
+{
+public:
+    /**
+     * @brief Campi indicizzati per ogni contatto
+     */
+    enum Field { Name = 0, Phone = 1, Email = 2, FieldCount = 3 };
+
+    class Cursor;
+
+    /**
+     * @brief Statistiche della cache dei risultati
+     */
+    struct CacheStats
+    {
+        quint64 hits = 0;      /**< Ricerche servite dalla cache */
+        quint64 misses = 0;    /**< Ricerche che hanno richiesto una scansione */
+        qsizetype entries = 0; /**< Query attualmente in cache */
+    };
+
+    /**
+     * @brief Memoria occupata dall'indice, stimata in byte
+     */
+    struct MemoryUsage
+    {
+        qsizetype buffer = 0;  /**< Buffer dei campi normalizzati */
+        qsizetype indexes = 0; /**< Offset, firme dei nomi, frequenze dei byte e indici ordinati */
+        qsizetype cache = 0;   /**< Risultati in cache e relative chiavi */
+
+        /**
+         * @brief Memoria totale dell'indice
+         */
+        qsizetype total() const { return buffer + indexes + cache; }
+    };
+
+    /**
+     * @brief Costruttore, crea un indice vuoto
+     */
+    SearchIndex();
+
+    /**
+     * @brief Svuota l'indice
+     * @note Svuota anche la cache dei risultati, i contatori restano invariati
+     */
+    void clear();
+
+    /**
+     * @brief Prealloca lo spazio per evitare riallocazioni durante la costruzione
+     * @param[in] records Numero di contatti previsti
+     * @param[in] bytes Dimensione prevista del buffer in byte
+     */
+    void reserve(qsizetype records, qsizetype bytes);
+
+    /**
+     * @brief Aggiunge un contatto in coda all'indice
+     * @param[in] name Nome del contatto
+     * @param[in] phone Numero di telefono
+     * @param[in] email Indirizzo email (può essere vuoto)
+     */
+    void append(QStringView name, QStringView phone, QStringView email);
+
+    /**
+     * @brief Numero di contatti presenti nell'indice
+     */
+    qsizetype size() const;
+
+    /**
+     * @brief Cerca la query nei contatti
+     * @param[in] query Testo della query (case-insensitive), anche strutturata
+     * @return Indici crescenti dei contatti trovati
+     * @details
+     * Il testo viene analizzato con SearchQuery::parse: un testo semplice
+     * viene cercato in tutti i campi.
+     * @note Una query vuota corrisponde a tutti i contatti, come QString::contains
+     */
+    QVector<int> find(const QString &query) const;
+
+    /**
+     * @brief Esegue una query già analizzata
+     * @param[in] query Query da eseguire
+     * @return Indici crescenti dei contatti che soddisfano la query
+     * @details
+     * Per ogni gruppo in AND il piano di esecuzione:
+     * 1. stima quanti contatti soddisfano ogni termine
+     *    - termini "^prefisso": conteggio esatto sull'indice ordinato del campo
+     *    - altri termini: stima dalla frequenza dei byte nel campo
+     * 2. usa il termine più selettivo per generare i candidati
+     * 3. verifica gli altri termini solo sui candidati, dal più selettivo
+     *
+     * I gruppi in OR vengono uniti mantenendo l'ordine degli indici.
+     */
+    QVector<int> find(const SearchQuery &query) const;
+
+    /**
+     * @brief Apre una ricerca da leggere a pagine
+     * @param[in] query Testo della query (vedi find)
+     * @return Cursore posizionato prima del primo risultato
+     * @details
+     * - Se la query è in cache il cursore legge direttamente i risultati salvati
+     * - Altrimenti prepara solo il piano di esecuzione, la scansione avviene in fetch;
+     *   quando il cursore arriva in fondo i risultati vengono salvati in cache
+     */
+    Cursor open(const QString &query) const;
+
+    /**
+     * @brief Apre una ricerca già analizzata da leggere a pagine
+     * @param[in] query Query da eseguire
+     * @return Cursore posizionato prima del primo risultato
+     */
+    Cursor open(const SearchQuery &query) const;
+
+    /**
+     * @brief Riapre una ricerca da un contatto intermedio
+     * @param[in] query Query da eseguire
+     * @param[in] from Primo contatto da scansionare
+     * @param[in] found Risultati già letti prima di from (per found() e estimatedTotal())
+     * @return Cursore che legge i risultati da from in poi
+     * @details Serve a continuare una ricerca dopo una modifica della rubrica, senza
+     * rileggere le pagine già mostrate. I risultati non vengono salvati in cache.
+     */
+    Cursor open(const SearchQuery &query, int from, qsizetype found) const;
+
+    /**
+     * @brief Legge la pagina successiva di risultati
+     * @param[in,out] cursor Cursore restituito da open
+     * @param[in] limit Numero massimo di risultati da leggere
+     * @return Indici crescenti dei prossimi contatti trovati (vuoto se finiti)
+     * @details
+     * La scansione riprende dal punto in cui si era fermata la pagina precedente
+     * e si ferma appena trovati limit risultati.
+     */
+    QVector<int> fetch(Cursor &cursor, int limit) const;
+
+    /**
+     * @brief Verifica se un contatto soddisfa una query
+     * @param[in] query Query già analizzata
+     * @param[in] record Indice del contatto
+     * @return true se il contatto è tra i risultati di find(query)
+     * @details Nessun indice ausiliario: serve a filtrare i contatti in un ordine
+     * diverso da quello delle righe (vedi ContactList::sortedPage).
+     */
+    bool accepts(const SearchQuery &query, int record) const;
+
+    /**
+     * @brief Ricerca approssimata sul nome, tollerante agli errori di battitura
+     * @param[in] query Testo da cercare (case-insensitive)
+     * @param[in] maxDistance Numero massimo di errori ammessi (inserimenti, cancellazioni, sostituzioni)
+     * @param[in] limit Numero massimo di risultati
+     * @return Indici dei contatti ordinati per distanza crescente, a parità di distanza per indice
+     * @details
+     * - La query può comparire in un punto qualsiasi del nome (come nella ricerca esatta)
+     * - Gli errori ammessi crescono con la lunghezza della query: nessuno sotto i 3 caratteri,
+     *   1 fino a 5 caratteri, poi maxDistance
+     * - Un pre-filtro sui caratteri presenti nel nome (firma a 64 bit) e sulla lunghezza scarta
+     *   quasi tutti i contatti prima del calcolo della distanza
+     * - La distanza è calcolata con l'algoritmo bit-parallel di Myers, quindi vengono
+     *   usati al massimo i primi 64 byte della query
+     */
+    QVector<int> fuzzyFind(const QString &query, int maxDistance = 2, int limit = 50) const;
+
+    /**
+     * @brief Normalizza un testo nello stesso formato del buffer
+     * @param[in] text Testo da normalizzare
+     * @return Testo in maiuscolo codificato in UTF-8
+     */
+    static QByteArray normalize(QStringView text);
+
+    /**
+     * @brief Statistiche della cache dei risultati
+     * @return Hit e miss dalla creazione dell'indice, query attualmente in cache
+     */
+    CacheStats cacheStats() const;
+
+    /**
+     * @brief Memoria occupata dall'indice
+     * @return Memoria del buffer, degli indici ausiliari e della cache dei risultati
+     * @note Conta la capacità allocata dei vettori, non solo la parte usata
+     */
+    MemoryUsage memoryUsage() const;
+
+private:
+    /**
+     * @brief Termine di un gruppo con le informazioni del piano di esecuzione
+     */
+    struct TermPlan
+    {
+        SearchTerm term;         /**< Condizione da verificare */
+        qsizetype estimate = 0;  /**< Numero stimato di contatti che la soddisfano */
+        bool indexed = false;    /**< true se i candidati vengono dall'indice ordinato */
+        QVector<int> candidates; /**< Candidati in ordine crescente (solo se indexed) */
+    };
+
+    /**
+     * @brief Piano di un gruppo in AND: il primo termine genera i candidati
+     */
+    using GroupPlan = QVector<TermPlan>;
+
+    QByteArray m_buffer;        /**< Campi normalizzati di tutti i contatti, separati da 0x1F */
+    QVector<quint32> m_offsets; /**< Inizio di ogni campo nel buffer, più la fine del buffer */
+    QVector<quint64> m_nameSignatures; /**< Per ogni contatto, i byte presenti nel nome (1 bit per classe) */
+    QVector<quint64> m_byteCounts;     /**< Frequenza di ogni byte, 256 contatori per campo */
+    QVector<quint64> m_fieldBytes;     /**< Byte totali di ogni campo (separatori esclusi) */
+    quint64 m_generation = 0;          /**< Cambia a ogni clear(), invalida i cursori aperti */
+    mutable QVector<int> m_sortedByField[FieldCount]; /**< Contatti ordinati per valore del campo */
+    mutable QCache<QString, QVector<int>> m_resultCache; /**< Risultati delle ultime query (LRU) */
+    mutable CacheStats m_cacheStats;                      /**< Hit e miss della cache */
+
+    /**
+     * @brief Cerca i risultati di una query nella cache
+     * @param[in] key Chiave della query
+     * @param[out] result Risultati salvati, se presenti
+     * @retval true Query trovata in cache
+     * @retval false Query non presente, va eseguita la scansione
+     */
+    bool cachedResult(const QString &key, QVector<int> *result) const;
+
+    /**
+     * @brief Salva in cache i risultati completi di una query
+     */
+    void storeResult(const QString &key, const QVector<int> &result) const;
+
+    /**
+     * @brief Prepara il piano di esecuzione di ogni gruppo
+     * @details I termini di ogni gruppo vengono ordinati per stima crescente
+     */
+    QVector<GroupPlan> plan(const SearchQuery &query) const;
+
+    /**
+     * @brief Stima quanti contatti soddisfano il termine
+     */
+    qsizetype estimate(const SearchTerm &term) const;
+
+    /**
+     * @brief Primo contatto >= from che soddisfa il termine
+     * @return L'indice del contatto, oppure size() se non ce ne sono
+     */
+    int nextForTerm(const TermPlan &term, int from) const;
+
+    /**
+     * @brief Primo contatto >= from che soddisfa tutti i termini del gruppo
+     * @return L'indice del contatto, oppure size() se non ce ne sono
+     */
+    int nextInGroup(const GroupPlan &group, int from) const;
+
+    /**
+     * @brief Verifica un termine su un singolo contatto
+     */
+    bool matches(const SearchTerm &term, int record) const;
+
+    /**
+     * @brief Contatti che hanno il campo che inizia con il prefisso
+     * @param[in] field Campo da controllare
+     * @param[in] prefix Prefisso normalizzato
+     * @param[out] begin Inizio dell'intervallo in sortedBy(field)
+     * @param[out] end Fine dell'intervallo in sortedBy(field)
+     */
+    void prefixRange(int field, const QByteArray &prefix, qsizetype *begin, qsizetype *end) const;
+
+    /**
+     * @brief Contatti ordinati per valore del campo (costruito al primo utilizzo)
+     */
+    const QVector<int> &sortedBy(int field) const;
+};
+
+/**
+ * @class SearchIndex::Cursor
+ * @brief Stato di una ricerca letta a pagine
+ *
+ * @details
+ * Il cursore ricorda il piano della query e il punto in cui la scansione si è
+ * fermata: ogni pagina riprende da lì, senza rileggere i contatti già visti.
+ * Se l'indice viene ricostruito il cursore non è più valido e risulta terminato.
+ */
+class SearchIndex::Cursor
+{
+public:
+    /**
+     * @brief Verifica se tutti i risultati sono già stati letti
+     * @retval true Ricerca terminata (o cursore non valido)
+     * @retval false Ci possono essere altri risultati
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Numero di risultati letti finora
+     */
+    qsizetype found() const;
+
+    /**
+     * @brief Stima del numero totale di risultati
+     * @return Il totale esatto se la ricerca è terminata o servita dalla cache,
+     *         altrimenti una stima proporzionale alla parte di rubrica già scansionata
+     */
+    qsizetype estimatedTotal() const;
+
+private:
+    friend class SearchIndex;
+
+    QVector<GroupPlan> m_groups; /**< Piano di esecuzione di ogni gruppo in OR */
+    QVector<int> m_next;         /**< Prossimo contatto trovato per ogni gruppo */
+    bool m_matchesAll = false;   /**< true se la query corrisponde a tutti i contatti */
+    int m_from = 0;              /**< Primo contatto non ancora scansionato */
+    int m_records = 0;           /**< Contatti presenti nell'indice all'apertura */
+    qsizetype m_found = 0;       /**< Risultati letti finora */
+    quint64 m_generation = 0;    /**< Generazione dell'indice all'apertura */
+    bool m_atEnd = true;         /**< true quando non ci sono altri risultati */
+
+    QString m_cacheKey;          /**< Chiave in cache della query (vuota se non va salvata) */
+    bool m_cacheHit = false;     /**< true se i risultati arrivano dalla cache */
+    QVector<int> m_results;      /**< Risultati in cache, oppure quelli letti finora da salvare */
+};
+
+#endif // SEARCHINDEX_HPP
@@ -0,0 +1,194 @@
+/**
+ * @file searchquery.cpp
+ * @brief SearchQuery class implementation
+ */
+
+#include "searchquery.hpp"
+#include "searchindex.hpp"
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_query_namespace {
+// Valore restituito quando il prefisso non è un campo conosciuto
+constexpr int kNoField = -2;
+
+/**
+ * @brief Parola della query, con la posizione della prima virgoletta
+ */
+struct Token
+{
+    QString text;
+    qsizetype quoteStart = -1; // -1 se la parola non contiene virgolette
+};
+
+/**
+ * @brief Divide la query in parole, rispettando le virgolette
+ *
+ * Le virgolette vengono rimosse: name:"mario rossi" diventa la parola
+ * name:mario rossi, con quoteStart che indica dove iniziava il testo tra virgolette.
+ */
+QVector<Token> tokenize(const QString &text)
+{
+    QVector<Token> tokens;
+    Token current;
+    bool quoted = false;
+    bool hasToken = false;
+
+    for (const QChar c : text) {
+        if (c == QLatin1Char('"')) {
+            if (current.quoteStart < 0)
+                current.quoteStart = current.text.size();
+            quoted = !quoted;
+            hasToken = true;
+            continue;
+        }
+
+        if (c.isSpace() && !quoted) {
+            if (hasToken) {
+                tokens.append(current);
+                current = Token{};
+                hasToken = false;
+            }
+            continue;
+        }
+
+        current.text.append(c);
+        hasToken = true;
+    }
+
+    if (hasToken)
+        tokens.append(current);
+
+    return tokens;
+}
+
+/**
+ * @brief Converte il nome di un campo (italiano o inglese) in SearchIndex::Field
+ */
+int fieldFromName(QStringView name)
+{
+    const auto is = [name](QStringView other) { return name.compare(other, Qt::CaseInsensitive) == 0; };
+
+    if (is(u"name") || is(u"nome"))
+        return SearchIndex::Name;
+    if (is(u"phone") || is(u"tel") || is(u"telefono"))
+        return SearchIndex::Phone;
+    if (is(u"email") || is(u"mail"))
+        return SearchIndex::Email;
+    return kNoField;
+}
+
+/**
+ * @brief Restituisce il campo indicato dalla parola (es. "name:rossi"), se presente
+ * @param[out] valueStart Posizione del valore dopo i due punti
+ */
+int fieldFromToken(const Token &token, qsizetype *valueStart)
+{
+    const qsizetype colon = token.text.indexOf(QLatin1Char(':'));
+    // i due punti tra virgolette fanno parte del testo da cercare
+    if (colon <= 0 || (token.quoteStart >= 0 && colon >= token.quoteStart))
+        return kNoField;
+
+    const int field = fieldFromName(QStringView(token.text).left(colon));
+    if (field != kNoField && valueStart)
+        *valueStart = colon + 1;
+    return field;
+}
+
+/**
+ * @brief Verifica se la parola è un operatore booleano
+ */
+bool isOperator(const Token &token)
+{
+    if (token.quoteStart >= 0)
+        return false;
+    return token.text == QLatin1String("OR") || token.text == QLatin1String("|")
+           || token.text == QLatin1String("AND") || token.text == QLatin1String("&");
+}
+} // namespace m_query_namespace
+
+SearchQuery SearchQuery::parse(const QString &text)
+{
+    using namespace m_query_namespace;
+
+    SearchQuery query;
+    const QVector<Token> tokens = tokenize(text);
+
+    // senza filtri, prefissi né operatori la query è un unico testo su tutti i campi,
+    // spazi compresi, come nella ricerca semplice
+    bool structured = false;
+    for (const Token &token : tokens) {
+        const bool prefix = token.quoteStart != 0 && token.text.startsWith(QLatin1Char('^'));
+        if (prefix || isOperator(token) || fieldFromToken(token, nullptr) != kNoField) {
+            structured = true;
+            break;
+        }
+    }
+
+    if (!structured) {
+        SearchTerm term;
+        term.text = SearchIndex::normalize(text);
+        QVector<SearchTerm> group;
+        if (!term.text.isEmpty())
+            group.append(term);
+        query.m_groups.append(group);
+        return query;
+    }
+
+    QVector<SearchTerm> group;
+    bool groupStarted = false;
+
+    for (const Token &token : tokens) {
+        if (isOperator(token)) {
+            // OR chiude il gruppo corrente, AND è implicito
+            if (token.text == QLatin1String("OR") || token.text == QLatin1String("|")) {
+                if (groupStarted)
+                    query.m_groups.append(group);
+                group.clear();
+                groupStarted = false;
+            }
+            continue;
+        }
+
+        SearchTerm term;
+        qsizetype valueStart = 0;
+        const int field = fieldFromToken(token, &valueStart);
+        if (field != kNoField)
+            term.field = field;
+
+        QStringView value = QStringView(token.text).mid(valueStart);
+        if (value.startsWith(QLatin1Char('^'))) {
+            term.prefix = true;
+            value = value.mid(1);
+        }
+
+        // un termine ancora vuoto (es. "name:" mentre si scrive) non filtra nulla
+        groupStarted = true;
+        term.text = SearchIndex::normalize(value);
+        if (!term.text.isEmpty())
+            group.append(term);
+    }
+
+    if (groupStarted)
+        query.m_groups.append(group);
+
+    return query;
+}
+
+const QVector<QVector<SearchTerm>> &SearchQuery::groups() const
+{
+    return m_groups;
+}
+
+bool SearchQuery::matchesAll() const
+{
+    if (m_groups.isEmpty())
+        return true;
+
+    for (const QVector<SearchTerm> &group : m_groups) {
+        if (group.isEmpty())
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file searchquery.hpp
+ * @brief Linguaggio di ricerca con filtri per campo e operatori booleani
+ *
+ * @details
+ * Oltre al semplice testo, la barra di ricerca accetta query strutturate:
+ * - name:rossi        il nome contiene "rossi"
+ * - phone:^347        il telefono inizia con "347"
+ * - email:@libero.it  l'email contiene "@libero.it"
+ * - ^mar              un campo qualsiasi inizia con "mar"
+ * - termini separati da spazio (o AND) devono essere veri tutti
+ * - OR separa alternative: name:rossi OR name:bianchi
+ * - le virgolette raggruppano testo con spazi: name:"mario rossi"
+ */
+
+#ifndef SEARCHQUERY_HPP
+#define SEARCHQUERY_HPP
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct SearchTerm
+ * @brief Singola condizione di una query
+ */
+struct SearchTerm
+{
+    static constexpr int AnyField = -1; /**< Il termine può comparire in qualsiasi campo */
+
+    int field = AnyField; /**< SearchIndex::Field su cui cercare, oppure AnyField */
+    QByteArray text;      /**< Testo normalizzato (vedi SearchIndex::normalize) */
+    bool prefix = false;  /**< true se il campo deve iniziare con il testo ('^') */
+};
+
+/**
+ * @class SearchQuery
+ * @brief Query di ricerca già analizzata
+ *
+ * @details
+ * La query è un OR di gruppi, ogni gruppo è un AND di termini.
+ * Un testo senza filtri per campo, prefissi né operatori viene trattato come un unico
+ * termine su tutti i campi, esattamente come la ricerca semplice.
+ */
+class SearchQuery
+{
+public:
+    /**
+     * @brief Analizza il testo inserito dall'utente
+     * @param[in] text Testo della query
+     * @return Query pronta per SearchIndex
+     */
+    static SearchQuery parse(const QString &text);
+
+    /**
+     * @brief Gruppi della query (in OR tra loro)
+     * @return Per ogni gruppo, i termini che devono essere veri tutti
+     */
+    const QVector<QVector<SearchTerm>> &groups() const;
+
+    /**
+     * @brief Verifica se la query corrisponde a tutti i contatti
+     * @retval true Nessun termine con testo (query vuota)
+     * @retval false Almeno un termine da verificare
+     */
+    bool matchesAll() const;
+
+private:
+    QVector<QVector<SearchTerm>> m_groups; /**< Gruppi in OR, ogni gruppo è un AND di termini */
+};
+
+#endif // SEARCHQUERY_HPP
@@ -0,0 +1,249 @@
+/**
+ * @file snapshotstress.cpp
+ * @brief Prova di carico degli snapshot della rubrica con lettori concorrenti
+ *
+ * @details
+ * Più thread leggono ContactList::snapshot() in continuazione, come il server di
+ * ricerca, mentre il thread principale (quello della lista) aggiunge, modifica,
+ * rimuove, annulla e ripete. Ogni lettore controlla che lo snapshot sia coerente:
+ * - righe in ordine di nome e tabella degli id allineata alle righe
+ * - chiave compatta di ogni telefono uguale a PhoneNumber::pack
+ * - nessun telefono ripetuto (la prova genera numeri tutti diversi)
+ * - conteggi per iniziale che sommano al numero di contatti
+ * - contenuto invariato mentre lo scrittore va avanti (lo snapshot è immutabile)
+ *
+ * Alla fine un lettore deve vedere la versione finale entro
+ * ContactList::kPublishDelayMs. Stampa modifiche e snapshot controllati, il
+ * tempo medio di una modifica, ed esce con 1 al primo errore.
+ *
+ * Esempio:
+ * @code
+ * RubricaSnapshotStress --readers 4 --duration 10 --contacts 100000
+ * @endcode
+ */
+
+#include "list.hpp"
+#include "phonenumber.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_snapshotstress_namespace {
+
+/**
+ * @brief Stato condiviso tra scrittore e lettori
+ */
+struct Shared
+{
+    std::atomic<bool> stop{false};
+    std::atomic<quint64> checked{0}; /**< Snapshot controllati da tutti i lettori */
+    std::mutex errorMutex;
+    QString error;                   /**< Primo errore trovato */
+
+    void fail(const QString &message)
+    {
+        const std::lock_guard<std::mutex> lock(errorMutex);
+        if (error.isEmpty())
+            error = message;
+        stop = true;
+    }
+};
+
+/**
+ * @brief Nome casuale, con iniziali diverse per distribuire i gruppi
+ */
+QString randomName(std::mt19937 &random)
+{
+    static const QStringList kNames{"Mario", "anna", "Luca", "Élodie", "Giulia", "Zeno", "paolo", "Ugo", "#Ufficio"};
+    static const QStringList kSurnames{"Rossi", "Bianchi", "De Luca", "Verdi", "ferrari", "Russo", "Esposito"};
+    return QString("%1 %2 %3")
+        .arg(kNames[random() % kNames.size()], kSurnames[random() % kSurnames.size()])
+        .arg(random() % 1000);
+}
+
+/**
+ * @brief Telefono mai usato prima nella prova (prefisso 3, poi un contatore)
+ */
+QString nextPhone(quint64 &counter)
+{
+    return QString("3%1").arg(counter++, 9, 10, QChar(u'0'));
+}
+
+/**
+ * @brief Impronta del contenuto, per verificare che lo snapshot non cambi
+ */
+quint64 fingerprint(const ContactStore &store)
+{
+    quint64 value = quint64(store.size());
+    for (qsizetype row = 0; row < store.size(); ++row)
+        value = value * 1099511628211ull + store.id(row) * 31 + store.phoneKeys()[row];
+    return value;
+}
+
+/**
+ * @brief Controlla la coerenza di uno snapshot
+ * @return Descrizione del primo problema, vuota se lo snapshot è coerente
+ */
+QString check(const ContactStore &store)
+{
+    QSet<quint64> phones;
+    phones.reserve(store.size());
+    QString previousKey;
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        const QString key = ContactStore::sortKey(store.name(row));
+        if (row > 0 && key < previousKey)
+            return QString("riga %1 fuori ordine").arg(row);
+        previousKey = key;
+
+        if (store.indexOfId(store.id(row)) != row)
+            return QString("id della riga %1 non allineato").arg(row);
+
+        quint64 packed = 0;
+        const quint64 stored = store.phoneKeys()[row];
+        if (PhoneNumber::pack(store.phone(row), &packed) ? stored != packed : !PhoneNumber::isOverflow(stored))
+            return QString("chiave del telefono della riga %1 errata").arg(row);
+        if (!PhoneNumber::isOverflow(stored)) {
+            if (phones.contains(stored))
+                return QString("telefono %1 ripetuto").arg(store.phone(row));
+            phones.insert(stored);
+        }
+    }
+
+    qsizetype grouped = 0;
+    for (int group = 0; group < ContactStore::kLetterGroups; ++group)
+        grouped += store.letterCount(group);
+    if (grouped != store.size())
+        return QString("conteggi per iniziale: %1 invece di %2").arg(grouped).arg(store.size());
+    return QString();
+}
+
+/**
+ * @brief Legge e controlla snapshot finché lo scrittore non finisce
+ */
+void read(const ContactList *list, Shared *shared)
+{
+    while (!shared->stop) {
+        const ContactList::Snapshot snapshot = list->snapshot();
+        const quint64 before = fingerprint(*snapshot);
+        const QString error = check(*snapshot);
+        if (!error.isEmpty()) {
+            shared->fail(error);
+            return;
+        }
+        // lo scrittore nel frattempo è andato avanti: lo snapshot non deve essersene accorto
+        if (fingerprint(*snapshot) != before) {
+            shared->fail("snapshot modificato mentre era in lettura");
+            return;
+        }
+        shared->checked++;
+    }
+}
+
+} // namespace m_snapshotstress_namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace m_snapshotstress_namespace;
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RubricaSnapshotStress");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Controlla gli snapshot della rubrica letti da più thread durante le modifiche");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"readers", "Thread lettori.", "n", "4"},
+        {"duration", "Durata della prova in secondi.", "s", "5"},
+        {"contacts", "Contatti iniziali.", "n", "20000"},
+    });
+    parser.process(app);
+    const int readers = std::max(1, parser.value("readers").toInt());
+    const qint64 deadline = qint64(std::max(1, parser.value("duration").toInt())) * 1000000000;
+    const int initial = std::max(0, parser.value("contacts").toInt());
+
+    std::mt19937 random(1);
+    quint64 phoneCounter = 0;
+    ContactList list;
+    QVector<Contact> contacts;
+    contacts.reserve(initial);
+    for (int i = 0; i < initial; ++i)
+        contacts.append(Contact(randomName(random), nextPhone(phoneCounter)));
+    list.replaceStore(ContactList::makeStore(std::move(contacts)));
+
+    // i lettori sono registrati come il server di ricerca
+    list.addSnapshotReader();
+    Shared shared;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i)
+        threads.emplace_back(read, &list, &shared);
+
+    QElapsedTimer clock;
+    clock.start();
+    quint64 edits = 0;
+    qint64 editNanos = 0;
+    while (!shared.stop && clock.nsecsElapsed() < deadline) {
+        const qint64 started = clock.nsecsElapsed();
+        const unsigned op = random() % 10;
+        const qsizetype count = qsizetype(list.size());
+        if (op < 4 || count == 0) {
+            list.addContact(Contact(randomName(random), nextPhone(phoneCounter)));
+        } else if (op < 6) {
+            const Contact current = list.at(size_t(random() % count));
+            list.updateById(current.id(), Contact(randomName(random), nextPhone(phoneCounter), current.email()));
+        } else if (op < 8) {
+            list.removeById(list.at(size_t(random() % count)).id());
+        } else if (op < 9) {
+            list.undo();
+        } else {
+            list.redo();
+        }
+        editNanos += clock.nsecsElapsed() - started;
+        edits++;
+
+        // le pubblicazioni raggruppate partono dal ciclo degli eventi
+        if (edits % 16 == 0)
+            QCoreApplication::processEvents();
+    }
+
+    // l'ultima versione deve arrivare ai lettori entro il ritardo di pubblicazione
+    if (!shared.stop) {
+        QElapsedTimer wait;
+        wait.start();
+        while (wait.elapsed() <= 2 * ContactList::kPublishDelayMs)
+            QCoreApplication::processEvents();
+        const qsizetype expected = qsizetype(list.size());
+        qsizetype seen = -1;
+        std::thread([&list, &seen]() { seen = list.snapshot()->size(); }).join();
+        if (seen != expected)
+            shared.fail(QString("l'ultimo snapshot ha %1 contatti invece di %2").arg(seen).arg(expected));
+    }
+
+    shared.stop = true;
+    for (std::thread &thread : threads)
+        thread.join();
+    list.removeSnapshotReader();
+
+    QTextStream out(stdout);
+    out << QString("%1 lettori, %2 modifiche (%3 µs in media), %4 snapshot controllati, %5 contatti finali\n")
+               .arg(readers)
+               .arg(edits)
+               .arg(edits > 0 ? editNanos / 1000.0 / double(edits) : 0.0, 0, 'f', 1)
+               .arg(shared.checked.load())
+               .arg(list.size());
+    if (!shared.error.isEmpty()) {
+        out << "Errore: " << shared.error << "\n";
+        return 1;
+    }
+    out << "Nessun errore\n";
+    return 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file sortorders.cpp
+ * @brief SortOrders class implementation
+ */
+
+#include "sortorders.hpp"
+#include "phonenumber.hpp"
+#include "profiler.hpp"
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_sortorders_namespace {
+
+/**
+ * @brief Chiave di una riga per un criterio: si confronta prima number, poi text
+ */
+struct SortValue
+{
+    quint64 number = 0;
+    QString text;
+};
+
+/**
+ * @brief Chiave di ordinamento di una riga
+ */
+SortValue value(SortOrders::Key key, const ContactStore &store, qsizetype row)
+{
+    SortValue result;
+    switch (key) {
+    case SortOrders::Surname: {
+        // cognome = ultima parola del nome ("Maria De Rossi" -> "rossi")
+        const QString name = store.name(row).trimmed();
+        result.text = ContactStore::sortKey(name.mid(name.lastIndexOf(u' ') + 1));
+        break;
+    }
+    case SortOrders::Phone: {
+        // i numeri conformi in ordine numerico, poi i non conformi come testo
+        const quint64 packed = store.phoneKeys()[row];
+        if (PhoneNumber::isOverflow(packed)) {
+            result.number = std::numeric_limits<quint64>::max();
+            result.text = store.phone(row);
+        } else {
+            result.number = packed;
+        }
+        break;
+    }
+    case SortOrders::Email: {
+        const QString email = store.email(row);
+        result.number = email.isEmpty() ? 1 : 0; // senza email in fondo
+        result.text = email.toCaseFolded();
+        break;
+    }
+    default:
+        break;
+    }
+    return result;
+}
+
+/**
+ * @brief Confronto di due righe; a parità di chiave decide la riga (ordine per nome)
+ */
+bool less(const SortValue &a, int rowA, const SortValue &b, int rowB)
+{
+    return std::tie(a.number, a.text, rowA) < std::tie(b.number, b.text, rowB);
+}
+
+/**
+ * @brief Rinumera una permutazione e ne toglie le righe rimosse
+ * @param[in,out] rows Permutazione
+ * @param[in] newIndex Nuova riga di ogni riga, -1 se rimossa
+ */
+void remap(QVector<int> &rows, const QVector<int> &newIndex)
+{
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        const int row = newIndex[rows[i]];
+        if (row >= 0)
+            rows[kept++] = row;
+    }
+    rows.resize(kept);
+}
+
+} // namespace m_sortorders_namespace
+
+const QVector<int> &SortOrders::order(Key key, const ContactStore &store)
+{
+    Order &order = m_orders[key];
+    if (!order.valid || order.rows.size() != store.size()) {
+        order.rows = build(key, store);
+        order.valid = true;
+        order.rankValid = false;
+    }
+    return order.rows;
+}
+
+const QVector<int> &SortOrders::rank(Key key, const ContactStore &store)
+{
+    const QVector<int> &rows = order(key, store);
+    Order &order = m_orders[key];
+    if (!order.rankValid) {
+        order.rank.resize(rows.size());
+        for (qsizetype i = 0; i < rows.size(); ++i)
+            order.rank[rows[i]] = int(i);
+        order.rankValid = true;
+    }
+    return order.rank;
+}
+
+void SortOrders::reset()
+{
+    for (Order &order : m_orders) {
+        order.valid = false;
+        order.rankValid = false;
+    }
+}
+
+void SortOrders::insertRow(const ContactStore &store, qsizetype row)
+{
+    touch(store, row);
+    for (int key = Surname; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        if (!order.valid)
+            continue;
+        for (int &value : order.rows)
+            value += value >= row ? 1 : 0;
+        if (key == Modified)
+            order.rows.prepend(int(row));
+        else
+            insertSorted(Key(key), store, order.rows, int(row));
+        order.rankValid = false;
+    }
+}
+
+void SortOrders::removeRow(qsizetype row)
+{
+    for (int key = Surname; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        if (!order.valid)
+            continue;
+        qsizetype kept = 0;
+        for (qsizetype i = 0; i < order.rows.size(); ++i) {
+            const int value = order.rows[i];
+            if (value != row)
+                order.rows[kept++] = value > row ? value - 1 : value;
+        }
+        order.rows.resize(kept);
+        order.rankValid = false;
+    }
+}
+
+void SortOrders::updateRow(const ContactStore &store, qsizetype row)
+{
+    touch(store, row);
+    // telefono ed email non cambiano il cognome
+    for (int key = Phone; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        if (!order.valid)
+            continue;
+        order.rows.removeOne(int(row));
+        if (key == Modified)
+            order.rows.prepend(int(row));
+        else
+            insertSorted(Key(key), store, order.rows, int(row));
+        order.rankValid = false;
+    }
+}
+
+void SortOrders::updateRows(const ContactStore &store, const QVector<qsizetype> &rows)
+{
+    if (rows.isEmpty())
+        return;
+    if (rows.size() == 1) {
+        updateRow(store, rows.first());
+        return;
+    }
+
+    // righe distinte; per "Modificati di recente" conta l'ultima modifica di ognuna
+    QVector<bool> changed(store.size(), false);
+    QVector<int> recent;
+    for (auto it = rows.crbegin(); it != rows.crend(); ++it) {
+        if (!changed[*it]) {
+            changed[*it] = true;
+            recent.append(int(*it));
+        }
+    }
+    for (const qsizetype row : rows)
+        touch(store, row);
+
+    const bool rebuild = recent.size() > store.size() / kRebuildFraction;
+    // telefono ed email non cambiano il cognome
+    for (int key = Phone; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        order.rankValid = false;
+        if (!order.valid)
+            continue;
+        if (rebuild && key != Modified) {
+            order.valid = false;
+            continue;
+        }
+        qsizetype kept = 0;
+        for (qsizetype i = 0; i < order.rows.size(); ++i) {
+            const int value = order.rows[i];
+            if (!changed[value])
+                order.rows[kept++] = value;
+        }
+        order.rows.resize(kept);
+        if (key == Modified)
+            order.rows = recent + order.rows;
+        else
+            mergeSorted(Key(key), store, order.rows, recent);
+    }
+}
+
+void SortOrders::insertRows(const ContactStore &store, const QVector<qsizetype> &rows)
+{
+    if (rows.isEmpty())
+        return;
+    for (const qsizetype row : rows)
+        touch(store, row);
+
+    // nuova riga di ogni riga già presente: scorre le righe finali saltando quelle inserite
+    const qsizetype oldSize = store.size() - rows.size();
+    QVector<int> newIndex(oldSize);
+    qsizetype next = 0;
+    qsizetype inserted = 0;
+    for (qsizetype row = 0; row < oldSize; ++row) {
+        while (inserted < rows.size() && rows[inserted] == next) {
+            ++inserted;
+            ++next;
+        }
+        newIndex[row] = int(next++);
+    }
+
+    const bool rebuild = rows.size() > store.size() / kRebuildFraction;
+    for (int key = Surname; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        order.rankValid = false;
+        if (!order.valid)
+            continue;
+        if (rebuild && key != Modified) {
+            order.valid = false;
+            continue;
+        }
+        m_sortorders_namespace::remap(order.rows, newIndex);
+        if (key == Modified) {
+            QVector<int> front;
+            front.reserve(rows.size() + order.rows.size());
+            for (auto it = rows.crbegin(); it != rows.crend(); ++it)
+                front.append(int(*it));
+            front.append(order.rows);
+            order.rows = std::move(front);
+        } else {
+            mergeSorted(Key(key), store, order.rows, QVector<int>(rows.cbegin(), rows.cend()));
+        }
+    }
+}
+
+void SortOrders::removeRows(const QVector<bool> &removed)
+{
+    QVector<int> newIndex(removed.size());
+    int next = 0;
+    for (qsizetype row = 0; row < removed.size(); ++row)
+        newIndex[row] = removed[row] ? -1 : next++;
+    if (next == removed.size())
+        return;
+
+    for (int key = Surname; key < KeyCount; ++key) {
+        Order &order = m_orders[key];
+        if (!order.valid)
+            continue;
+        m_sortorders_namespace::remap(order.rows, newIndex);
+        order.rankValid = false;
+    }
+}
+
+QVector<int> SortOrders::sortRows(Key key, const ContactStore &store, QVector<int> rows)
+{
+    if (key == FirstName) {
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+    const QVector<int> &positions = rank(key, store);
+    std::sort(rows.begin(), rows.end(), [&positions](int a, int b) { return positions[a] < positions[b]; });
+    return rows;
+}
+
+qsizetype SortOrders::memoryUsage() const
+{
+    qsizetype bytes = m_touched.capacity() * qsizetype(sizeof(quint64));
+    for (const Order &order : m_orders)
+        bytes += (order.rows.capacity() + order.rank.capacity()) * qsizetype(sizeof(int));
+    return bytes;
+}
+
+void SortOrders::touch(const ContactStore &store, qsizetype row)
+{
+    m_touched.append(store.id(row));
+    // le ripetizioni non servono più: tengo solo l'ultima modifica di ogni id
+    if (m_touched.size() > 2 * store.size() + 64) {
+        QSet<quint64> seen;
+        QVector<quint64> compact;
+        for (auto it = m_touched.crbegin(); it != m_touched.crend(); ++it) {
+            if (!seen.contains(*it) && store.indexOfId(*it) >= 0) {
+                seen.insert(*it);
+                compact.append(*it);
+            }
+        }
+        std::reverse(compact.begin(), compact.end());
+        m_touched = std::move(compact);
+    }
+}
+
+QVector<int> SortOrders::build(Key key, const ContactStore &store)
+{
+    using namespace m_sortorders_namespace;
+    const Profiler::Scope scope("SortOrders::build");
+    const qsizetype count = store.size();
+    QVector<int> rows;
+    rows.reserve(count);
+
+    if (key == Modified) {
+        // prima i contatti modificati, dal più recente, poi gli altri nell'ordine per nome
+        QVector<bool> placed(count, false);
+        for (auto it = m_touched.crbegin(); it != m_touched.crend(); ++it) {
+            const qsizetype row = store.indexOfId(*it);
+            if (row >= 0 && !placed[row]) {
+                placed[row] = true;
+                rows.append(int(row));
+            }
+        }
+        for (qsizetype row = 0; row < count; ++row) {
+            if (!placed[row])
+                rows.append(int(row));
+        }
+        return rows;
+    }
+
+    // chiavi calcolate una volta sola, poi l'ordinamento confronta solo quelle
+    QVector<SortValue> values(count);
+    for (qsizetype row = 0; row < count; ++row)
+        values[row] = value(key, store, row);
+    rows.resize(count);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::sort(rows.begin(), rows.end(),
+              [&values](int a, int b) { return less(values[a], a, values[b], b); });
+    return rows;
+}
+
+void SortOrders::insertSorted(Key key, const ContactStore &store, QVector<int> &rows, int row)
+{
+    using namespace m_sortorders_namespace;
+    const SortValue inserted = value(key, store, row);
+    const auto position = std::lower_bound(rows.begin(), rows.end(), row, [&](int other, int) {
+        return less(value(key, store, other), other, inserted, row);
+    });
+    rows.insert(position, row);
+}
+
+void SortOrders::mergeSorted(Key key, const ContactStore &store, QVector<int> &rows, const QVector<int> &added)
+{
+    using namespace m_sortorders_namespace;
+    // chiavi delle righe nuove calcolate una volta, poi ordinate tra loro
+    QVector<SortValue> values(added.size());
+    for (qsizetype i = 0; i < added.size(); ++i)
+        values[i] = value(key, store, added[i]);
+    QVector<int> order(added.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return less(values[a], added[a], values[b], added[b]); });
+
+    // ogni riga nuova cerca la sua posizione dopo quella della precedente: una sola copia
+    QVector<int> merged;
+    merged.reserve(rows.size() + added.size());
+    auto from = rows.cbegin();
+    for (const int i : order) {
+        const int row = added[i];
+        const auto position = std::lower_bound(from, rows.cend(), row, [&](int other, int) {
+            return less(value(key, store, other), other, values[i], row);
+        });
+        while (from != position)
+            merged.append(*from++);
+        merged.append(row);
+        from = position;
+    }
+    while (from != rows.cend())
+        merged.append(*from++);
+    rows = std::move(merged);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file sortorders.hpp
+ * @brief Ordinamenti alternativi della rubrica, come permutazioni delle righe
+ *
+ * @details
+ * L'archivio resta ordinato per nome: su quest'ordine si basano ricerca,
+ * inserimento e confronto tra versioni. Gli altri ordinamenti (cognome,
+ * telefono, email, modifiche recenti) sono permutazioni delle righe:
+ * la prima richiesta di un criterio costa un ordinamento O(n log n), poi la
+ * permutazione resta in cache e viene aggiornata a ogni modifica, senza
+ * riordinare. Passare da un criterio all'altro non costa nulla.
+ */
+
+#ifndef SORTORDERS_HPP
+#define SORTORDERS_HPP
+
+#include <QString>
+#include <QVector>
+#include <array>
+#include "contactstore.hpp"
+
+/**
+ * @class SortOrders
+ * @brief Cache delle permutazioni per ogni criterio di ordinamento
+ *
+ * @details
+ * - Una permutazione elenca le righe dell'archivio nell'ordine del criterio;
+ *   a parità di chiave vale l'ordine per nome (l'ordine delle righe)
+ * - Dopo ogni modifica all'archivio va chiamato il metodo corrispondente
+ *   (insertRow, removeRow, ...): inserire o rimuovere una riga costa una
+ *   passata O(n) sugli interi della permutazione più una ricerca binaria
+ * - Le modifiche in blocco più grandi di 1/kRebuildFraction della rubrica
+ *   invalidano la cache: la permutazione viene ricostruita alla richiesta successiva
+ * - "Modificati di recente" mette prima i contatti aggiunti o modificati in questa
+ *   sessione (dal più recente), poi gli altri per nome. Le modifiche sono
+ *   registrate per id, quindi sopravvivono a reset(); non vengono salvate nel file
+ */
+class SortOrders
+{
+public:
+    /**
+     * @brief Criterio di ordinamento
+     */
+    enum Key {
+        FirstName = 0, /**< Nome completo: l'ordine delle righe, nessuna permutazione */
+        Surname,       /**< Ultima parola del nome, poi nome completo */
+        Phone,         /**< Numero (i non conformi dopo gli altri), poi nome */
+        Email,         /**< Email senza maiuscole (le vuote in fondo), poi nome */
+        Modified,      /**< Modifiche di questa sessione, dalla più recente */
+        KeyCount
+    };
+
+    static constexpr qsizetype kRebuildFraction = 8; /**< Oltre n / kRebuildFraction righe si ricostruisce */
+
+    /**
+     * @brief Permutazione delle righe per un criterio
+     * @param[in] key Criterio (diverso da FirstName)
+     * @param[in] store Archivio a cui si riferisce la cache
+     * @return Righe nell'ordine del criterio (costruita se non è in cache)
+     */
+    const QVector<int> &order(Key key, const ContactStore &store);
+
+    /**
+     * @brief Posizione di ogni riga nella permutazione di un criterio
+     * @param[in] key Criterio (diverso da FirstName)
+     * @param[in] store Archivio a cui si riferisce la cache
+     * @return rank[row] = posizione della riga in order(key)
+     * @details Ricostruita in O(n) dopo ogni modifica, solo se richiesta.
+     */
+    const QVector<int> &rank(Key key, const ContactStore &store);
+
+    /**
+     * @brief Verifica se la permutazione di un criterio è in cache
+     */
+    bool isCached(Key key) const { return m_orders[key].valid; }
+
+    /**
+     * @brief Invalida tutte le permutazioni (es. dopo un caricamento o l'annullamento di un'operazione su più righe)
+     */
+    void reset();
+
+    /**
+     * @brief Una riga è stata inserita nell'archivio
+     * @param[in] store Archivio dopo l'inserimento
+     * @param[in] row Riga del nuovo contatto
+     */
+    void insertRow(const ContactStore &store, qsizetype row);
+
+    /**
+     * @brief Una riga è stata rimossa dall'archivio
+     * @param[in] row Riga che aveva il contatto rimosso
+     */
+    void removeRow(qsizetype row);
+
+    /**
+     * @brief Telefono o email di una riga sono cambiati (la riga non si sposta)
+     * @param[in] store Archivio dopo la modifica
+     * @param[in] row Riga modificata
+     */
+    void updateRow(const ContactStore &store, qsizetype row);
+
+    /**
+     * @brief Telefono o email di più righe sono cambiati insieme
+     * @param[in] store Archivio dopo la modifica
+     * @param[in] rows Righe modificate, in qualsiasi ordine (anche ripetute), dalla
+     *                 meno recente: "Modificati di recente" mette prima l'ultima
+     * @details Una passata toglie le righe da ogni permutazione, una fusione le
+     * rimette: O(n + k log n) invece di O(k·n). Oltre n / kRebuildFraction righe
+     * la cache viene invalidata, come in insertRows.
+     */
+    void updateRows(const ContactStore &store, const QVector<qsizetype> &rows);
+
+    /**
+     * @brief Più righe sono state inserite insieme
+     * @param[in] store Archivio dopo l'inserimento
+     * @param[in] rows Righe dei nuovi contatti, crescenti (vedi ContactStore::insertSortedRows)
+     */
+    void insertRows(const ContactStore &store, const QVector<qsizetype> &rows);
+
+    /**
+     * @brief Più righe sono state rimosse insieme
+     * @param[in] removed removed[i] = true se la riga i (prima della rimozione) è stata rimossa
+     */
+    void removeRows(const QVector<bool> &removed);
+
+    /**
+     * @brief Ordina un insieme di righe secondo un criterio
+     * @param[in] key Criterio
+     * @param[in] store Archivio
+     * @param[in] rows Righe in qualsiasi ordine (es. risultati di una ricerca)
+     * @return Le stesse righe nell'ordine del criterio
+     * @details Confronta solo le posizioni nella permutazione (interi): O(k log k).
+     */
+    QVector<int> sortRows(Key key, const ContactStore &store, QVector<int> rows);
+
+    /**
+     * @brief Memoria delle permutazioni e delle modifiche registrate, in byte
+     * @details Conta la capacità dei vettori: le permutazioni invalidate restano
+     * allocate finché non vengono ricostruite.
+     */
+    qsizetype memoryUsage() const;
+
+private:
+    /**
+     * @brief Permutazione in cache di un criterio
+     */
+    struct Order
+    {
+        QVector<int> rows;       /**< Righe nell'ordine del criterio */
+        QVector<int> rank;       /**< Inversa di rows, valida solo se rankValid */
+        bool valid = false;      /**< false se va ricostruita */
+        bool rankValid = false;  /**< false se rank va ricostruita */
+    };
+
+    std::array<Order, KeyCount> m_orders; /**< Una cache per criterio (FirstName non usata) */
+    QVector<quint64> m_touched;           /**< Id aggiunti o modificati, dal meno recente (con ripetizioni) */
+
+    /**
+     * @brief Registra un contatto come modificato ora
+     */
+    void touch(const ContactStore &store, qsizetype row);
+
+    /**
+     * @brief Costruisce la permutazione di un criterio con un ordinamento completo
+     */
+    QVector<int> build(Key key, const ContactStore &store);
+
+    /**
+     * @brief Inserisce una riga nella posizione del criterio (ricerca binaria)
+     */
+    static void insertSorted(Key key, const ContactStore &store, QVector<int> &rows, int row);
+
+    /**
+     * @brief Inserisce più righe nelle posizioni del criterio con una sola fusione
+     * @param[in,out] rows Permutazione senza le righe da inserire
+     * @param[in] added Righe da inserire, in qualsiasi ordine
+     */
+    static void mergeSorted(Key key, const ContactStore &store, QVector<int> &rows, const QVector<int> &added);
+};
+
+#endif // SORTORDERS_HPP
@@ -0,0 +1,73 @@
+/**
+ * @file stringpool.cpp
+ * @brief StringPool class implementation
+ */
+
+#include "stringpool.hpp"
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_pool_namespace {
+// Intestazione del buffer condiviso di una QString (QArrayData) più l'overhead di malloc
+constexpr qsizetype kStringHeaderBytes = 16 + 16;
+// Stima di un nodo della QHash<QString, quint32>: chiave, valore e parte dello span
+constexpr qsizetype kHashNodeBytes = qsizetype(sizeof(QString)) + 8 + 8;
+} // namespace m_pool_namespace
+
+StringPool::StringPool()
+{
+    clear();
+}
+
+quint32 StringPool::intern(QStringView text)
+{
+    if (text.isEmpty())
+        return 0;
+
+    const QString key = text.toString();
+    const auto it = m_ids.constFind(key);
+    if (it != m_ids.constEnd())
+        return it.value();
+
+    const quint32 id = quint32(m_strings.size());
+    m_strings.append(key);
+    m_ids.insert(key, id);
+    return id;
+}
+
+bool StringPool::find(QStringView text, quint32 *id) const
+{
+    if (text.isEmpty()) {
+        *id = 0;
+        return true;
+    }
+
+    const auto it = m_ids.constFind(text.toString());
+    if (it == m_ids.constEnd())
+        return false;
+    *id = it.value();
+    return true;
+}
+
+qsizetype StringPool::memoryUsage() const
+{
+    qsizetype bytes = m_strings.capacity() * qsizetype(sizeof(QString));
+    for (const QString &text : m_strings)
+        bytes += stringBytes(text.size()) - qsizetype(sizeof(QString));
+    return bytes + m_ids.size() * m_pool_namespace::kHashNodeBytes;
+}
+
+void StringPool::clear()
+{
+    m_strings.clear();
+    m_ids.clear();
+    m_strings.append(QString()); // id 0: stringa vuota
+}
+
+qsizetype StringPool::stringBytes(qsizetype length)
+{
+    if (length == 0)
+        return qsizetype(sizeof(QString));
+    return qsizetype(sizeof(QString)) + m_pool_namespace::kStringHeaderBytes + (length + 1) * 2;
+}
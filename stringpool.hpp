@@ -0,0 +1,85 @@
+/**
+ * @file stringpool.hpp
+ * @brief Pool di stringhe condivise (interning)
+ *
+ * @details
+ * Ogni stringa distinta viene memorizzata una sola volta e identificata da un
+ * id a 32 bit: chi la usa conserva solo l'id. Usato da ContactStore per i nomi
+ * e i domini email, che in una rubrica grande si ripetono moltissimo.
+ */
+
+#ifndef STRINGPOOL_HPP
+#define STRINGPOOL_HPP
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class StringPool
+ * @brief Insieme di stringhe distinte indicizzate da id
+ *
+ * @details
+ * - L'id 0 è sempre la stringa vuota
+ * - Gli id restano validi finché il pool non viene svuotato con clear()
+ * - Le stringhe non più usate non vengono rimosse: il pool si ricostruisce
+ *   ricreandolo (vedi ContactStore::setInterning)
+ */
+class StringPool
+{
+public:
+    StringPool();
+
+    /**
+     * @brief Restituisce l'id della stringa, aggiungendola se non è presente
+     * @param[in] text Stringa da aggiungere
+     * @return Id della stringa
+     */
+    quint32 intern(QStringView text);
+
+    /**
+     * @brief Cerca una stringa senza aggiungerla
+     * @param[in] text Stringa da cercare
+     * @param[out] id Id della stringa, se presente
+     * @retval true Stringa presente nel pool
+     * @retval false Stringa assente
+     */
+    bool find(QStringView text, quint32 *id) const;
+
+    /**
+     * @brief Stringa con l'id indicato
+     * @param[in] id Id restituito da intern()
+     * @return Riferimento alla stringa nel pool
+     */
+    const QString &string(quint32 id) const { return m_strings[id]; }
+
+    /**
+     * @brief Numero di stringhe distinte (compresa quella vuota)
+     */
+    qsizetype size() const { return m_strings.size(); }
+
+    /**
+     * @brief Memoria occupata dal pool, stimata in byte
+     * @details Comprende i caratteri, i vettori e la tabella hash degli id.
+     */
+    qsizetype memoryUsage() const;
+
+    /**
+     * @brief Svuota il pool (resta solo la stringa vuota)
+     */
+    void clear();
+
+    /**
+     * @brief Memoria occupata da una QString di length caratteri, stimata in byte
+     * @param[in] length Numero di caratteri
+     * @return sizeof(QString) più l'eventuale buffer dei caratteri
+     */
+    static qsizetype stringBytes(qsizetype length);
+
+private:
+    QVector<QString> m_strings;    /**< Stringhe distinte, indicizzate per id */
+    QHash<QString, quint32> m_ids; /**< Id di ogni stringa (le chiavi condividono i dati con m_strings) */
+};
+
+#endif // STRINGPOOL_HPP
@@ -0,0 +1,226 @@
+/**
+ * @file undolog.cpp
+ * @brief UndoLog class implementation
+ */
+
+#include "undolog.hpp"
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief namespace per funzioni utilizzate UNICAMENTE in questo file.
+ */
+namespace m_undo_namespace {
+/**
+ * @brief Memoria stimata di un contatto salvato nel log
+ * @details I caratteri sono spesso condivisi con l'archivio (implicit sharing):
+ * contarli comunque dà un limite superiore.
+ */
+qsizetype contactBytes(const Contact &contact)
+{
+    const qsizetype header = qsizetype(sizeof(QString));
+    return qsizetype(sizeof(Contact)) + StringPool::stringBytes(contact.name().size())
+           + StringPool::stringBytes(contact.phone().size()) + StringPool::stringBytes(contact.email().size())
+           - 3 * header;
+}
+
+/**
+ * @brief Scrive un campo che non influisce sull'ordine (telefono o email)
+ */
+void setField(ContactStore &store, qsizetype row, ContactStore::Field field, const QString &value)
+{
+    if (field == ContactStore::Phone)
+        store.setPhone(row, value);
+    else
+        store.setEmail(row, value);
+}
+
+/**
+ * @brief Scambia l'archivio con la rubrica salvata, mantenendo la modalità di interning attuale
+ */
+void swapBook(ContactStore &store, ContactStore &book)
+{
+    const bool interning = store.isInterning();
+    std::swap(store, book);
+    // conversione O(n) solo se l'interning è stato cambiato nel frattempo
+    if (store.isInterning() != interning)
+        store.setInterning(interning);
+}
+
+} // namespace m_undo_namespace
+
+UndoLog::UndoLog(qsizetype maxBytes, qsizetype maxSteps)
+    : m_maxBytes(maxBytes)
+    , m_maxSteps(std::max<qsizetype>(1, maxSteps))
+{}
+
+void UndoLog::recordInsert(qsizetype row, Contact contact)
+{
+    const qsizetype bytes = m_undo_namespace::contactBytes(contact);
+    push(InsertRow{row, std::move(contact)}, bytes);
+}
+
+void UndoLog::recordRemove(qsizetype row, Contact contact)
+{
+    const qsizetype bytes = m_undo_namespace::contactBytes(contact);
+    push(RemoveRow{row, std::move(contact)}, bytes);
+}
+
+void UndoLog::recordUpdate(qsizetype fromRow, Contact before, qsizetype toRow, Contact after)
+{
+    const qsizetype bytes = m_undo_namespace::contactBytes(before) + m_undo_namespace::contactBytes(after);
+    push(UpdateRow{fromRow, toRow, std::move(before), std::move(after)}, bytes);
+}
+
+void UndoLog::recordBulk(QVector<FieldChange> changes, QVector<qsizetype> rows, QVector<Contact> contacts,
+                         QVector<qsizetype> insertedRows, QVector<Contact> inserted)
+{
+    qsizetype bytes = (rows.size() + insertedRows.size()) * qsizetype(sizeof(qsizetype));
+    for (const Contact &contact : contacts)
+        bytes += m_undo_namespace::contactBytes(contact);
+    for (const Contact &contact : inserted)
+        bytes += m_undo_namespace::contactBytes(contact);
+    for (const FieldChange &change : changes) {
+        bytes += qsizetype(sizeof(FieldChange)) + StringPool::stringBytes(change.before.size())
+                 + StringPool::stringBytes(change.after.size()) - 2 * qsizetype(sizeof(QString));
+    }
+    push(BulkRows{std::move(changes), std::move(rows), std::move(contacts), std::move(insertedRows),
+                  std::move(inserted)},
+         bytes);
+}
+
+void UndoLog::recordReplace(std::unique_ptr<ContactStore> previous, const ContactStore &current)
+{
+    // il passo contiene a turno la rubrica precedente o quella attuale: conta la più grande
+    const qsizetype bytes = std::max(previous->memoryReport().actualBytes, current.memoryReport().actualBytes);
+    push(ReplaceBook{std::move(previous)}, bytes);
+}
+
+bool UndoLog::undo(ContactStore &store, Delta *delta)
+{
+    if (m_undo.empty())
+        return false;
+
+    const Delta applied = revert(m_undo.back().change, store);
+    if (delta)
+        *delta = applied;
+    m_redo.push_back(std::move(m_undo.back()));
+    m_undo.pop_back();
+    return true;
+}
+
+bool UndoLog::redo(ContactStore &store, Delta *delta)
+{
+    if (m_redo.empty())
+        return false;
+
+    const Delta applied = apply(m_redo.back().change, store);
+    if (delta)
+        *delta = applied;
+    m_undo.push_back(std::move(m_redo.back()));
+    m_redo.pop_back();
+    return true;
+}
+
+void UndoLog::clear()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_bytes = 0;
+}
+
+void UndoLog::push(Change change, qsizetype bytes)
+{
+    // una nuova modifica rende impossibile ripetere quelle annullate
+    for (const Step &step : m_redo)
+        m_bytes -= step.bytes;
+    m_redo.clear();
+
+    bytes += qsizetype(sizeof(Step));
+    m_undo.push_back(Step{std::move(change), bytes});
+    m_bytes += bytes;
+
+    // elimino i passi più vecchi, ma l'ultimo resta sempre annullabile
+    while (m_undo.size() > 1 && (m_bytes > m_maxBytes || qsizetype(m_undo.size()) > m_maxSteps)) {
+        m_bytes -= m_undo.front().bytes;
+        m_undo.pop_front();
+    }
+}
+
+UndoLog::Delta UndoLog::apply(Change &change, ContactStore &store)
+{
+    if (const InsertRow *insert = std::get_if<InsertRow>(&change)) {
+        store.insert(insert->row, insert->contact);
+        return {Delta::Inserted, insert->row, -1, {insert->contact.id()}};
+    } else if (const RemoveRow *remove = std::get_if<RemoveRow>(&change)) {
+        store.remove(remove->row);
+        return {Delta::Removed, remove->row, -1, {remove->contact.id()}};
+    } else if (const UpdateRow *update = std::get_if<UpdateRow>(&change)) {
+        store.remove(update->fromRow);
+        store.insert(update->toRow, update->after);
+        return {Delta::Moved, update->fromRow, update->toRow, {update->after.id()}};
+    } else if (const BulkRows *bulk = std::get_if<BulkRows>(&change)) {
+        for (const FieldChange &field : bulk->changes)
+            m_undo_namespace::setField(store, field.row, field.field, field.after);
+        Delta delta{Delta::Bulk};
+        delta.ids = touchedIds(store, *bulk);
+        if (!bulk->rows.isEmpty()) {
+            QVector<bool> removed(store.size(), false);
+            for (const qsizetype row : bulk->rows)
+                removed[row] = true;
+            store.removeIf(removed);
+        }
+        if (!bulk->insertedRows.isEmpty())
+            store.insertRows(bulk->insertedRows, bulk->inserted);
+        return delta;
+    } else if (ReplaceBook *replace = std::get_if<ReplaceBook>(&change)) {
+        m_undo_namespace::swapBook(store, *replace->book);
+    }
+    return {Delta::Replaced};
+}
+
+QVector<quint64> UndoLog::touchedIds(const ContactStore &store, const BulkRows &bulk)
+{
+    QVector<quint64> ids;
+    ids.reserve(bulk.changes.size() + bulk.contacts.size() + bulk.inserted.size());
+    for (const FieldChange &field : bulk.changes)
+        ids.append(store.id(field.row));
+    for (const Contact &contact : bulk.contacts)
+        ids.append(contact.id());
+    for (const Contact &contact : bulk.inserted)
+        ids.append(contact.id());
+    return ids;
+}
+
+UndoLog::Delta UndoLog::revert(Change &change, ContactStore &store)
+{
+    if (const InsertRow *insert = std::get_if<InsertRow>(&change)) {
+        store.remove(insert->row);
+        return {Delta::Removed, insert->row, -1, {insert->contact.id()}};
+    } else if (const RemoveRow *remove = std::get_if<RemoveRow>(&change)) {
+        store.insert(remove->row, remove->contact);
+        return {Delta::Inserted, remove->row, -1, {remove->contact.id()}};
+    } else if (const UpdateRow *update = std::get_if<UpdateRow>(&change)) {
+        store.remove(update->toRow);
+        store.insert(update->fromRow, update->before);
+        return {Delta::Moved, update->toRow, update->fromRow, {update->before.id()}};
+    } else if (const BulkRows *bulk = std::get_if<BulkRows>(&change)) {
+        if (!bulk->insertedRows.isEmpty()) {
+            QVector<bool> inserted(store.size(), false);
+            for (const qsizetype row : bulk->insertedRows)
+                inserted[row] = true;
+            store.removeIf(inserted);
+        }
+        // prima tornano le righe rimosse, così le righe dei campi cambiati sono di nuovo valide
+        if (!bulk->rows.isEmpty())
+            store.insertRows(bulk->rows, bulk->contacts);
+        for (const FieldChange &field : bulk->changes)
+            m_undo_namespace::setField(store, field.row, field.field, field.before);
+        Delta delta{Delta::Bulk};
+        delta.ids = touchedIds(store, *bulk);
+        return delta;
+    } else if (ReplaceBook *replace = std::get_if<ReplaceBook>(&change)) {
+        m_undo_namespace::swapBook(store, *replace->book);
+    }
+    return {Delta::Replaced};
+}
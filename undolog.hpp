@@ -0,0 +1,262 @@
+/**
+ * @file undolog.hpp
+ * @brief Annulla/ripeti delle modifiche alla rubrica
+ *
+ * @details
+ * Per ogni modifica viene salvata solo la differenza (la riga inserita, rimossa
+ * o cambiata con la sua posizione), non una copia della rubrica. Annullare o
+ * ripetere una modifica rimette le righe nelle posizioni salvate: nessuna
+ * ricerca, nessun ordinamento.
+ */
+
+#ifndef UNDOLOG_HPP
+#define UNDOLOG_HPP
+
+#include <QString>
+#include <QVector>
+#include <deque>
+#include <memory>
+#include <variant>
+#include <vector>
+#include "contactstore.hpp"
+#include "contatto.hpp"
+
+/**
+ * @class UndoLog
+ * @brief Pile di annullamento e ripetizione delle modifiche a un ContactStore
+ *
+ * @details
+ * - Inserimento, rimozione e modifica salvano una o due righe con la loro posizione
+ * - Le operazioni su più contatti (unione dei duplicati, rimozione o modifica di
+ *   una selezione, ricaricamento del file) salvano i campi cambiati e le righe
+ *   rimosse e inserite: si annullano in un passo
+ * - La sostituzione della rubrica (caricamento da file) conserva la rubrica
+ *   precedente spostandola, senza copiarla: annullare e ripetere sono uno scambio O(1)
+ *
+ * La memoria è limitata: superato maxBytes o maxSteps i passi più vecchi vengono
+ * eliminati. L'ultimo passo resta sempre annullabile, anche se da solo supera il limite.
+ *
+ * I contatti salvati conservano il loro id (vedi Contact::id): annullando una
+ * rimozione o ripetendo un inserimento il contatto torna con lo stesso id.
+ *
+ * Le posizioni salvate sono valide solo se l'archivio viene modificato
+ * esclusivamente attraverso operazioni registrate nel log.
+ */
+class UndoLog
+{
+public:
+    static constexpr qsizetype kDefaultMaxBytes = 32 * 1024 * 1024; /**< Memoria massima predefinita */
+    static constexpr qsizetype kDefaultMaxSteps = 200;               /**< Passi massimi predefiniti */
+
+    /**
+     * @brief Campo cambiato da un'operazione su più contatti
+     */
+    struct FieldChange
+    {
+        qsizetype row = 0;                               /**< Riga prima delle eventuali rimozioni */
+        ContactStore::Field field = ContactStore::Email; /**< Campo cambiato (Phone o Email) */
+        QString before;                                  /**< Valore precedente */
+        QString after;                                   /**< Valore nuovo */
+    };
+
+    /**
+     * @brief Righe toccate da un annulla o ripeti, per aggiornare le strutture derivate
+     * (es. SortOrders) senza ricostruirle
+     */
+    struct Delta
+    {
+        enum Kind {
+            Inserted, /**< Una riga inserita in row */
+            Removed,  /**< Una riga rimossa da row */
+            Moved,    /**< Una riga rimossa da row e reinserita in toRow */
+            Bulk,     /**< Più righe (vedi ids): le permutazioni vanno ricostruite */
+            Replaced  /**< Tutta la rubrica sostituita */
+        };
+        Kind kind = Replaced;
+        qsizetype row = -1;   /**< Riga inserita, rimossa o di partenza */
+        qsizetype toRow = -1; /**< Riga di arrivo (solo Moved) */
+        QVector<quint64> ids; /**< Id dei contatti toccati (vuoto per Replaced) */
+    };
+
+    /**
+     * @brief Costruttore
+     * @param[in] maxBytes Memoria massima stimata dei passi salvati
+     * @param[in] maxSteps Numero massimo di passi salvati (annullabili più ripetibili)
+     */
+    explicit UndoLog(qsizetype maxBytes = kDefaultMaxBytes, qsizetype maxSteps = kDefaultMaxSteps);
+
+    /**
+     * @brief Registra un contatto inserito
+     * @param[in] row Posizione in cui è stato inserito
+     * @param[in] contact Contatto inserito
+     * @note Come ogni registrazione, svuota la pila dei passi da ripetere
+     */
+    void recordInsert(qsizetype row, Contact contact);
+
+    /**
+     * @brief Registra un contatto rimosso
+     * @param[in] row Posizione da cui è stato rimosso
+     * @param[in] contact Contatto rimosso
+     */
+    void recordRemove(qsizetype row, Contact contact);
+
+    /**
+     * @brief Registra un contatto modificato (ed eventualmente spostato dall'ordinamento)
+     * @param[in] fromRow Posizione prima della modifica
+     * @param[in] before Contatto prima della modifica
+     * @param[in] toRow Posizione dopo la modifica
+     * @param[in] after Contatto dopo la modifica
+     */
+    void recordUpdate(qsizetype fromRow, Contact before, qsizetype toRow, Contact after);
+
+    /**
+     * @brief Registra un'operazione su più contatti come un solo passo
+     * @param[in] changes Campi cambiati, con le righe precedenti alla rimozione
+     * @param[in] rows Righe rimosse, crescenti (vuoto se non ne sono state rimosse)
+     * @param[in] contacts Contatti rimossi, uno per riga
+     * @param[in] insertedRows Righe inserite dopo la rimozione, crescenti (posizioni finali)
+     * @param[in] inserted Contatti inseriti (con il loro id), uno per riga
+     * @details Riapplicando il passo prima si cambiano i campi, poi si rimuovono le righe,
+     * infine si inseriscono le nuove; annullandolo si procede al contrario.
+     */
+    void recordBulk(QVector<FieldChange> changes, QVector<qsizetype> rows, QVector<Contact> contacts,
+                    QVector<qsizetype> insertedRows = {}, QVector<Contact> inserted = {});
+
+    /**
+     * @brief Registra la sostituzione dell'intera rubrica
+     * @param[in] previous Rubrica precedente (spostata nel log)
+     * @param[in] current Rubrica attuale, usata solo per stimarne la memoria
+     */
+    void recordReplace(std::unique_ptr<ContactStore> previous, const ContactStore &current);
+
+    /**
+     * @brief Annulla l'ultimo passo
+     * @param[in,out] store Archivio a cui applicare il passo
+     * @param[out] delta Se non nullo, riceve le righe toccate
+     * @retval true Passo annullato
+     * @retval false Niente da annullare
+     */
+    bool undo(ContactStore &store, Delta *delta = nullptr);
+
+    /**
+     * @brief Ripete l'ultimo passo annullato
+     * @param[in,out] store Archivio a cui applicare il passo
+     * @param[out] delta Se non nullo, riceve le righe toccate
+     * @retval true Passo ripetuto
+     * @retval false Niente da ripetere
+     */
+    bool redo(ContactStore &store, Delta *delta = nullptr);
+
+    /**
+     * @brief Verifica se c'è un passo da annullare
+     */
+    bool canUndo() const { return !m_undo.empty(); }
+
+    /**
+     * @brief Verifica se c'è un passo da ripetere
+     */
+    bool canRedo() const { return !m_redo.empty(); }
+
+    /**
+     * @brief Memoria stimata dei passi salvati, in byte
+     */
+    qsizetype memoryUsage() const { return m_bytes; }
+
+    /**
+     * @brief Elimina tutti i passi salvati
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Riga inserita
+     */
+    struct InsertRow
+    {
+        qsizetype row;
+        Contact contact;
+    };
+
+    /**
+     * @brief Riga rimossa
+     */
+    struct RemoveRow
+    {
+        qsizetype row;
+        Contact contact;
+    };
+
+    /**
+     * @brief Riga modificata, spostata da fromRow a toRow
+     */
+    struct UpdateRow
+    {
+        qsizetype fromRow;
+        qsizetype toRow;
+        Contact before;
+        Contact after;
+    };
+
+    /**
+     * @brief Operazione su più contatti: campi cambiati, righe rimosse e righe inserite
+     */
+    struct BulkRows
+    {
+        QVector<FieldChange> changes;
+        QVector<qsizetype> rows;
+        QVector<Contact> contacts;
+        QVector<qsizetype> insertedRows;
+        QVector<Contact> inserted;
+    };
+
+    /**
+     * @brief Rubrica sostituita: contiene l'altra versione, scambiata a ogni annulla/ripeti
+     */
+    struct ReplaceBook
+    {
+        std::unique_ptr<ContactStore> book;
+    };
+
+    using Change = std::variant<InsertRow, RemoveRow, UpdateRow, BulkRows, ReplaceBook>;
+
+    /**
+     * @brief Passo salvato con la sua memoria stimata
+     */
+    struct Step
+    {
+        Change change;
+        qsizetype bytes;
+    };
+
+    std::deque<Step> m_undo;  /**< Passi da annullare, il più recente in fondo */
+    std::vector<Step> m_redo; /**< Passi da ripetere, il più recente in fondo */
+    qsizetype m_bytes = 0;    /**< Memoria stimata di tutti i passi */
+    qsizetype m_maxBytes;     /**< Limite di memoria */
+    qsizetype m_maxSteps;     /**< Limite di passi */
+
+    /**
+     * @brief Aggiunge un passo da annullare, svuota i passi da ripetere e applica i limiti
+     */
+    void push(Change change, qsizetype bytes);
+
+    /**
+     * @brief Riapplica la modifica all'archivio
+     * @return Righe toccate
+     */
+    static Delta apply(Change &change, ContactStore &store);
+
+    /**
+     * @brief Annulla la modifica sull'archivio
+     * @return Righe toccate
+     */
+    static Delta revert(Change &change, ContactStore &store);
+
+    /**
+     * @brief Id dei contatti toccati da un passo multiplo
+     * @details Da chiamare quando le righe dei campi cambiati sono valide: prima delle
+     * rimozioni (ripeti) o dopo averle annullate.
+     */
+    static QVector<quint64> touchedIds(const ContactStore &store, const BulkRows &bulk);
+};
+
+#endif // UNDOLOG_HPP